@@ -1,3 +0,0 @@
-gcc -g deserialize.c -o deserialize
-gcc -g parse_user.c -o parse_user
-gcc -g parse_env.c -o parse_env
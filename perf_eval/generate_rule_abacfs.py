@@ -7,7 +7,7 @@ from pathlib import Path
 """
 Does the following things
 1. Build object specific rule lists, map them to corresponding object paths and serialize the mapping
-2. Serialize user attributes and current environmental attributes
+2. Serialize object, user and current environmental attributes
 3. Writes serialized data to 'data/original' directory
 4. Repeats steps 1-2 but encodes the data and saves them in 'data/encoded' directory
 """
@@ -52,7 +52,7 @@ def build_rule_map(obj_attr_map, policy):
         rule_map[path] = rule_str
     return rule_map
 
-def save(rule_map, user_attr_map, current_env_attrs, policy, config_name, enc=False):
+def save(rule_map, obj_attr_map, user_attr_map, current_env_attrs, policy, config_name, enc=False):
     directory = f'data/{config_name}/rules/original'
     if enc:
         directory = f'data/{config_name}/rules/encoded'
@@ -65,6 +65,14 @@ def save(rule_map, user_attr_map, current_env_attrs, policy, config_name, enc=Fa
     with open(f'{directory}/obj_rules', 'w') as f:
         f.write(data)
 
+    # save object attribute mapping, the index engines derive the rule lists from it
+    data = ""
+    for path, attrs in obj_attr_map.items():
+        data += f"{path}:" + ",".join(f"{name}={value}" for name, value in attrs.items()) + "\n"
+    data = data[:-1]
+    with open(f'{directory}/obj_attrs', 'w') as f:
+        f.write(data)
+
     # save user attribute mapping
     data = ""
     for uid, attrs in user_attr_map.items():
@@ -86,7 +94,7 @@ def save(rule_map, user_attr_map, current_env_attrs, policy, config_name, enc=Fa
     # save policy
     data = f"{len(policy)}\n"
     for rule in policy:
-        # Write user, env attrs and operation
+        # Write user, env attrs, operation and obj attrs
         data += f"{rule['id']}:"
         for name, value in rule['user'].items():
             data += f"{name}={value},"
@@ -95,6 +103,8 @@ def save(rule_map, user_attr_map, current_env_attrs, policy, config_name, enc=Fa
             data += f"{name}={value},"
         data = data[:-1] + '|'
         data += rule['op']
+        if rule['obj']:
+            data += '|' + ",".join(f"{name}={value}" for name, value in rule['obj'].items())
         data += '\n'
     with open(f'{directory}/policy', 'w') as f:
         f.write(data)
@@ -118,7 +128,7 @@ def main(data_fname):
     # Build tree using original data
     print("Building rule map...")
     rule_map = build_rule_map(data['obj'], data['policy'])
-    save(rule_map, data['user'], data['current_env'], data['policy'], config_name)
+    save(rule_map, data['obj'], data['user'], data['current_env'], data['policy'], config_name)
     print(f"Data written to data/{config_name}/rules/original/\n")
 
     # Encode data
@@ -126,7 +136,7 @@ def main(data_fname):
     umap, omap, emap, ce_attrs, _policy = encode_data(data['user'], data['obj'], data['env'], data['current_env'], data['policy'])
     print("Building rule map...")
     rule_map = build_rule_map(omap, _policy)
-    save(rule_map, umap, ce_attrs, _policy, config_name, enc=True)
+    save(rule_map, omap, umap, ce_attrs, _policy, config_name, enc=True)
     print(f"Data written to data/{config_name}/rules/encoded/\n")
     print(f"Objects with rules: {int(found/2)}")
     print(f"Objects with more than one rule: {int(more_than_one/2)}")
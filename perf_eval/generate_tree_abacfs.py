@@ -1,7 +1,7 @@
 import sys
 import json
 from pprint import pprint
-from tree import build_attr_tree, serialize
+from tree import build_attr_tree, build_weighted_attr_tree, serialize
 from encode import encode_data
 from pathlib import Path
 
@@ -11,8 +11,29 @@ Does the following things
 2. Serialize user attributes and current environmental attributes
 3. Writes serialized data to 'data/original' directory
 4. Repeats steps 1-2 but encodes the data and saves them in 'data/encoded' directory
+
+If an access trace read from /sys/kernel/security/abac/trace is given, trees are ordered to
+minimise the traversal cost of the traced requests instead of using attribute entropy only.
 """
 
+def load_trace(trace_fname):
+    """
+    Parse a kernel access trace into a dictionary of object paths mapped to (uid, count) pairs
+    Each line of the trace has the format <uid>:<path>:<op>:<count>
+    Both operations walk the same tree, so their counts are added up
+    """
+    trace = {}
+    with open(trace_fname) as f:
+        for line in f:
+            line = line.strip()
+            if len(line) == 0:
+                continue
+            uid, rest = line.split(":", 1)
+            path, op, count = rest.rsplit(":", 2)
+            requests = trace.setdefault(path, {})
+            requests[uid] = requests.get(uid, 0) + int(count)
+    return {path: list(requests.items()) for path, requests in trace.items()}
+
 def get_covering_rules(obj_attrs, policy):
     """
     Get rules in @policy that cover an object with attributes @obj_attrs
@@ -32,9 +53,10 @@ def get_covering_rules(obj_attrs, policy):
         r.append(rule)
     return r
 
-def build_tree_map(user_attr_map, obj_attr_map, env_attr_map, policy):
+def build_tree_map(user_attr_map, obj_attr_map, env_attr_map, policy, current_env=None, trace=None):
     """
     Build a dictionary of object paths mapped to serialized version of their NPolTrees
+    If @trace is given, objects with traced accesses get trees weighted by those accesses
     """
     tree_map = {}
     for path, obj_attrs in obj_attr_map.items():
@@ -53,7 +75,10 @@ def build_tree_map(user_attr_map, obj_attr_map, env_attr_map, policy):
             for attr, value in r["env"].items():
                 if attr not in attributes:
                     attributes.append(attr)
-        tree = build_attr_tree(attributes, rules, user_attr_map, env_attr_map)
+        if trace and path in trace:
+            tree = build_weighted_attr_tree(attributes, rules, user_attr_map, env_attr_map, current_env, trace[path])
+        else:
+            tree = build_attr_tree(attributes, rules, user_attr_map, env_attr_map)
         tree_map[path] = tree
     return tree_map
 
@@ -88,11 +113,15 @@ def save(trees, user_attr_map, current_env_attrs, config_name, enc=False):
     with open(f'{directory}/env_attr', 'w') as f:
         f.write(data)
 
-def main(data_fname):
+def main(data_fname, trace_fname=None):
     with open(data_fname) as f:
         data = json.load(f)
         print(f"Loaded data from {data_fname}")
     config_name = data['config']
+    trace = None
+    if trace_fname:
+        trace = load_trace(trace_fname)
+        print(f"Loaded access trace for {len(trace)} objects from {trace_fname}")
 
     # Create necessary directories
     Path(f"./data/{config_name}/trees/original/").mkdir(parents=True, exist_ok=True)
@@ -101,7 +130,7 @@ def main(data_fname):
 
     # Build tree using original data
     print("Building trees...")
-    tree_map = build_tree_map(data['user'], data['obj'], data['env'], data['policy'])
+    tree_map = build_tree_map(data['user'], data['obj'], data['env'], data['policy'], data['current_env'], trace)
     save(tree_map, data['user'], data['current_env'], config_name)
     print(f"Data written to data/{config_name}/trees/original/\n")
 
@@ -109,12 +138,12 @@ def main(data_fname):
     print("Encoding data...")
     umap, omap, emap, ce_attrs, _policy = encode_data(data['user'], data['obj'], data['env'], data['current_env'], data['policy'])
     print("Building trees...")
-    tree_map = build_tree_map(umap, omap, emap, _policy)
+    tree_map = build_tree_map(umap, omap, emap, _policy, ce_attrs, trace)
     save(tree_map, umap, ce_attrs, config_name, enc=True)
     print(f"Data written to data/{config_name}/trees/encoded/\n")
 
 if __name__ == "__main__":
-    if len(sys.argv) != 2:
-        print(f"Invalid usage\npython3 {sys.argv[0]} <data_json>")
+    if len(sys.argv) not in [2, 3]:
+        print(f"Invalid usage\npython3 {sys.argv[0]} <data_json> [access_trace]")
         sys.exit(-1)
-    main(sys.argv[1])
+    main(*sys.argv[1:])
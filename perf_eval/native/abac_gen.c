@@ -0,0 +1,700 @@
+/*
+ * Native dataset generator for large configurations
+ *
+ * Takes an individual config (see generate_configs.py) and writes everything
+ * generate_raw.py, generate_rule_abacfs.py and generate_tree_abacfs.py produce:
+ *
+ *	data/<config>/raw.json
+ *	data/<config>/rules/{original,encoded}/{obj_rules,obj_attrs,user_attr,env_attr,policy}
+ *	data/<config>/trees/{original,encoded}/{obj_attr,user_attr,env_attr}
+ *
+ * The policy, users and environmental states are generated up front with the same
+ * scheme as generate_raw.py. Objects are never held in memory: the attributes of
+ * object i are derived from a random stream seeded by i, so chunks of objects are
+ * generated, matched against the policy and written out by a pool of threads.
+ * Objects with the same covering rules share a tree, which is built once.
+ *
+ * Attribute names and values are encoded by formula instead of a lookup table. All
+ * names are interned up front in the order
+ *
+ *	ua_<j>, ua_<j>_v_<k>, oa_<j>, oa_<j>_v_<k>, ea_<j>, ea_<j>_v_<k>
+ *
+ * and the encoded form of a string is its position in this sequence plus one.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "json.h"
+#include "poltree.h"
+#include "pool.h"
+
+#define CHUNK_OBJS 4096
+#define MEMO_BUCKETS (1 << 16)
+
+/* Random streams, each entity gets its own so objects can be generated in any order */
+enum {
+	STREAM_RULE = 1,
+	STREAM_SHUFFLE,
+	STREAM_USER,
+	STREAM_OBJ,
+};
+
+struct rng {
+	uint64_t s;
+};
+
+/* splitmix64 */
+static uint64_t rng_next(struct rng *r)
+{
+	uint64_t z = (r->s += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static void rng_seed(struct rng *r, uint64_t seed, uint64_t stream, uint64_t index)
+{
+	r->s = seed ^ (stream << 56) ^ index;
+	rng_next(r);
+}
+
+/* Uniform in [lo, hi), like random.randrange() */
+static uint32_t rng_range(struct rng *r, uint32_t lo, uint32_t hi)
+{
+	return lo + rng_next(r) % (hi - lo);
+}
+
+struct entity_config {
+	uint32_t count;
+	uint32_t attrs;
+	uint32_t values_per_attr;
+	/* Ids of the first name and first value of this kind in the string table */
+	uint32_t name_base;
+	uint32_t value_base;
+};
+
+struct memo_entry {
+	uint64_t hash;
+	uint32_t *rules;
+	uint32_t nrules;
+	char *orig;
+	char *enc;
+	struct memo_entry *next;
+};
+
+/* Serialized trees shared by all objects with the same covering rules */
+struct memo {
+	struct memo_entry **buckets;
+	pthread_rwlock_t lock;
+	uint64_t trees;
+	uint64_t hits;
+};
+
+struct slot {
+	struct sbuf raw;
+	struct sbuf attrs_orig;
+	struct sbuf attrs_enc;
+	struct sbuf rules;
+	struct sbuf tree_orig;
+	struct sbuf tree_enc;
+};
+
+struct generator {
+	char *name;
+	uint64_t seed;
+	struct entity_config user;
+	struct entity_config obj;
+	struct entity_config env;
+	uint32_t npolicy;
+	uint32_t *policy_idx;
+	struct dataset d;
+	struct memo memo;
+
+	struct slot *slots;
+	FILE *f_raw;
+	FILE *f_rules_orig;
+	FILE *f_rules_enc;
+	FILE *f_attrs_orig;
+	FILE *f_attrs_enc;
+	FILE *f_trees_orig;
+	FILE *f_trees_enc;
+	uint32_t raw_written;
+	uint32_t rules_written;
+	uint64_t found;
+	uint64_t more_than_one;
+	uint64_t not_found;
+};
+
+static uint32_t config_uint(const struct json_value *section, const char *key)
+{
+	double v = json_need(section, key, JSON_NUMBER)->number;
+
+	if (v < 0 || v > UINT32_MAX)
+		die("invalid config: '%s' out of range", key);
+	return (uint32_t)v;
+}
+
+static void load_config(struct generator *g, const char *fname)
+{
+	struct json_value *root, *s;
+	struct json_doc doc;
+	size_t len, err;
+	char *buf;
+
+	buf = read_file(fname, &len);
+	err = json_parse(buf, len, &doc);
+	if (err)
+		die("%s: invalid JSON near offset %zu", fname, err - 1);
+	root = doc.root;
+	g->name = xstrdup(json_need(root, "name", JSON_STRING)->string);
+	s = json_need(root, "user", JSON_OBJECT);
+	g->user.count = config_uint(s, "count");
+	g->user.attrs = config_uint(s, "attrs");
+	g->user.values_per_attr = config_uint(s, "values_per_attr");
+	s = json_need(root, "obj", JSON_OBJECT);
+	g->obj.count = config_uint(s, "count");
+	g->obj.attrs = config_uint(s, "attrs");
+	g->obj.values_per_attr = config_uint(s, "values_per_attr");
+	s = json_need(root, "env", JSON_OBJECT);
+	g->env.attrs = config_uint(s, "attrs");
+	g->env.values_per_attr = config_uint(s, "values_per_attr");
+	g->npolicy = config_uint(json_need(root, "policy", JSON_OBJECT), "count");
+	json_free(&doc);
+	free(buf);
+
+	if (g->npolicy == 0)
+		die("invalid config: the policy needs at least one rule");
+	/* generate_policy() draws from randrange(attrs * 0.25, attrs) */
+	if (g->user.attrs == 0 || g->obj.attrs == 0)
+		die("invalid config: users and objects need at least one attribute");
+}
+
+static void intern_kind(struct generator *g, struct entity_config *c, const char *prefix)
+{
+	char s[64];
+	uint32_t j, k;
+
+	c->name_base = g->d.strs.count;
+	for (j = 0; j < c->attrs; j++) {
+		snprintf(s, sizeof(s), "%s_%u", prefix, j);
+		strtab_intern(&g->d.strs, s);
+	}
+	c->value_base = g->d.strs.count;
+	for (j = 0; j < c->attrs; j++) {
+		for (k = 0; k < c->values_per_attr; k++) {
+			snprintf(s, sizeof(s), "%s_%u_v_%u", prefix, j, k);
+			strtab_intern(&g->d.strs, s);
+		}
+	}
+}
+
+/* Random pairs for the first @n attributes of a kind, env rules use all of them */
+static void random_avps(struct rng *r, const struct entity_config *c, uint32_t n,
+			struct avp_list *l)
+{
+	uint32_t j;
+
+	l->n = n;
+	l->avps = xmalloc(n * sizeof(*l->avps));
+	for (j = 0; j < n; j++) {
+		l->avps[j].attr = c->name_base + j;
+		l->avps[j].value = c->value_base + j * c->values_per_attr +
+				   rng_range(r, 0, c->values_per_attr);
+	}
+}
+
+static int avp_list_equal(const struct avp_list *a, const struct avp_list *b)
+{
+	return a->n == b->n && !memcmp(a->avps, b->avps, a->n * sizeof(*a->avps));
+}
+
+/* See generate_policy() */
+static void generate_policy(struct generator *g)
+{
+	struct dataset *d = &g->d;
+	uint32_t min_user = g->user.attrs / 4, min_obj = g->obj.attrs / 4;
+	struct rng r;
+	uint32_t i, j, tmp;
+
+	d->nrules = g->npolicy;
+	d->rules = xcalloc(d->nrules, sizeof(*d->rules));
+	for (i = 0; i < d->nrules; i++) {
+		struct rule *rule = &d->rules[i];
+
+		rng_seed(&r, g->seed, STREAM_RULE, i);
+		rule->id = i;
+		rule->op = rng_range(&r, 0, 2) ? "READ" : "MODIFY";
+		random_avps(&r, &g->user, rng_range(&r, min_user, g->user.attrs), &rule->user);
+		random_avps(&r, &g->obj, rng_range(&r, min_obj, g->obj.attrs), &rule->obj);
+		random_avps(&r, &g->env, g->env.attrs, &rule->env);
+	}
+
+	/* Environmental states are the distinct env parts of the rules */
+	d->envs = xcalloc(d->nrules, sizeof(*d->envs));
+	for (i = 0; i < d->nrules; i++) {
+		for (j = 0; j < d->nenvs; j++)
+			if (avp_list_equal(&d->envs[j], &d->rules[i].env))
+				break;
+		if (j < d->nenvs)
+			continue;
+		d->envs[d->nenvs].n = d->rules[i].env.n;
+		d->envs[d->nenvs].avps = xmalloc(d->rules[i].env.n * sizeof(struct avp));
+		memcpy(d->envs[d->nenvs].avps, d->rules[i].env.avps,
+		       d->rules[i].env.n * sizeof(struct avp));
+		d->nenvs++;
+	}
+	d->current_env.n = d->envs[0].n;
+	d->current_env.avps = xmalloc(d->envs[0].n * sizeof(struct avp));
+	memcpy(d->current_env.avps, d->envs[0].avps, d->envs[0].n * sizeof(struct avp));
+
+	g->policy_idx = xmalloc(d->nrules * sizeof(*g->policy_idx));
+	for (i = 0; i < d->nrules; i++)
+		g->policy_idx[i] = i;
+	rng_seed(&r, g->seed, STREAM_SHUFFLE, 0);
+	for (i = d->nrules - 1; i > 0; i--) {
+		j = rng_range(&r, 0, i + 1);
+		tmp = g->policy_idx[i];
+		g->policy_idx[i] = g->policy_idx[j];
+		g->policy_idx[j] = tmp;
+	}
+}
+
+/* Rule entity @i of @count takes its attributes from, see generate_mapping() */
+static const struct rule *source_rule(const struct generator *g, uint32_t i, uint32_t count)
+{
+	uint32_t ratio;
+
+	if (count <= g->npolicy)
+		return &g->d.rules[g->policy_idx[i]];
+	ratio = count / g->npolicy;
+	if (i < ratio * g->npolicy)
+		return &g->d.rules[g->policy_idx[i / ratio]];
+	return &g->d.rules[g->policy_idx[i - ratio * g->npolicy]];
+}
+
+/*
+ * Keep a random subset of the pairs an entity inherited from its rule, at least one
+ * pair is dropped when there is more than one, like generate_mapping()
+ */
+static void entity_avps(struct rng *r, const struct avp_list *from, struct avp_list *l)
+{
+	uint32_t keep, j, k;
+	struct avp tmp;
+
+	if (from->n > 1)
+		keep = rng_range(r, 1, from->n);
+	else
+		keep = from->n;
+	memcpy(l->avps, from->avps, from->n * sizeof(*l->avps));
+	for (j = 0; j < keep; j++) {
+		k = rng_range(r, j, from->n);
+		tmp = l->avps[j];
+		l->avps[j] = l->avps[k];
+		l->avps[k] = tmp;
+	}
+	l->n = keep;
+}
+
+static void generate_users(struct generator *g)
+{
+	struct dataset *d = &g->d;
+	const struct rule *rule;
+	struct rng r;
+	char uid[16];
+	uint32_t i;
+
+	d->nusers = g->user.count;
+	d->users = xcalloc(d->nusers, sizeof(*d->users));
+	for (i = 0; i < d->nusers; i++) {
+		snprintf(uid, sizeof(uid), "%u", 1000 + i);
+		d->users[i].uid = xstrdup(uid);
+		rule = source_rule(g, i, g->user.count);
+		d->users[i].attrs.avps = xmalloc(rule->user.n * sizeof(struct avp));
+		rng_seed(&r, g->seed, STREAM_USER, i);
+		entity_avps(&r, &rule->user, &d->users[i].attrs);
+	}
+}
+
+static void json_avps(struct sbuf *sb, const struct dataset *d, const struct avp_list *l)
+{
+	uint32_t i;
+
+	sbuf_putc(sb, '{');
+	for (i = 0; i < l->n; i++)
+		sbuf_printf(sb, "%s\"%s\": \"%s\"", i ? ", " : "",
+			    d->strs.strs[l->avps[i].attr], d->strs.strs[l->avps[i].value]);
+	sbuf_putc(sb, '}');
+}
+
+static uint64_t hash_rules(const uint32_t *rules, uint32_t n)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		h ^= rules[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h ^ n;
+}
+
+static struct memo_entry *memo_find(struct memo *m, uint64_t hash, const uint32_t *rules,
+				    uint32_t n)
+{
+	struct memo_entry *e;
+
+	for (e = m->buckets[hash & (MEMO_BUCKETS - 1)]; e; e = e->next)
+		if (e->hash == hash && e->nrules == n &&
+		    !memcmp(e->rules, rules, n * sizeof(*rules)))
+			return e;
+	return NULL;
+}
+
+struct worker_state {
+	struct tree_builder b;
+	struct tree t;
+	uint32_t *rules;
+	struct avp_list attrs;
+	struct sbuf orig;
+	struct sbuf enc;
+};
+
+static void *worker_init(void *ctx)
+{
+	struct generator *g = ctx;
+	struct worker_state *w = xmalloc(sizeof(*w));
+
+	builder_init(&w->b, &g->d);
+	tree_init(&w->t);
+	w->rules = xmalloc(g->d.nrules * sizeof(*w->rules));
+	w->attrs.avps = xmalloc(g->obj.attrs * sizeof(struct avp));
+	sbuf_init(&w->orig);
+	sbuf_init(&w->enc);
+	return w;
+}
+
+static void worker_free(void *ctx, void *state)
+{
+	struct worker_state *w = state;
+
+	tree_free(&w->t);
+	builder_free(&w->b);
+	free(w->rules);
+	free(w->attrs.avps);
+	sbuf_free(&w->orig);
+	sbuf_free(&w->enc);
+	free(w);
+}
+
+/* Serialized tree for the covering rules in @w, built on first use */
+static struct memo_entry *get_tree(struct generator *g, struct worker_state *w, uint32_t n)
+{
+	uint64_t hash = hash_rules(w->rules, n);
+	struct memo_entry *e;
+
+	pthread_rwlock_rdlock(&g->memo.lock);
+	e = memo_find(&g->memo, hash, w->rules, n);
+	pthread_rwlock_unlock(&g->memo.lock);
+	if (e) {
+		__atomic_fetch_add(&g->memo.hits, 1, __ATOMIC_RELAXED);
+		return e;
+	}
+
+	build_tree(&w->b, &w->t, w->rules, n, NULL, 0);
+	sbuf_reset(&w->orig);
+	sbuf_reset(&w->enc);
+	format_tree(&w->orig, &g->d, &w->t, 0);
+	format_tree(&w->enc, &g->d, &w->t, 1);
+
+	pthread_rwlock_wrlock(&g->memo.lock);
+	/* Another worker may have built the same tree in the meantime */
+	e = memo_find(&g->memo, hash, w->rules, n);
+	if (!e) {
+		e = xmalloc(sizeof(*e));
+		e->hash = hash;
+		e->nrules = n;
+		e->rules = xmalloc(n * sizeof(*e->rules));
+		memcpy(e->rules, w->rules, n * sizeof(*e->rules));
+		e->orig = xstrdup(w->orig.buf);
+		e->enc = xstrdup(w->enc.buf);
+		e->next = g->memo.buckets[hash & (MEMO_BUCKETS - 1)];
+		g->memo.buckets[hash & (MEMO_BUCKETS - 1)] = e;
+		g->memo.trees++;
+	}
+	pthread_rwlock_unlock(&g->memo.lock);
+	return e;
+}
+
+static void generate_obj(void *ctx, void *state, uint32_t i, uint32_t slot)
+{
+	struct generator *g = ctx;
+	struct worker_state *w = state;
+	struct slot *s = &g->slots[slot];
+	const struct rule *rule = source_rule(g, i, g->obj.count);
+	struct memo_entry *tree;
+	char path[48];
+	struct rng r;
+	uint32_t n, j;
+
+	snprintf(path, sizeof(path), "/home/secured/obj_%u", i);
+	rng_seed(&r, g->seed, STREAM_OBJ, i);
+	entity_avps(&r, &rule->obj, &w->attrs);
+
+	sbuf_reset(&s->raw);
+	sbuf_printf(&s->raw, "    \"%s\": ", path);
+	json_avps(&s->raw, &g->d, &w->attrs);
+
+	/* Every object is written to obj_attrs, the index engines derive its rules */
+	sbuf_reset(&s->attrs_orig);
+	sbuf_reset(&s->attrs_enc);
+	sbuf_printf(&s->attrs_orig, "%s:", path);
+	sbuf_printf(&s->attrs_enc, "%s:", path);
+	format_avps(&s->attrs_orig, &g->d, &w->attrs, ',', 0);
+	format_avps(&s->attrs_enc, &g->d, &w->attrs, ',', 1);
+
+	sbuf_reset(&s->rules);
+	sbuf_reset(&s->tree_orig);
+	sbuf_reset(&s->tree_enc);
+	n = covering_rules(&g->d, &w->attrs, w->rules);
+	if (n == 0) {
+		__atomic_fetch_add(&g->not_found, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	__atomic_fetch_add(n > 1 ? &g->more_than_one : &g->found, 1, __ATOMIC_RELAXED);
+
+	sbuf_printf(&s->rules, "%s:", path);
+	for (j = 0; j < n; j++)
+		sbuf_printf(&s->rules, "%s%lld", j ? "," : "", g->d.rules[w->rules[j]].id);
+
+	tree = get_tree(g, w, n);
+	sbuf_printf(&s->tree_orig, "%s:%s", path, tree->orig);
+	sbuf_printf(&s->tree_enc, "%s:%s", path, tree->enc);
+}
+
+/* Lines are separated by newlines, the last one is not terminated */
+static void write_chunk(void *ctx, uint32_t start, uint32_t end)
+{
+	struct generator *g = ctx;
+	struct slot *s;
+	uint32_t i;
+
+	for (i = 0; i < end - start; i++) {
+		s = &g->slots[i];
+		if (g->raw_written) {
+			fputc('\n', g->f_attrs_orig);
+			fputc('\n', g->f_attrs_enc);
+		}
+		fputs(g->raw_written++ ? ",\n" : "\n", g->f_raw);
+		fwrite(s->raw.buf, 1, s->raw.len, g->f_raw);
+		fwrite(s->attrs_orig.buf, 1, s->attrs_orig.len, g->f_attrs_orig);
+		fwrite(s->attrs_enc.buf, 1, s->attrs_enc.len, g->f_attrs_enc);
+		if (!s->rules.len)
+			continue;
+		if (g->rules_written++) {
+			fputc('\n', g->f_rules_orig);
+			fputc('\n', g->f_rules_enc);
+			fputc('\n', g->f_trees_orig);
+			fputc('\n', g->f_trees_enc);
+		}
+		/* Rule ids are not encoded, both rule maps are the same */
+		fwrite(s->rules.buf, 1, s->rules.len, g->f_rules_orig);
+		fwrite(s->rules.buf, 1, s->rules.len, g->f_rules_enc);
+		fwrite(s->tree_orig.buf, 1, s->tree_orig.len, g->f_trees_orig);
+		fwrite(s->tree_enc.buf, 1, s->tree_enc.len, g->f_trees_enc);
+	}
+	fprintf(stderr, "\r%u/%u objects", end, g->obj.count);
+}
+
+static const struct pool_ops generate_ops = {
+	.thread_init = worker_init,
+	.thread_free = worker_free,
+	.work = generate_obj,
+	.flush = write_chunk,
+};
+
+static void write_raw_head(struct generator *g)
+{
+	const struct dataset *d = &g->d;
+	struct sbuf sb;
+	uint32_t i;
+
+	sbuf_init(&sb);
+	fprintf(g->f_raw, "{\n  \"config\": \"%s\",\n  \"user\": {", g->name);
+	for (i = 0; i < d->nusers; i++) {
+		sbuf_reset(&sb);
+		sbuf_printf(&sb, "%s\n    \"%s\": ", i ? "," : "", d->users[i].uid);
+		json_avps(&sb, d, &d->users[i].attrs);
+		fwrite(sb.buf, 1, sb.len, g->f_raw);
+	}
+	fputs("\n  },\n  \"obj\": {", g->f_raw);
+	sbuf_free(&sb);
+}
+
+static void write_raw_tail(struct generator *g)
+{
+	const struct dataset *d = &g->d;
+	const struct rule *r;
+	struct sbuf sb;
+	uint32_t i;
+
+	sbuf_init(&sb);
+	sbuf_puts(&sb, "\n  },\n  \"env\": {");
+	for (i = 0; i < d->nenvs; i++) {
+		sbuf_printf(&sb, "%s\n    \"e_%u\": ", i ? "," : "", i);
+		json_avps(&sb, d, &d->envs[i]);
+	}
+	sbuf_puts(&sb, "\n  },\n  \"current_env\": ");
+	json_avps(&sb, d, &d->current_env);
+	sbuf_puts(&sb, ",\n  \"policy\": [");
+	fwrite(sb.buf, 1, sb.len, g->f_raw);
+	for (i = 0; i < d->nrules; i++) {
+		r = &d->rules[i];
+		sbuf_reset(&sb);
+		sbuf_printf(&sb, "%s\n    {\"id\": %lld, \"user\": ", i ? "," : "", r->id);
+		json_avps(&sb, d, &r->user);
+		sbuf_puts(&sb, ", \"obj\": ");
+		json_avps(&sb, d, &r->obj);
+		sbuf_puts(&sb, ", \"env\": ");
+		json_avps(&sb, d, &r->env);
+		sbuf_printf(&sb, ", \"op\": \"%s\"}", r->op);
+		fwrite(sb.buf, 1, sb.len, g->f_raw);
+	}
+	fputs("\n  ]\n}\n", g->f_raw);
+	sbuf_free(&sb);
+}
+
+static FILE *open_output(const char *dir, const char *name)
+{
+	struct sbuf fname;
+	FILE *f;
+
+	sbuf_init(&fname);
+	sbuf_printf(&fname, "%s/%s", dir, name);
+	f = xfopen(fname.buf, "w");
+	sbuf_free(&fname);
+	return f;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Invalid usage\n%s [-j threads] [-s seed] <config_path>\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct generator g;
+	struct memo_entry *e, *next;
+	struct sbuf dirs[5];
+	long nthreads = default_threads();
+	uint32_t i;
+	int opt;
+
+	memset(&g, 0, sizeof(g));
+	g.seed = 1;
+	while ((opt = getopt(argc, argv, "j:s:")) != -1) {
+		switch (opt) {
+		case 'j':
+			nthreads = strtol(optarg, NULL, 10);
+			break;
+		case 's':
+			g.seed = strtoull(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 1)
+		usage(argv[0]);
+
+	load_config(&g, argv[optind]);
+	printf("Config %s loaded from %s\n", g.name, argv[optind]);
+
+	strtab_init(&g.d.strs);
+	intern_kind(&g, &g.user, "ua");
+	intern_kind(&g, &g.obj, "oa");
+	intern_kind(&g, &g.env, "ea");
+	generate_policy(&g);
+	generate_users(&g);
+	dataset_index(&g.d);
+	g.memo.buckets = xcalloc(MEMO_BUCKETS, sizeof(*g.memo.buckets));
+	pthread_rwlock_init(&g.memo.lock, NULL);
+
+	for (i = 0; i < 5; i++)
+		sbuf_init(&dirs[i]);
+	sbuf_printf(&dirs[0], "data/%s", g.name);
+	sbuf_printf(&dirs[1], "data/%s/rules/original", g.name);
+	sbuf_printf(&dirs[2], "data/%s/rules/encoded", g.name);
+	sbuf_printf(&dirs[3], "data/%s/trees/original", g.name);
+	sbuf_printf(&dirs[4], "data/%s/trees/encoded", g.name);
+	for (i = 0; i < 5; i++)
+		mkdir_p(dirs[i].buf);
+
+	g.f_raw = open_output(dirs[0].buf, "raw.json");
+	g.f_rules_orig = open_output(dirs[1].buf, "obj_rules");
+	g.f_rules_enc = open_output(dirs[2].buf, "obj_rules");
+	g.f_attrs_orig = open_output(dirs[1].buf, "obj_attrs");
+	g.f_attrs_enc = open_output(dirs[2].buf, "obj_attrs");
+	g.f_trees_orig = open_output(dirs[3].buf, "obj_attr");
+	g.f_trees_enc = open_output(dirs[4].buf, "obj_attr");
+
+	printf("Generating %u objects for %u users and %u rules with %ld threads...\n",
+	       g.obj.count, g.user.count, g.npolicy, nthreads);
+	write_raw_head(&g);
+	g.slots = xcalloc(CHUNK_OBJS, sizeof(*g.slots));
+	run_pool(g.obj.count, CHUNK_OBJS, nthreads, &generate_ops, &g);
+	fputc('\n', stderr);
+	write_raw_tail(&g);
+	fclose(g.f_raw);
+	fclose(g.f_rules_orig);
+	fclose(g.f_rules_enc);
+	fclose(g.f_attrs_orig);
+	fclose(g.f_attrs_enc);
+	fclose(g.f_trees_orig);
+	fclose(g.f_trees_enc);
+
+	for (i = 1; i < 5; i++) {
+		write_user_attr(&g.d, dirs[i].buf, i % 2 == 0);
+		write_env_attr(&g.d, dirs[i].buf, i % 2 == 0);
+	}
+	write_policy(&g.d, dirs[1].buf, 0);
+	write_policy(&g.d, dirs[2].buf, 1);
+
+	printf("Data written to %s/\n", dirs[0].buf);
+	printf("Objects with rules: %llu\n", (unsigned long long)g.found + g.more_than_one);
+	printf("Objects with more than one rule: %llu\n", (unsigned long long)g.more_than_one);
+	printf("Objects without rules: %llu\n", (unsigned long long)g.not_found);
+	printf("Distinct trees: %llu (reused %llu times)\n",
+	       (unsigned long long)g.memo.trees, (unsigned long long)g.memo.hits);
+
+	for (i = 0; i < CHUNK_OBJS; i++) {
+		sbuf_free(&g.slots[i].raw);
+		sbuf_free(&g.slots[i].attrs_orig);
+		sbuf_free(&g.slots[i].attrs_enc);
+		sbuf_free(&g.slots[i].rules);
+		sbuf_free(&g.slots[i].tree_orig);
+		sbuf_free(&g.slots[i].tree_enc);
+	}
+	free(g.slots);
+	for (i = 0; i < MEMO_BUCKETS; i++) {
+		for (e = g.memo.buckets[i]; e; e = next) {
+			next = e->next;
+			free(e->rules);
+			free(e->orig);
+			free(e->enc);
+			free(e);
+		}
+	}
+	free(g.memo.buckets);
+	pthread_rwlock_destroy(&g.memo.lock);
+	for (i = 0; i < 5; i++)
+		sbuf_free(&dirs[i]);
+	free(g.policy_idx);
+	free(g.name);
+	dataset_free(&g.d);
+	return 0;
+}
@@ -0,0 +1,602 @@
+/*
+ * Native load generator for the ABAC LSM, replaces perf.py for throughput runs
+ *
+ * Reads the users and objects of a dataset directory (the one loaded into the
+ * kernel, e.g. data/<config>/rules/original) and forks workers that access the
+ * objects under the uids of user_attr for a fixed duration. Each request opens an
+ * object, performs one operation and closes it:
+ *
+ *	read	read() of up to 4 KiB, checked by the LSM as ABAC_READ
+ *	write	zero length write(), checked as ABAC_MODIFY without changing the object
+ *	open	open() and close() only, the LSM is not consulted
+ *
+ * Run as root, workers switch their real uid (the one the LSM checks) between
+ * batches of requests with setresuid() and keep 0 as saved uid to switch again.
+ * Objects must be accessible to those uids under DAC, DAC failures (EACCES) are
+ * reported as errors, ABAC denials (EPERM) as denied.
+ *
+ * Latencies are kept in log-linear histograms in memory shared with the parent,
+ * with at most 1/HIST_SUB relative error, so no per-request work but the clock
+ * reads is added to the measured path.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "util.h"
+
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+#define MAX_LEVELS 32
+
+enum op {
+	OP_READ,
+	OP_WRITE,
+	OP_OPEN,
+	NR_OPS,
+};
+
+static const char *const op_names[NR_OPS] = { "read", "write", "open" };
+
+struct op_stats {
+	uint64_t requests;
+	uint64_t allowed;
+	uint64_t denied;
+	uint64_t errors;
+	uint64_t sum_ns;
+	uint64_t max_ns;
+	uint64_t hist[HIST_BUCKETS];
+};
+
+struct worker_stats {
+	struct op_stats ops[NR_OPS];
+	int first_errno;
+};
+
+/* Mapped shared before the workers are forked */
+struct shared {
+	int ready;
+	int go;
+	int stop;
+	struct worker_stats workers[];
+};
+
+struct options {
+	unsigned int levels[MAX_LEVELS];
+	unsigned int nlevels;
+	double duration;
+	unsigned int mix[NR_OPS];
+	double zipf;
+	unsigned int batch;
+	uint64_t seed;
+	const char *root;
+	const char *json;
+	int pin;
+};
+
+struct workload {
+	unsigned int *uids;
+	size_t nusers;
+	char **paths;
+	size_t nobjs;
+	/* Cumulative probabilities of the objects when the distribution is not uniform */
+	double *cdf;
+	unsigned int mix_total;
+};
+
+struct rng {
+	uint64_t s;
+};
+
+/* splitmix64 */
+static uint64_t rng_next(struct rng *r)
+{
+	uint64_t z = (r->s += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static double rng_double(struct rng *r)
+{
+	return (rng_next(r) >> 11) * (1.0 / (1ULL << 53));
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static unsigned int hist_bucket(uint64_t v)
+{
+	unsigned int msb;
+
+	if (v < HIST_SUB)
+		return v;
+	msb = 63 - __builtin_clzll(v);
+	return (msb - HIST_SUB_BITS + 1) * HIST_SUB + ((v >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+/* Midpoint of the values counted in a bucket */
+static uint64_t hist_value(unsigned int b)
+{
+	unsigned int shift;
+
+	if (b < HIST_SUB)
+		return b;
+	shift = b / HIST_SUB - 1;
+	return ((uint64_t)(HIST_SUB + b % HIST_SUB) << shift) + ((1ULL << shift) >> 1);
+}
+
+static uint64_t hist_percentile(const struct op_stats *s, double p)
+{
+	uint64_t rank, seen = 0;
+	unsigned int b;
+
+	if (!s->requests)
+		return 0;
+	rank = (uint64_t)ceil(p * s->requests);
+	if (rank == 0)
+		rank = 1;
+	for (b = 0; b < HIST_BUCKETS; b++) {
+		seen += s->hist[b];
+		if (seen >= rank)
+			return hist_value(b);
+	}
+	return s->max_ns;
+}
+
+static void stats_add(struct op_stats *dst, const struct op_stats *src)
+{
+	unsigned int b;
+
+	dst->requests += src->requests;
+	dst->allowed += src->allowed;
+	dst->denied += src->denied;
+	dst->errors += src->errors;
+	dst->sum_ns += src->sum_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+	for (b = 0; b < HIST_BUCKETS; b++)
+		dst->hist[b] += src->hist[b];
+}
+
+/* Split <key>:<value> lines in place and return the keys */
+static char **line_keys(char *buf, size_t *n)
+{
+	char **keys = NULL;
+	size_t cap = 0;
+	char *line, *sep;
+
+	*n = 0;
+	while ((line = strsep(&buf, "\n")) != NULL) {
+		sep = strchr(line, ':');
+		if (!sep)
+			continue;
+		*sep = '\0';
+		keys = grow(keys, &cap, *n + 1, sizeof(*keys));
+		keys[(*n)++] = line;
+	}
+	return keys;
+}
+
+static void load_workload(struct workload *w, const char *dir, const struct options *o)
+{
+	struct sbuf fname;
+	char *buf, **keys;
+	struct rng r = { o->seed };
+	size_t len, i, j;
+	double sum;
+
+	sbuf_init(&fname);
+	sbuf_printf(&fname, "%s/user_attr", dir);
+	buf = read_file(fname.buf, &len);
+	keys = line_keys(buf, &w->nusers);
+	w->uids = xmalloc(w->nusers * sizeof(*w->uids));
+	for (i = 0; i < w->nusers; i++)
+		w->uids[i] = strtoul(keys[i], NULL, 10);
+	free(keys);
+	free(buf);
+
+	sbuf_reset(&fname);
+	sbuf_printf(&fname, "%s/obj_rules", dir);
+	if (access(fname.buf, R_OK)) {
+		sbuf_reset(&fname);
+		sbuf_printf(&fname, "%s/obj_attr", dir);
+	}
+	buf = read_file(fname.buf, &len);
+	keys = line_keys(buf, &w->nobjs);
+	w->paths = xmalloc(w->nobjs * sizeof(*w->paths));
+	for (i = 0; i < w->nobjs; i++) {
+		sbuf_reset(&fname);
+		sbuf_printf(&fname, "%s%s", o->root, keys[i]);
+		w->paths[i] = xstrdup(fname.buf);
+	}
+	free(keys);
+	free(buf);
+	sbuf_free(&fname);
+	if (!w->nusers || !w->nobjs)
+		die("%s has no users or objects", dir);
+
+	/* Hot objects are spread over the object list so they do not follow the generator's order */
+	for (i = w->nobjs - 1; i > 0; i--) {
+		char *tmp = w->paths[i];
+
+		j = rng_next(&r) % (i + 1);
+		w->paths[i] = w->paths[j];
+		w->paths[j] = tmp;
+	}
+	w->cdf = NULL;
+	if (o->zipf > 0) {
+		w->cdf = xmalloc(w->nobjs * sizeof(*w->cdf));
+		for (i = 0, sum = 0; i < w->nobjs; i++) {
+			sum += 1.0 / pow(i + 1, o->zipf);
+			w->cdf[i] = sum;
+		}
+		for (i = 0; i < w->nobjs; i++)
+			w->cdf[i] /= sum;
+	}
+	for (i = 0, w->mix_total = 0; i < NR_OPS; i++)
+		w->mix_total += o->mix[i];
+}
+
+static size_t pick_obj(const struct workload *w, struct rng *r)
+{
+	size_t lo = 0, hi = w->nobjs - 1, mid;
+	double u;
+
+	if (!w->cdf)
+		return rng_next(r) % w->nobjs;
+	u = rng_double(r);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (w->cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static enum op pick_op(const struct workload *w, const struct options *o, struct rng *r)
+{
+	unsigned int x = rng_next(r) % w->mix_total;
+	enum op op;
+
+	for (op = 0; op < NR_OPS - 1; op++) {
+		if (x < o->mix[op])
+			break;
+		x -= o->mix[op];
+	}
+	return op;
+}
+
+static void switch_uid(unsigned int uid)
+{
+	/* Regain root through the saved uid, then take the new real and effective uid */
+	if (setresuid(-1, 0, -1) || setresuid(uid, uid, 0))
+		die("failed to switch to uid %u: %s", uid, strerror(errno));
+}
+
+/* Returns 0 if allowed, otherwise the errno of the failed call */
+static int do_request(enum op op, const char *path, char *buf)
+{
+	int fd, err = 0;
+
+	fd = open(path, op == OP_WRITE ? O_WRONLY : O_RDONLY);
+	if (fd < 0)
+		return errno;
+	if (op == OP_READ && read(fd, buf, 4096) < 0)
+		err = errno;
+	else if (op == OP_WRITE && write(fd, buf, 0) < 0)
+		err = errno;
+	close(fd);
+	return err;
+}
+
+static void run_worker(struct shared *sh, unsigned int id, const struct workload *w,
+		       const struct options *o, int root)
+{
+	struct worker_stats *ws = &sh->workers[id];
+	struct op_stats *s;
+	struct rng r = { o->seed ^ ((uint64_t)id << 32) };
+	static char buf[4096];
+	uint64_t start, lat;
+	unsigned int n = 0;
+	size_t obj;
+	enum op op;
+	int err;
+
+	rng_next(&r);
+	if (o->pin) {
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(id % sysconf(_SC_NPROCESSORS_ONLN), &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+	__atomic_add_fetch(&sh->ready, 1, __ATOMIC_RELEASE);
+	while (!__atomic_load_n(&sh->go, __ATOMIC_ACQUIRE))
+		usleep(100);
+
+	while (!__atomic_load_n(&sh->stop, __ATOMIC_RELAXED)) {
+		if (root && n++ % o->batch == 0)
+			switch_uid(w->uids[rng_next(&r) % w->nusers]);
+		op = pick_op(w, o, &r);
+		obj = pick_obj(w, &r);
+		start = now_ns();
+		err = do_request(op, w->paths[obj], buf);
+		lat = now_ns() - start;
+
+		s = &ws->ops[op];
+		s->requests++;
+		s->sum_ns += lat;
+		if (lat > s->max_ns)
+			s->max_ns = lat;
+		s->hist[hist_bucket(lat)]++;
+		if (!err) {
+			s->allowed++;
+		} else if (err == EPERM) {
+			s->denied++;
+		} else {
+			s->errors++;
+			if (!ws->first_errno)
+				ws->first_errno = err;
+		}
+	}
+	_exit(0);
+}
+
+static void print_row(const char *name, const struct op_stats *s)
+{
+	printf("  %-6s %10llu %10llu %10llu %8llu %9.0f %9llu %9llu %9llu %10llu\n", name,
+	       (unsigned long long)s->requests, (unsigned long long)s->allowed,
+	       (unsigned long long)s->denied, (unsigned long long)s->errors,
+	       s->requests ? (double)s->sum_ns / s->requests : 0.0,
+	       (unsigned long long)hist_percentile(s, 0.5),
+	       (unsigned long long)hist_percentile(s, 0.99),
+	       (unsigned long long)hist_percentile(s, 0.999),
+	       (unsigned long long)s->max_ns);
+}
+
+static void json_row(FILE *f, const char *name, const struct op_stats *s, int last)
+{
+	fprintf(f, "      \"%s\": {\"requests\": %llu, \"allowed\": %llu, \"denied\": %llu, "
+		"\"errors\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+		"\"p999_ns\": %llu, \"max_ns\": %llu}%s\n", name,
+		(unsigned long long)s->requests, (unsigned long long)s->allowed,
+		(unsigned long long)s->denied, (unsigned long long)s->errors,
+		s->requests ? (double)s->sum_ns / s->requests : 0.0,
+		(unsigned long long)hist_percentile(s, 0.5),
+		(unsigned long long)hist_percentile(s, 0.99),
+		(unsigned long long)hist_percentile(s, 0.999),
+		(unsigned long long)s->max_ns, last ? "" : ",");
+}
+
+/* Run one concurrency level and report its throughput and latencies */
+static void run_level(unsigned int nworkers, const struct workload *w, const struct options *o,
+		      int root, FILE *json, int last)
+{
+	struct shared *sh;
+	struct op_stats *total, *ops;
+	struct timespec ts;
+	size_t size = sizeof(*sh) + nworkers * sizeof(sh->workers[0]);
+	pid_t *pids = xmalloc(nworkers * sizeof(*pids));
+	uint64_t start, elapsed;
+	unsigned int i, op;
+	int status, first_errno = 0;
+
+	sh = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (sh == MAP_FAILED)
+		die("mmap: %s", strerror(errno));
+	fflush(stdout);
+	for (i = 0; i < nworkers; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0)
+			die("fork: %s", strerror(errno));
+		if (pids[i] == 0)
+			run_worker(sh, i, w, o, root);
+	}
+	while (__atomic_load_n(&sh->ready, __ATOMIC_ACQUIRE) < (int)nworkers)
+		usleep(1000);
+
+	start = now_ns();
+	__atomic_store_n(&sh->go, 1, __ATOMIC_RELEASE);
+	ts.tv_sec = (time_t)o->duration;
+	ts.tv_nsec = (long)((o->duration - ts.tv_sec) * 1e9);
+	while (nanosleep(&ts, &ts) && errno == EINTR)
+		;
+	__atomic_store_n(&sh->stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < nworkers; i++) {
+		if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+			die("worker %u failed", i);
+	}
+	elapsed = now_ns() - start;
+
+	total = xcalloc(1, sizeof(*total));
+	ops = xcalloc(NR_OPS, sizeof(*ops));
+	for (i = 0; i < nworkers; i++) {
+		for (op = 0; op < NR_OPS; op++) {
+			stats_add(&ops[op], &sh->workers[i].ops[op]);
+			stats_add(total, &sh->workers[i].ops[op]);
+		}
+		if (!first_errno)
+			first_errno = sh->workers[i].first_errno;
+	}
+
+	printf("%u workers, %.2f s, %llu requests, %.0f requests/s\n", nworkers, elapsed / 1e9,
+	       (unsigned long long)total->requests, total->requests / (elapsed / 1e9));
+	printf("  %-6s %10s %10s %10s %8s %9s %9s %9s %9s %10s\n", "op", "requests", "allowed",
+	       "denied", "errors", "mean_ns", "p50_ns", "p99_ns", "p999_ns", "max_ns");
+	for (op = 0; op < NR_OPS; op++)
+		if (o->mix[op])
+			print_row(op_names[op], &ops[op]);
+	print_row("all", total);
+	if (first_errno)
+		printf("  first error: %s\n", strerror(first_errno));
+
+	if (json) {
+		fprintf(json, "    {\"workers\": %u, \"elapsed_ns\": %llu, \"requests_per_s\": %.1f,\n",
+			nworkers, (unsigned long long)elapsed, total->requests / (elapsed / 1e9));
+		fprintf(json, "     \"ops\": {\n");
+		for (op = 0; op < NR_OPS; op++)
+			json_row(json, op_names[op], &ops[op], 0);
+		json_row(json, "all", total, 1);
+		fprintf(json, "    }}%s\n", last ? "" : ",");
+	}
+
+	free(ops);
+	free(total);
+	free(pids);
+	munmap(sh, size);
+}
+
+static void parse_levels(struct options *o, char *arg)
+{
+	char *tok;
+
+	o->nlevels = 0;
+	while ((tok = strsep(&arg, ",")) != NULL) {
+		if (o->nlevels == MAX_LEVELS)
+			die("at most %d concurrency levels", MAX_LEVELS);
+		o->levels[o->nlevels] = strtoul(tok, NULL, 10);
+		if (!o->levels[o->nlevels])
+			die("invalid concurrency '%s'", tok);
+		o->nlevels++;
+	}
+}
+
+static void parse_mix(struct options *o, char *arg)
+{
+	char *tok, *val;
+	unsigned int op;
+
+	memset(o->mix, 0, sizeof(o->mix));
+	while ((tok = strsep(&arg, ",")) != NULL) {
+		val = strchr(tok, '=');
+		if (!val)
+			die("invalid mix entry '%s', expected <op>=<weight>", tok);
+		*val++ = '\0';
+		for (op = 0; op < NR_OPS; op++)
+			if (!strcmp(tok, op_names[op]))
+				break;
+		if (op == NR_OPS)
+			die("unknown operation '%s'", tok);
+		o->mix[op] = strtoul(val, NULL, 10);
+	}
+	if (!o->mix[OP_READ] && !o->mix[OP_WRITE] && !o->mix[OP_OPEN])
+		die("operation mix is empty");
+}
+
+static void parse_dist(struct options *o, const char *arg)
+{
+	if (!strcmp(arg, "uniform"))
+		o->zipf = 0;
+	else if (!strncmp(arg, "zipf:", 5) && (o->zipf = strtod(arg + 5, NULL)) > 0)
+		return;
+	else
+		die("invalid distribution '%s', expected uniform or zipf:<exponent>", arg);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Invalid usage\n%s [-c workers[,workers...]] [-t seconds] "
+		"[-m read=N,write=N,open=N] [-d uniform|zipf:<s>] [-b batch] [-s seed] "
+		"[-r root] [-o results_json] [-p] <dataset_dir>\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct options o = {
+		.levels = { 1 },
+		.nlevels = 1,
+		.duration = 10,
+		.mix = { [OP_READ] = 1 },
+		.batch = 100,
+		.seed = 1,
+		.root = "",
+	};
+	struct workload w;
+	FILE *json = NULL;
+	unsigned int i;
+	int opt, root;
+
+	while ((opt = getopt(argc, argv, "c:t:m:d:b:s:r:o:p")) != -1) {
+		switch (opt) {
+		case 'c':
+			parse_levels(&o, optarg);
+			break;
+		case 't':
+			o.duration = strtod(optarg, NULL);
+			break;
+		case 'm':
+			parse_mix(&o, optarg);
+			break;
+		case 'd':
+			parse_dist(&o, optarg);
+			break;
+		case 'b':
+			o.batch = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			o.seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'r':
+			o.root = optarg;
+			break;
+		case 'o':
+			o.json = optarg;
+			break;
+		case 'p':
+			o.pin = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 1 || o.duration <= 0 || !o.batch)
+		usage(argv[0]);
+
+	load_workload(&w, argv[optind], &o);
+	root = geteuid() == 0;
+	printf("Loaded %zu users and %zu objects from %s\n", w.nusers, w.nobjs, argv[optind]);
+	if (!root)
+		printf("Not running as root, all requests are made as uid %u\n", getuid());
+
+	if (o.json) {
+		json = xfopen(o.json, "w");
+		fprintf(json, "{\n  \"dataset\": \"%s\",\n  \"duration_s\": %.3f,\n", argv[optind], o.duration);
+		fprintf(json, "  \"mix\": {\"read\": %u, \"write\": %u, \"open\": %u},\n",
+			o.mix[OP_READ], o.mix[OP_WRITE], o.mix[OP_OPEN]);
+		fprintf(json, "  \"zipf\": %.3f,\n  \"levels\": [\n", o.zipf);
+	}
+	for (i = 0; i < o.nlevels; i++)
+		run_level(o.levels[i], &w, &o, root, json, i + 1 == o.nlevels);
+	if (json) {
+		fprintf(json, "  ]\n}\n");
+		fclose(json);
+	}
+
+	for (i = 0; i < w.nobjs; i++)
+		free(w.paths[i]);
+	free(w.paths);
+	free(w.uids);
+	free(w.cdf);
+	return 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * Native PolTree compiler, replaces generate_tree_abacfs.py for large datasets
+ *
+ * Reads a raw dataset written by generate_raw.py (and optionally an access trace read
+ * from /sys/kernel/security/abac/trace) and writes data/<config>/trees/original and
+ * data/<config>/trees/encoded in the same format as the python script.
+ *
+ * Objects are compiled in chunks by a pool of threads, see pool.h. Each worker
+ * formats both forms of the tree of an object; the main thread then writes the
+ * chunk in object order. The tree of an object is built once, encoding
+ * only relabels attributes and values so it does not change the tree.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dataset.h"
+#include "poltree.h"
+#include "pool.h"
+
+#define CHUNK_OBJS 4096
+
+struct trace_entry {
+	uint32_t obj;
+	uint32_t user;
+	uint64_t weight;
+};
+
+struct compiler {
+	const struct dataset *d;
+	/* Traced requests of object i are reqs[req_start[i] .. req_start[i + 1]) */
+	struct request *reqs;
+	uint32_t *req_start;
+
+	struct sbuf *orig;	/* formatted lines of the current chunk */
+	struct sbuf *enc;
+	FILE *f_orig;
+	FILE *f_enc;
+	uint32_t written;
+	uint64_t no_rules;
+	uint64_t nodes;
+};
+
+struct worker_state {
+	struct tree_builder b;
+	struct tree t;
+	uint32_t *rules;
+};
+
+static void *worker_init(void *ctx)
+{
+	struct compiler *c = ctx;
+	struct worker_state *w = xmalloc(sizeof(*w));
+
+	builder_init(&w->b, c->d);
+	tree_init(&w->t);
+	w->rules = xmalloc(c->d->nrules * sizeof(*w->rules));
+	return w;
+}
+
+static void worker_free(void *ctx, void *state)
+{
+	struct worker_state *w = state;
+
+	tree_free(&w->t);
+	builder_free(&w->b);
+	free(w->rules);
+	free(w);
+}
+
+static void compile_obj(void *ctx, void *state, uint32_t i, uint32_t slot)
+{
+	struct compiler *c = ctx;
+	struct worker_state *w = state;
+	const struct dataset *d = c->d;
+	struct sbuf *orig = &c->orig[slot];
+	struct sbuf *enc = &c->enc[slot];
+	const struct request *reqs = NULL;
+	uint32_t nrules, nreqs = 0;
+
+	sbuf_reset(orig);
+	sbuf_reset(enc);
+	nrules = covering_rules(d, &d->objs[i].attrs, w->rules);
+	if (nrules == 0) {
+		__atomic_fetch_add(&c->no_rules, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	if (c->req_start) {
+		reqs = &c->reqs[c->req_start[i]];
+		nreqs = c->req_start[i + 1] - c->req_start[i];
+	}
+	build_tree(&w->b, &w->t, w->rules, nrules, reqs, nreqs);
+	__atomic_fetch_add(&c->nodes, w->t.n, __ATOMIC_RELAXED);
+
+	sbuf_puts(orig, d->objs[i].path);
+	sbuf_putc(orig, ':');
+	format_tree(orig, d, &w->t, 0);
+	sbuf_puts(enc, d->objs[i].path);
+	sbuf_putc(enc, ':');
+	format_tree(enc, d, &w->t, 1);
+}
+
+/* Lines are separated by newlines, the last one is not terminated */
+static void write_chunk(void *ctx, uint32_t start, uint32_t end)
+{
+	struct compiler *c = ctx;
+	uint32_t i;
+
+	for (i = 0; i < end - start; i++) {
+		if (!c->orig[i].len)
+			continue;
+		if (c->written++) {
+			fputc('\n', c->f_orig);
+			fputc('\n', c->f_enc);
+		}
+		fwrite(c->orig[i].buf, 1, c->orig[i].len, c->f_orig);
+		fwrite(c->enc[i].buf, 1, c->enc[i].len, c->f_enc);
+	}
+}
+
+static const struct pool_ops compile_ops = {
+	.thread_init = worker_init,
+	.thread_free = worker_free,
+	.work = compile_obj,
+	.flush = write_chunk,
+};
+
+static int cmp_trace_entry(const void *a, const void *b)
+{
+	const struct trace_entry *x = a, *y = b;
+
+	if (x->obj != y->obj)
+		return x->obj < y->obj ? -1 : 1;
+	if (x->user != y->user)
+		return x->user < y->user ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Parse <uid>:<path>:<op>:<count> lines. Both operations walk the same tree so their
+ * counts are added up, and requests of unknown users or objects are dropped.
+ */
+static void load_trace(struct compiler *c, const char *fname)
+{
+	const struct dataset *d = c->d;
+	struct trace_entry *entries = NULL;
+	size_t cap = 0, n = 0, len, i, m;
+	char *buf, *line, *next, *path, *op, *count;
+	uint32_t obj, user, traced = 0;
+
+	buf = read_file(fname, &len);
+	for (line = buf; line && *line; line = next) {
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		path = strchr(line, ':');
+		count = strrchr(line, ':');
+		if (!path || count == path)
+			continue;
+		*count++ = '\0';
+		op = strrchr(line, ':');
+		if (op == path)
+			continue;
+		*op = '\0';
+		*path++ = '\0';
+		user = dataset_find_user(d, line);
+		obj = dataset_find_obj(d, path);
+		if (user == NO_VALUE || obj == NO_VALUE)
+			continue;
+		entries = grow(entries, &cap, n + 1, sizeof(*entries));
+		entries[n].obj = obj;
+		entries[n].user = user;
+		entries[n].weight = strtoull(count, NULL, 10);
+		n++;
+	}
+	free(buf);
+
+	qsort(entries, n, sizeof(*entries), cmp_trace_entry);
+	c->req_start = xcalloc(d->nobjs + 1, sizeof(*c->req_start));
+	c->reqs = xmalloc((n ? n : 1) * sizeof(*c->reqs));
+	for (i = 0, m = 0; i < n; i++) {
+		if (m && entries[i].obj == entries[i - 1].obj && entries[i].user == entries[i - 1].user) {
+			c->reqs[m - 1].weight += entries[i].weight;
+			continue;
+		}
+		if (!i || entries[i].obj != entries[i - 1].obj)
+			traced++;
+		c->reqs[m].user = entries[i].user;
+		c->reqs[m].weight = entries[i].weight;
+		c->req_start[entries[i].obj + 1]++;
+		m++;
+	}
+	for (i = 0; i < d->nobjs; i++)
+		c->req_start[i + 1] += c->req_start[i];
+	free(entries);
+	printf("Loaded access trace for %u objects from %s\n", traced, fname);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Invalid usage\n%s [-j threads] <data_json> [access_trace]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct compiler c;
+	struct dataset d;
+	struct sbuf dir_orig, dir_enc, fname;
+	long nthreads = default_threads();
+	uint32_t i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:")) != -1) {
+		if (opt != 'j')
+			usage(argv[0]);
+		nthreads = strtol(optarg, NULL, 10);
+	}
+	if (nthreads < 1)
+		nthreads = 1;
+	if (argc - optind != 1 && argc - optind != 2)
+		usage(argv[0]);
+
+	dataset_load(&d, argv[optind]);
+	dataset_index(&d);
+	printf("Loaded data from %s\n", argv[optind]);
+
+	memset(&c, 0, sizeof(c));
+	c.d = &d;
+	if (argc - optind == 2)
+		load_trace(&c, argv[optind + 1]);
+
+	sbuf_init(&dir_orig);
+	sbuf_init(&dir_enc);
+	sbuf_init(&fname);
+	sbuf_printf(&dir_orig, "data/%s/trees/original", d.config);
+	sbuf_printf(&dir_enc, "data/%s/trees/encoded", d.config);
+	mkdir_p(dir_orig.buf);
+	mkdir_p(dir_enc.buf);
+	printf("Directories '%s' and '%s' created\n", dir_orig.buf, dir_enc.buf);
+
+	sbuf_printf(&fname, "%s/obj_attr", dir_orig.buf);
+	c.f_orig = xfopen(fname.buf, "w");
+	sbuf_reset(&fname);
+	sbuf_printf(&fname, "%s/obj_attr", dir_enc.buf);
+	c.f_enc = xfopen(fname.buf, "w");
+
+	printf("Building trees for %u objects with %ld threads...\n", d.nobjs, nthreads);
+	c.orig = xcalloc(CHUNK_OBJS, sizeof(*c.orig));
+	c.enc = xcalloc(CHUNK_OBJS, sizeof(*c.enc));
+	run_pool(d.nobjs, CHUNK_OBJS, nthreads, &compile_ops, &c);
+	fclose(c.f_orig);
+	fclose(c.f_enc);
+
+	write_user_attr(&d, dir_orig.buf, 0);
+	write_env_attr(&d, dir_orig.buf, 0);
+	write_user_attr(&d, dir_enc.buf, 1);
+	write_env_attr(&d, dir_enc.buf, 1);
+	printf("Data written to %s/ and %s/\n", dir_orig.buf, dir_enc.buf);
+	printf("Objects with trees: %u (%llu nodes)\n", c.written, (unsigned long long)c.nodes);
+	printf("Objects without rules: %llu\n", (unsigned long long)c.no_rules);
+
+	for (i = 0; i < CHUNK_OBJS; i++) {
+		sbuf_free(&c.orig[i]);
+		sbuf_free(&c.enc[i]);
+	}
+	free(c.orig);
+	free(c.enc);
+	free(c.reqs);
+	free(c.req_start);
+	sbuf_free(&dir_orig);
+	sbuf_free(&dir_enc);
+	sbuf_free(&fname);
+	dataset_free(&d);
+	return 0;
+}
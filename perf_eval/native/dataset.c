@@ -0,0 +1,481 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dataset.h"
+#include "json.h"
+
+static uint64_t str_hash(const char *s)
+{
+	/* FNV-1a */
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+void strtab_init(struct strtab *t)
+{
+	memset(t, 0, sizeof(*t));
+}
+
+void strtab_free(struct strtab *t)
+{
+	uint32_t i;
+
+	for (i = 0; i < t->count; i++)
+		free(t->strs[i]);
+	free(t->strs);
+	free(t->slots);
+	strtab_init(t);
+}
+
+static void strtab_rehash(struct strtab *t)
+{
+	size_t nslots = t->nslots ? t->nslots * 2 : 1024;
+	uint32_t i;
+	size_t s;
+
+	free(t->slots);
+	t->slots = xcalloc(nslots, sizeof(*t->slots));
+	t->nslots = nslots;
+	for (i = 0; i < t->count; i++) {
+		s = str_hash(t->strs[i]) & (nslots - 1);
+		while (t->slots[s])
+			s = (s + 1) & (nslots - 1);
+		t->slots[s] = i + 1;
+	}
+}
+
+uint32_t strtab_find(const struct strtab *t, const char *s)
+{
+	size_t i;
+
+	if (!t->nslots)
+		return NO_VALUE;
+	i = str_hash(s) & (t->nslots - 1);
+	for (; t->slots[i]; i = (i + 1) & (t->nslots - 1))
+		if (!strcmp(t->strs[t->slots[i] - 1], s))
+			return t->slots[i] - 1;
+	return NO_VALUE;
+}
+
+uint32_t strtab_intern(struct strtab *t, const char *s)
+{
+	uint32_t id = strtab_find(t, s);
+	size_t i;
+
+	if (id != NO_VALUE)
+		return id;
+	if ((t->count + 1) * 2 > t->nslots)
+		strtab_rehash(t);
+	t->strs = grow(t->strs, &t->cap, t->count + 1, sizeof(*t->strs));
+	id = t->count++;
+	t->strs[id] = xstrdup(s);
+	i = str_hash(s) & (t->nslots - 1);
+	while (t->slots[i])
+		i = (i + 1) & (t->nslots - 1);
+	t->slots[i] = id + 1;
+	return id;
+}
+
+uint32_t avp_list_get(const struct avp_list *l, uint32_t attr)
+{
+	uint32_t i;
+
+	for (i = 0; i < l->n; i++)
+		if (l->avps[i].attr == attr)
+			return l->avps[i].value;
+	return NO_VALUE;
+}
+
+/* Convert a JSON object of "name": "value" members into an attribute list */
+static void load_avps(struct dataset *d, const struct json_value *obj, struct avp_list *l)
+{
+	struct json_value *c;
+	uint32_t i = 0;
+
+	if (obj->type != JSON_OBJECT)
+		die("invalid dataset: attributes must be objects");
+	l->n = obj->len;
+	l->avps = xmalloc(l->n * sizeof(*l->avps));
+	json_for_each(c, obj) {
+		if (c->type != JSON_STRING)
+			die("invalid dataset: value of '%s' is not a string", c->key);
+		l->avps[i].attr = strtab_intern(&d->strs, c->key);
+		l->avps[i].value = strtab_intern(&d->strs, c->string);
+		i++;
+	}
+}
+
+/*
+ * Strings are interned in the order encode.py collects them: users, objects,
+ * environmental states and then the policy.
+ */
+void dataset_load(struct dataset *d, const char *fname)
+{
+	struct json_value *root, *users, *objs, *envs, *policy, *c, *op;
+	struct json_doc doc;
+	size_t len, err;
+	char *buf;
+	uint32_t i;
+
+	memset(d, 0, sizeof(*d));
+	strtab_init(&d->strs);
+	buf = read_file(fname, &len);
+	err = json_parse(buf, len, &doc);
+	if (err)
+		die("%s: invalid JSON near offset %zu", fname, err - 1);
+	root = doc.root;
+
+	d->config = xstrdup(json_need(root, "config", JSON_STRING)->string);
+	users = json_need(root, "user", JSON_OBJECT);
+	objs = json_need(root, "obj", JSON_OBJECT);
+	envs = json_need(root, "env", JSON_OBJECT);
+	policy = json_need(root, "policy", JSON_ARRAY);
+
+	d->nusers = users->len;
+	d->users = xcalloc(d->nusers, sizeof(*d->users));
+	i = 0;
+	json_for_each(c, users) {
+		d->users[i].uid = xstrdup(c->key);
+		load_avps(d, c, &d->users[i].attrs);
+		i++;
+	}
+
+	d->nobjs = objs->len;
+	d->objs = xcalloc(d->nobjs, sizeof(*d->objs));
+	i = 0;
+	json_for_each(c, objs) {
+		d->objs[i].path = xstrdup(c->key);
+		load_avps(d, c, &d->objs[i].attrs);
+		i++;
+	}
+
+	d->nenvs = envs->len;
+	d->envs = xcalloc(d->nenvs, sizeof(*d->envs));
+	i = 0;
+	json_for_each(c, envs)
+		load_avps(d, c, &d->envs[i++]);
+
+	d->nrules = policy->len;
+	d->rules = xcalloc(d->nrules, sizeof(*d->rules));
+	i = 0;
+	json_for_each(c, policy) {
+		struct rule *r = &d->rules[i++];
+
+		r->id = (long long)json_need(c, "id", JSON_NUMBER)->number;
+		load_avps(d, json_need(c, "user", JSON_OBJECT), &r->user);
+		load_avps(d, json_need(c, "obj", JSON_OBJECT), &r->obj);
+		load_avps(d, json_need(c, "env", JSON_OBJECT), &r->env);
+		op = json_need(c, "op", JSON_STRING);
+		if (!strcmp(op->string, "READ"))
+			r->op = "READ";
+		else if (!strcmp(op->string, "MODIFY"))
+			r->op = "MODIFY";
+		else
+			die("invalid dataset: unknown operation '%s'", op->string);
+	}
+
+	load_avps(d, json_need(root, "current_env", JSON_OBJECT), &d->current_env);
+
+	json_free(&doc);
+	free(buf);
+}
+
+void dataset_free(struct dataset *d)
+{
+	uint32_t i;
+
+	for (i = 0; i < d->nusers; i++) {
+		free(d->users[i].uid);
+		free(d->users[i].attrs.avps);
+	}
+	for (i = 0; i < d->nobjs; i++) {
+		free(d->objs[i].path);
+		free(d->objs[i].attrs.avps);
+	}
+	for (i = 0; i < d->nenvs; i++)
+		free(d->envs[i].avps);
+	for (i = 0; i < d->nrules; i++) {
+		free(d->rules[i].user.avps);
+		free(d->rules[i].obj.avps);
+		free(d->rules[i].env.avps);
+	}
+	if (d->obj_index)
+		for (i = 0; i < d->strs.count; i++)
+			free(d->obj_index[i]);
+	free(d->users);
+	free(d->objs);
+	free(d->envs);
+	free(d->rules);
+	free(d->current_env.avps);
+	free(d->user_count);
+	free(d->env_count);
+	free(d->obj_index);
+	free(d->obj_index_len);
+	free(d->uid_slots);
+	free(d->path_slots);
+	free(d->config);
+	strtab_free(&d->strs);
+	memset(d, 0, sizeof(*d));
+}
+
+/* Count every distinct value of each entity once, like "v in avp.values()" in tree.py */
+static void count_values(const struct avp_list *ls, uint32_t n,
+			 uint32_t *count, uint32_t *stamp)
+{
+	uint32_t i, j, v;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < ls[i].n; j++) {
+			v = ls[i].avps[j].value;
+			if (stamp[v] == i + 1)
+				continue;
+			stamp[v] = i + 1;
+			count[v]++;
+		}
+	}
+}
+
+static uint32_t *build_name_index(size_t n, size_t *nslots, const char *(*name)(const struct dataset *, uint32_t),
+				  const struct dataset *d)
+{
+	uint32_t *slots;
+	size_t size = 1024, s;
+	uint32_t i;
+
+	while (size < n * 2)
+		size *= 2;
+	slots = xcalloc(size, sizeof(*slots));
+	for (i = 0; i < n; i++) {
+		s = str_hash(name(d, i)) & (size - 1);
+		while (slots[s])
+			s = (s + 1) & (size - 1);
+		slots[s] = i + 1;
+	}
+	*nslots = size;
+	return slots;
+}
+
+static uint32_t find_name(const uint32_t *slots, size_t nslots, const char *key,
+			  const char *(*name)(const struct dataset *, uint32_t),
+			  const struct dataset *d)
+{
+	size_t s;
+
+	if (!nslots)
+		return NO_VALUE;
+	s = str_hash(key) & (nslots - 1);
+	for (; slots[s]; s = (s + 1) & (nslots - 1))
+		if (!strcmp(name(d, slots[s] - 1), key))
+			return slots[s] - 1;
+	return NO_VALUE;
+}
+
+static const char *user_name(const struct dataset *d, uint32_t i)
+{
+	return d->users[i].uid;
+}
+
+static const char *obj_name(const struct dataset *d, uint32_t i)
+{
+	return d->objs[i].path;
+}
+
+uint32_t dataset_find_user(const struct dataset *d, const char *uid)
+{
+	return find_name(d->uid_slots, d->uid_nslots, uid, user_name, d);
+}
+
+uint32_t dataset_find_obj(const struct dataset *d, const char *path)
+{
+	return find_name(d->path_slots, d->path_nslots, path, obj_name, d);
+}
+
+void dataset_index(struct dataset *d)
+{
+	uint32_t nstrs = d->strs.count;
+	uint32_t *stamp = xcalloc(nstrs, sizeof(*stamp));
+	size_t *cap = xcalloc(nstrs, sizeof(*cap));
+	const struct avp_list *obj;
+	uint32_t i, j, v;
+
+	d->user_count = xcalloc(nstrs, sizeof(*d->user_count));
+	d->env_count = xcalloc(nstrs, sizeof(*d->env_count));
+	for (i = 0; i < d->nusers; i++) {
+		for (j = 0; j < d->users[i].attrs.n; j++) {
+			v = d->users[i].attrs.avps[j].value;
+			if (stamp[v] == i + 1)
+				continue;
+			stamp[v] = i + 1;
+			d->user_count[v]++;
+		}
+	}
+	memset(stamp, 0, nstrs * sizeof(*stamp));
+	count_values(d->envs, d->nenvs, d->env_count, stamp);
+
+	/* Inverted index from object attribute values to the rules using them */
+	memset(stamp, 0, nstrs * sizeof(*stamp));
+	d->obj_index = xcalloc(nstrs, sizeof(*d->obj_index));
+	d->obj_index_len = xcalloc(nstrs, sizeof(*d->obj_index_len));
+	for (i = 0; i < d->nrules; i++) {
+		obj = &d->rules[i].obj;
+		for (j = 0; j < obj->n; j++) {
+			v = obj->avps[j].value;
+			if (stamp[v] == i + 1)
+				continue;
+			stamp[v] = i + 1;
+			d->obj_index[v] = grow(d->obj_index[v], &cap[v], d->obj_index_len[v] + 1,
+					       sizeof(**d->obj_index));
+			d->obj_index[v][d->obj_index_len[v]++] = i;
+		}
+	}
+
+	d->uid_slots = build_name_index(d->nusers, &d->uid_nslots, user_name, d);
+	d->path_slots = build_name_index(d->nobjs, &d->path_nslots, obj_name, d);
+	free(cap);
+	free(stamp);
+}
+
+/*
+ * A rule covers an object when every object attribute has the same value in the rule.
+ * Candidates come from the shortest index list of the object's values and are then
+ * checked in full, instead of testing every rule of the policy.
+ */
+uint32_t covering_rules(const struct dataset *d, const struct avp_list *attrs, uint32_t *out)
+{
+	const uint32_t *cand = NULL;
+	uint32_t ncand = 0, n = 0, i, j, v;
+
+	if (attrs->n == 0) {
+		for (i = 0; i < d->nrules; i++)
+			out[i] = i;
+		return d->nrules;
+	}
+	for (j = 0; j < attrs->n; j++) {
+		v = attrs->avps[j].value;
+		if (v >= d->strs.count || !d->obj_index_len[v])
+			return 0;
+		if (!cand || d->obj_index_len[v] < ncand) {
+			cand = d->obj_index[v];
+			ncand = d->obj_index_len[v];
+		}
+	}
+	for (i = 0; i < ncand; i++) {
+		const struct rule *r = &d->rules[cand[i]];
+
+		for (j = 0; j < attrs->n; j++)
+			if (avp_list_get(&r->obj, attrs->avps[j].attr) != attrs->avps[j].value)
+				break;
+		if (j == attrs->n)
+			out[n++] = cand[i];
+	}
+	return n;
+}
+
+void format_str(struct sbuf *sb, const struct dataset *d, uint32_t id, int enc)
+{
+	if (enc)
+		sbuf_printf(sb, "%u", id + 1);
+	else
+		sbuf_puts(sb, d->strs.strs[id]);
+}
+
+void format_avps(struct sbuf *sb, const struct dataset *d, const struct avp_list *l,
+		 char sep, int enc)
+{
+	uint32_t i;
+
+	for (i = 0; i < l->n; i++) {
+		if (i)
+			sbuf_putc(sb, sep);
+		format_str(sb, d, l->avps[i].attr, enc);
+		sbuf_putc(sb, '=');
+		format_str(sb, d, l->avps[i].value, enc);
+	}
+}
+
+void write_user_attr(const struct dataset *d, const char *dir, int enc)
+{
+	struct sbuf sb, fname;
+	uint32_t i;
+	FILE *f;
+
+	sbuf_init(&fname);
+	sbuf_printf(&fname, "%s/user_attr", dir);
+	f = xfopen(fname.buf, "w");
+	sbuf_init(&sb);
+	for (i = 0; i < d->nusers; i++) {
+		sbuf_reset(&sb);
+		sbuf_puts(&sb, d->users[i].uid);
+		/* A user without attributes loses the separator, as in the python output */
+		if (d->users[i].attrs.n)
+			sbuf_putc(&sb, ':');
+		format_avps(&sb, d, &d->users[i].attrs, ',', enc);
+		sbuf_putc(&sb, '\n');
+		fwrite(sb.buf, 1, sb.len, f);
+	}
+	fclose(f);
+	sbuf_free(&sb);
+	sbuf_free(&fname);
+}
+
+void write_env_attr(const struct dataset *d, const char *dir, int enc)
+{
+	struct sbuf sb, fname;
+	FILE *f;
+
+	sbuf_init(&fname);
+	sbuf_printf(&fname, "%s/env_attr", dir);
+	f = xfopen(fname.buf, "w");
+	sbuf_init(&sb);
+	format_avps(&sb, d, &d->current_env, '\n', enc);
+	fwrite(sb.buf, 1, sb.len, f);
+	fclose(f);
+	sbuf_free(&sb);
+	sbuf_free(&fname);
+}
+
+void write_policy(const struct dataset *d, const char *dir, int enc)
+{
+	const struct rule *r;
+	struct sbuf sb, fname;
+	uint32_t i;
+	FILE *f;
+
+	sbuf_init(&fname);
+	sbuf_printf(&fname, "%s/policy", dir);
+	f = xfopen(fname.buf, "w");
+	sbuf_init(&sb);
+	fprintf(f, "%u\n", d->nrules);
+	for (i = 0; i < d->nrules; i++) {
+		r = &d->rules[i];
+		sbuf_reset(&sb);
+		sbuf_printf(&sb, "%lld:", r->id);
+		/* The python script drops the separator before an empty section */
+		if (r->user.n)
+			format_avps(&sb, d, &r->user, ',', enc);
+		else
+			sbuf_chop(&sb);
+		sbuf_putc(&sb, '|');
+		if (r->env.n)
+			format_avps(&sb, d, &r->env, ',', enc);
+		else
+			sbuf_chop(&sb);
+		sbuf_putc(&sb, '|');
+		sbuf_puts(&sb, r->op);
+		/* Object attributes of the rule, used by the index engines */
+		if (r->obj.n) {
+			sbuf_putc(&sb, '|');
+			format_avps(&sb, d, &r->obj, ',', enc);
+		}
+		sbuf_putc(&sb, '\n');
+		fwrite(sb.buf, 1, sb.len, f);
+	}
+	fclose(f);
+	sbuf_free(&sb);
+	sbuf_free(&fname);
+}
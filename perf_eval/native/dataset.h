@@ -0,0 +1,116 @@
+#ifndef _ABAC_NATIVE_DATASET_H
+#define _ABAC_NATIVE_DATASET_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "util.h"
+
+#define NO_VALUE UINT32_MAX
+
+/*
+ * Attribute names and values are interned into a single table. The id of a string
+ * plus one is its encoded form, the same scheme encode.py uses, except that ids are
+ * handed out in order of first appearance instead of python set order.
+ */
+struct strtab {
+	char **strs;
+	uint32_t count;
+	size_t cap;
+	uint32_t *slots;	/* open addressing, holds id + 1 */
+	size_t nslots;
+};
+
+void strtab_init(struct strtab *t);
+void strtab_free(struct strtab *t);
+uint32_t strtab_intern(struct strtab *t, const char *s);
+/* Returns NO_VALUE if @s was never interned */
+uint32_t strtab_find(const struct strtab *t, const char *s);
+
+struct avp {
+	uint32_t attr;
+	uint32_t value;
+};
+
+struct avp_list {
+	struct avp *avps;
+	uint32_t n;
+};
+
+/* Value of @attr in @l or NO_VALUE */
+uint32_t avp_list_get(const struct avp_list *l, uint32_t attr);
+
+struct user {
+	char *uid;
+	struct avp_list attrs;
+};
+
+struct object {
+	char *path;
+	struct avp_list attrs;
+};
+
+struct rule {
+	long long id;
+	const char *op;
+	struct avp_list user;
+	struct avp_list obj;
+	struct avp_list env;
+};
+
+struct dataset {
+	char *config;
+	struct strtab strs;
+	struct user *users;
+	uint32_t nusers;
+	struct object *objs;
+	uint32_t nobjs;
+	struct avp_list *envs;
+	uint32_t nenvs;
+	struct avp_list current_env;
+	struct rule *rules;
+	uint32_t nrules;
+
+	/* Counting tables indexed by string id, see dataset_index() */
+	uint32_t *user_count;	/* users holding a value */
+	uint32_t *env_count;	/* environmental states holding a value */
+	/* Rules whose object part contains a value, indexed by string id */
+	uint32_t **obj_index;
+	uint32_t *obj_index_len;
+	/* uid and path lookup, open addressing holding index + 1 */
+	uint32_t *uid_slots;
+	size_t uid_nslots;
+	uint32_t *path_slots;
+	size_t path_nslots;
+};
+
+/* Load a raw dataset written by generate_raw.py */
+void dataset_load(struct dataset *d, const char *fname);
+void dataset_free(struct dataset *d);
+/* Build the counting tables and the covering rule index, call once all data is added */
+void dataset_index(struct dataset *d);
+
+/* Index of the user with @uid or NO_VALUE, valid after dataset_index() */
+uint32_t dataset_find_user(const struct dataset *d, const char *uid);
+/* Index of the object with @path or NO_VALUE, valid after dataset_index() */
+uint32_t dataset_find_obj(const struct dataset *d, const char *path);
+
+/*
+ * Store the ids of rules covering an object with attributes @attrs in @out (sized
+ * for nrules entries), in policy order. Returns the number of covering rules.
+ */
+uint32_t covering_rules(const struct dataset *d, const struct avp_list *attrs, uint32_t *out);
+
+/* Append "name=value" for every pair of @l to @sb, separated by @sep, original or encoded */
+void format_avps(struct sbuf *sb, const struct dataset *d, const struct avp_list *l,
+		 char sep, int enc);
+/* Name of string @id in original or encoded form */
+void format_str(struct sbuf *sb, const struct dataset *d, uint32_t id, int enc);
+
+/* Write user_attr and env_attr in the format of the python generators */
+void write_user_attr(const struct dataset *d, const char *dir, int enc);
+void write_env_attr(const struct dataset *d, const char *dir, int enc);
+/* Write the policy file of the rule based evaluation, see generate_rule_abacfs.py */
+void write_policy(const struct dataset *d, const char *dir, int enc);
+
+#endif /* _ABAC_NATIVE_DATASET_H */
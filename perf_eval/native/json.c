@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+#include "util.h"
+
+#define JSON_BLOCK_NODES 4096
+#define JSON_MAX_DEPTH 64
+
+struct json_block {
+	struct json_block *next;
+	size_t used;
+	struct json_value nodes[JSON_BLOCK_NODES];
+};
+
+struct parser {
+	char *p;
+	char *end;
+	char *start;
+	struct json_block *blocks;
+	int failed;
+};
+
+static struct json_value *new_node(struct parser *ps, enum json_type type)
+{
+	struct json_block *b = ps->blocks;
+	struct json_value *v;
+
+	if (!b || b->used == JSON_BLOCK_NODES) {
+		b = xmalloc(sizeof(*b));
+		b->used = 0;
+		b->next = ps->blocks;
+		ps->blocks = b;
+	}
+	v = &b->nodes[b->used++];
+	memset(v, 0, sizeof(*v));
+	v->type = type;
+	return v;
+}
+
+static void skip_ws(struct parser *ps)
+{
+	while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' ||
+				   *ps->p == '\n' || *ps->p == '\r'))
+		ps->p++;
+}
+
+static int hex_digit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static char *put_utf8(char *out, unsigned cp)
+{
+	if (cp < 0x80) {
+		*out++ = cp;
+	} else if (cp < 0x800) {
+		*out++ = 0xc0 | (cp >> 6);
+		*out++ = 0x80 | (cp & 0x3f);
+	} else if (cp < 0x10000) {
+		*out++ = 0xe0 | (cp >> 12);
+		*out++ = 0x80 | ((cp >> 6) & 0x3f);
+		*out++ = 0x80 | (cp & 0x3f);
+	} else {
+		*out++ = 0xf0 | (cp >> 18);
+		*out++ = 0x80 | ((cp >> 12) & 0x3f);
+		*out++ = 0x80 | ((cp >> 6) & 0x3f);
+		*out++ = 0x80 | (cp & 0x3f);
+	}
+	return out;
+}
+
+/* Decode the string starting at the opening quote, the result is written over the input */
+static const char *parse_string(struct parser *ps)
+{
+	char *out, *s;
+	unsigned cp;
+	int i, d;
+
+	s = out = ++ps->p;
+	while (ps->p < ps->end && *ps->p != '"') {
+		if (*ps->p != '\\') {
+			*out++ = *ps->p++;
+			continue;
+		}
+		if (++ps->p >= ps->end)
+			goto fail;
+		switch (*ps->p++) {
+		case '"': *out++ = '"'; break;
+		case '\\': *out++ = '\\'; break;
+		case '/': *out++ = '/'; break;
+		case 'b': *out++ = '\b'; break;
+		case 'f': *out++ = '\f'; break;
+		case 'n': *out++ = '\n'; break;
+		case 'r': *out++ = '\r'; break;
+		case 't': *out++ = '\t'; break;
+		case 'u':
+			if (ps->end - ps->p < 4)
+				goto fail;
+			cp = 0;
+			for (i = 0; i < 4; i++) {
+				d = hex_digit(*ps->p++);
+				if (d < 0)
+					goto fail;
+				cp = (cp << 4) | d;
+			}
+			out = put_utf8(out, cp);
+			break;
+		default:
+			goto fail;
+		}
+	}
+	if (ps->p >= ps->end)
+		goto fail;
+	ps->p++;
+	*out = '\0';
+	return s;
+fail:
+	ps->failed = 1;
+	return NULL;
+}
+
+static struct json_value *parse_value(struct parser *ps, int depth);
+
+static struct json_value *parse_container(struct parser *ps, int depth, int object)
+{
+	struct json_value *v = new_node(ps, object ? JSON_OBJECT : JSON_ARRAY);
+	struct json_value **tail = &v->child;
+	struct json_value *c;
+	char close = object ? '}' : ']';
+	const char *key = NULL;
+
+	ps->p++;
+	skip_ws(ps);
+	if (ps->p < ps->end && *ps->p == close) {
+		ps->p++;
+		return v;
+	}
+	for (;;) {
+		skip_ws(ps);
+		if (object) {
+			if (ps->p >= ps->end || *ps->p != '"')
+				goto fail;
+			key = parse_string(ps);
+			if (!key)
+				return NULL;
+			skip_ws(ps);
+			if (ps->p >= ps->end || *ps->p != ':')
+				goto fail;
+			ps->p++;
+		}
+		c = parse_value(ps, depth + 1);
+		if (!c)
+			return NULL;
+		c->key = key;
+		*tail = c;
+		tail = &c->next;
+		v->len++;
+		skip_ws(ps);
+		if (ps->p >= ps->end)
+			goto fail;
+		if (*ps->p == ',') {
+			ps->p++;
+			continue;
+		}
+		if (*ps->p != close)
+			goto fail;
+		ps->p++;
+		return v;
+	}
+fail:
+	ps->failed = 1;
+	return NULL;
+}
+
+static int match_word(struct parser *ps, const char *word)
+{
+	size_t len = strlen(word);
+
+	if ((size_t)(ps->end - ps->p) < len || memcmp(ps->p, word, len))
+		return 0;
+	ps->p += len;
+	return 1;
+}
+
+static struct json_value *parse_value(struct parser *ps, int depth)
+{
+	struct json_value *v;
+	char *num_end;
+
+	if (depth > JSON_MAX_DEPTH)
+		goto fail;
+	skip_ws(ps);
+	if (ps->p >= ps->end)
+		goto fail;
+	switch (*ps->p) {
+	case '{':
+		return parse_container(ps, depth, 1);
+	case '[':
+		return parse_container(ps, depth, 0);
+	case '"':
+		v = new_node(ps, JSON_STRING);
+		v->string = parse_string(ps);
+		return v->string ? v : NULL;
+	case 't':
+	case 'f':
+		v = new_node(ps, JSON_BOOL);
+		if (match_word(ps, "true"))
+			v->number = 1;
+		else if (!match_word(ps, "false"))
+			goto fail;
+		return v;
+	case 'n':
+		if (!match_word(ps, "null"))
+			goto fail;
+		return new_node(ps, JSON_NULL);
+	default:
+		/* The buffer is NUL terminated so strtod() cannot run past it */
+		v = new_node(ps, JSON_NUMBER);
+		v->number = strtod(ps->p, &num_end);
+		if (num_end == ps->p)
+			goto fail;
+		ps->p = num_end;
+		return v;
+	}
+fail:
+	ps->failed = 1;
+	return NULL;
+}
+
+size_t json_parse(char *buf, size_t len, struct json_doc *doc)
+{
+	struct parser ps = {
+		.p = buf,
+		.end = buf + len,
+		.start = buf,
+	};
+
+	doc->root = parse_value(&ps, 0);
+	doc->blocks = ps.blocks;
+	if (!ps.failed) {
+		skip_ws(&ps);
+		if (ps.p == ps.end)
+			return 0;
+	}
+	json_free(doc);
+	return ps.p - ps.start + 1;
+}
+
+void json_free(struct json_doc *doc)
+{
+	struct json_block *b = doc->blocks, *next;
+
+	for (; b; b = next) {
+		next = b->next;
+		free(b);
+	}
+	doc->blocks = NULL;
+	doc->root = NULL;
+}
+
+struct json_value *json_get(const struct json_value *obj, const char *key)
+{
+	struct json_value *c;
+
+	if (!obj || obj->type != JSON_OBJECT)
+		return NULL;
+	json_for_each(c, obj)
+		if (!strcmp(c->key, key))
+			return c;
+	return NULL;
+}
+
+struct json_value *json_need(const struct json_value *obj, const char *key, enum json_type type)
+{
+	struct json_value *v = json_get(obj, key);
+
+	if (!v || v->type != type)
+		die("invalid dataset: missing or malformed '%s'", key);
+	return v;
+}
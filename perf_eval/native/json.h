@@ -0,0 +1,50 @@
+#ifndef _ABAC_NATIVE_JSON_H
+#define _ABAC_NATIVE_JSON_H
+
+#include <stddef.h>
+
+/*
+ * Minimal JSON reader for the raw datasets written by generate_raw.py
+ *
+ * Strings are decoded in place, so the returned tree points into the input buffer
+ * and is only valid as long as that buffer is. Object members keep file order,
+ * which the generators rely on for attribute ordering.
+ */
+
+enum json_type {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT,
+};
+
+struct json_value {
+	enum json_type type;
+	const char *key;		/* member name when the parent is an object */
+	const char *string;		/* JSON_STRING */
+	double number;			/* JSON_NUMBER and JSON_BOOL */
+	size_t len;			/* number of children of an array or object */
+	struct json_value *child;	/* first child of an array or object */
+	struct json_value *next;	/* next sibling */
+};
+
+struct json_doc {
+	struct json_value *root;
+	void *blocks;			/* node arena */
+};
+
+/* Parse @buf of @len bytes. Returns 0 on success, otherwise the error offset + 1 */
+size_t json_parse(char *buf, size_t len, struct json_doc *doc);
+void json_free(struct json_doc *doc);
+
+/* Member @key of object @obj or NULL */
+struct json_value *json_get(const struct json_value *obj, const char *key);
+/* Like json_get() but exits when the member is missing or has the wrong type */
+struct json_value *json_need(const struct json_value *obj, const char *key, enum json_type type);
+
+#define json_for_each(pos, parent) \
+	for (pos = (parent)->child; pos; pos = pos->next)
+
+#endif /* _ABAC_NATIVE_JSON_H */
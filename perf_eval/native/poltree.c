@@ -0,0 +1,304 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "poltree.h"
+
+void builder_init(struct tree_builder *b, const struct dataset *d)
+{
+	b->d = d;
+	b->t = NULL;
+	b->stamp = xcalloc(d->strs.count, sizeof(*b->stamp));
+	b->weight = xcalloc(d->strs.count, sizeof(*b->weight));
+	b->cur = 0;
+}
+
+void builder_free(struct tree_builder *b)
+{
+	free(b->stamp);
+	free(b->weight);
+}
+
+void tree_init(struct tree *t)
+{
+	t->nodes = NULL;
+	t->n = 0;
+	t->cap = 0;
+}
+
+void tree_free(struct tree *t)
+{
+	free(t->nodes);
+	tree_init(t);
+}
+
+/* Start a new generation of marks in the stamp table */
+static uint32_t next_stamp(struct tree_builder *b)
+{
+	if (++b->cur == 0) {
+		memset(b->stamp, 0, b->d->strs.count * sizeof(*b->stamp));
+		b->cur = 1;
+	}
+	return b->cur;
+}
+
+/* Value of @a in the user part of @r, then in its environmental part */
+static uint32_t rule_value(const struct rule *r, uint32_t a)
+{
+	uint32_t v = avp_list_get(&r->user, a);
+
+	if (v == NO_VALUE)
+		v = avp_list_get(&r->env, a);
+	return v;
+}
+
+/* Value of @a seen by a request, from the user attributes or the current environment */
+static uint32_t request_value(const struct dataset *d, const struct request *req, uint32_t a)
+{
+	uint32_t v = avp_list_get(&d->users[req->user].attrs, a);
+
+	if (v == NO_VALUE)
+		v = avp_list_get(&d->current_env, a);
+	return v;
+}
+
+/*
+ * Distinct values of @a in @rules in order of first appearance, see get_possible_values().
+ * The values stay marked with the current stamp until the next call.
+ */
+static uint32_t possible_values(struct tree_builder *b, uint32_t a, const uint32_t *rules,
+				uint32_t nrules, uint32_t *vals)
+{
+	uint32_t cur = next_stamp(b);
+	uint32_t i, v, n = 0;
+
+	for (i = 0; i < nrules; i++) {
+		v = rule_value(&b->d->rules[rules[i]], a);
+		if (v == NO_VALUE || b->stamp[v] == cur)
+			continue;
+		b->stamp[v] = cur;
+		vals[n++] = v;
+	}
+	return n;
+}
+
+/*
+ * Share of users holding @v, or of environmental states when no user does. This is
+ * what max_entropy_attr() computes by scanning every entity, read from the counting
+ * tables instead.
+ */
+static double value_prob(const struct dataset *d, uint32_t v)
+{
+	if (d->user_count[v])
+		return (double)d->user_count[v] / d->nusers;
+	if (d->nenvs)
+		return (double)d->env_count[v] / d->nenvs;
+	return 0;
+}
+
+static uint32_t max_entropy_attr(struct tree_builder *b, const uint32_t *attrs, uint32_t nattrs,
+				 const uint32_t *rules, uint32_t nrules, uint32_t *vals)
+{
+	double max_entropy = -INFINITY, entropy, prob;
+	uint32_t max_attr = attrs[0];
+	uint32_t i, j, n;
+
+	for (i = 0; i < nattrs; i++) {
+		n = possible_values(b, attrs[i], rules, nrules, vals);
+		entropy = 0;
+		for (j = 0; j < n; j++) {
+			prob = value_prob(b->d, vals[j]);
+			if (prob != 0)
+				entropy += -1 * (prob * log(prob));
+		}
+		if (entropy > max_entropy) {
+			max_entropy = entropy;
+			max_attr = attrs[i];
+		}
+	}
+	return max_attr;
+}
+
+/* See min_cost_attr() in tree.py */
+static uint32_t min_cost_attr(struct tree_builder *b, const uint32_t *attrs, uint32_t nattrs,
+			      const uint32_t *rules, uint32_t nrules,
+			      const struct request *reqs, uint32_t nreqs, uint32_t *vals)
+{
+	double best_entropy = 0, entropy, prob, total = 0;
+	uint64_t best_stopped = 0, stopped;
+	uint32_t best_attr = NO_VALUE;
+	uint32_t i, j, n, v;
+
+	for (j = 0; j < nreqs; j++)
+		total += reqs[j].weight;
+	for (i = 0; i < nattrs; i++) {
+		n = possible_values(b, attrs[i], rules, nrules, vals);
+		for (j = 0; j < n; j++)
+			b->weight[vals[j]] = 0;
+		stopped = 0;
+		for (j = 0; j < nreqs; j++) {
+			v = request_value(b->d, &reqs[j], attrs[i]);
+			if (v != NO_VALUE && b->stamp[v] == b->cur)
+				b->weight[v] += reqs[j].weight;
+			else
+				stopped += reqs[j].weight;
+		}
+		entropy = 0;
+		for (j = 0; j < n; j++) {
+			if (!b->weight[vals[j]])
+				continue;
+			prob = b->weight[vals[j]] / total;
+			entropy += -1 * (prob * log(prob));
+		}
+		if (best_attr == NO_VALUE || stopped > best_stopped ||
+		    (stopped == best_stopped && entropy > best_entropy)) {
+			best_attr = attrs[i];
+			best_stopped = stopped;
+			best_entropy = entropy;
+		}
+	}
+	return best_attr;
+}
+
+static uint32_t add_node(struct tree *t, int32_t pid, uint32_t value)
+{
+	struct tree_node *n;
+
+	t->nodes = grow(t->nodes, &t->cap, t->n + 1, sizeof(*t->nodes));
+	n = &t->nodes[t->n];
+	n->pid = pid;
+	n->value = value;
+	n->attr = NO_VALUE;
+	n->op = NULL;
+	return t->n++;
+}
+
+static void build_r(struct tree_builder *b, const uint32_t *attrs, uint32_t nattrs,
+		    const uint32_t *rules, uint32_t nrules,
+		    const struct request *reqs, uint32_t nreqs, int32_t pid, uint32_t pval)
+{
+	const struct dataset *d = b->d;
+	uint32_t nid = add_node(b->t, pid, pval);
+	uint32_t *vals, *child_attrs, *child_rules;
+	struct request *child_reqs = NULL;
+	uint64_t *val_weight = NULL, w;
+	uint32_t a, nvals, i, j, n, nc, nr, v;
+
+	if (nattrs == 0) {
+		b->t->nodes[nid].op = d->rules[rules[0]].op;
+		return;
+	}
+	vals = xmalloc(nrules * sizeof(*vals));
+	if (nreqs)
+		a = min_cost_attr(b, attrs, nattrs, rules, nrules, reqs, nreqs, vals);
+	else
+		a = max_entropy_attr(b, attrs, nattrs, rules, nrules, vals);
+	b->t->nodes[nid].attr = a;
+	nvals = possible_values(b, a, rules, nrules, vals);
+
+	if (nreqs) {
+		/*
+		 * The kernel inserts each branch at the head of its parent's list, so the
+		 * branch serialized last is compared first. Order branches by ascending
+		 * request weight, stable like sorted() in tree.py.
+		 */
+		val_weight = xmalloc(nvals * sizeof(*val_weight));
+		for (i = 0; i < nvals; i++)
+			b->weight[vals[i]] = 0;
+		for (j = 0; j < nreqs; j++) {
+			v = request_value(d, &reqs[j], a);
+			if (v != NO_VALUE && b->stamp[v] == b->cur)
+				b->weight[v] += reqs[j].weight;
+		}
+		for (i = 0; i < nvals; i++)
+			val_weight[i] = b->weight[vals[i]];
+		for (i = 1; i < nvals; i++) {
+			v = vals[i];
+			w = val_weight[i];
+			for (j = i; j > 0 && val_weight[j - 1] > w; j--) {
+				vals[j] = vals[j - 1];
+				val_weight[j] = val_weight[j - 1];
+			}
+			vals[j] = v;
+			val_weight[j] = w;
+		}
+		child_reqs = xmalloc(nreqs * sizeof(*child_reqs));
+	}
+
+	child_attrs = xmalloc(nattrs * sizeof(*child_attrs));
+	for (i = 0, nc = 0; i < nattrs; i++)
+		if (attrs[i] != a)
+			child_attrs[nc++] = attrs[i];
+	child_rules = xmalloc(nrules * sizeof(*child_rules));
+
+	for (i = 0; i < nvals; i++) {
+		for (j = 0, n = 0; j < nrules; j++)
+			if (rule_value(&d->rules[rules[j]], a) == vals[i])
+				child_rules[n++] = rules[j];
+		for (j = 0, nr = 0; j < nreqs; j++)
+			if (request_value(d, &reqs[j], a) == vals[i])
+				child_reqs[nr++] = reqs[j];
+		build_r(b, child_attrs, nc, child_rules, n, child_reqs, nr, nid, vals[i]);
+	}
+
+	free(child_rules);
+	free(child_attrs);
+	free(child_reqs);
+	free(val_weight);
+	free(vals);
+}
+
+void build_tree(struct tree_builder *b, struct tree *t, const uint32_t *rules, uint32_t nrules,
+		const struct request *reqs, uint32_t nreqs)
+{
+	const struct avp_list *l;
+	uint32_t *attrs, nattrs = 0, cur, i, j, part;
+
+	t->n = 0;
+	b->t = t;
+	if (nrules == 0)
+		return;
+
+	/* User attributes of the covering rules first, then environmental ones */
+	for (i = 0; i < nrules; i++)
+		nattrs += b->d->rules[rules[i]].user.n + b->d->rules[rules[i]].env.n;
+	attrs = xmalloc(nattrs * sizeof(*attrs));
+	nattrs = 0;
+	cur = next_stamp(b);
+	for (part = 0; part < 2; part++) {
+		for (i = 0; i < nrules; i++) {
+			l = part ? &b->d->rules[rules[i]].env : &b->d->rules[rules[i]].user;
+			for (j = 0; j < l->n; j++) {
+				if (b->stamp[l->avps[j].attr] == cur)
+					continue;
+				b->stamp[l->avps[j].attr] = cur;
+				attrs[nattrs++] = l->avps[j].attr;
+			}
+		}
+	}
+
+	build_r(b, attrs, nattrs, rules, nrules, reqs, nreqs, -1, NO_VALUE);
+	free(attrs);
+}
+
+void format_tree(struct sbuf *sb, const struct dataset *d, const struct tree *t, int enc)
+{
+	const struct tree_node *n;
+	uint32_t i;
+
+	sbuf_printf(sb, "%u", t->n);
+	for (i = 0; i < t->n; i++) {
+		n = &t->nodes[i];
+		if (n->pid < 0) {
+			sbuf_printf(sb, "|%u - - ", i);
+		} else {
+			sbuf_printf(sb, "|%u %d ", i, n->pid);
+			format_str(sb, d, n->value, enc);
+			sbuf_putc(sb, ' ');
+		}
+		if (n->attr != NO_VALUE)
+			format_str(sb, d, n->attr, enc);
+		else
+			sbuf_puts(sb, n->op);
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef _ABAC_NATIVE_POLTREE_H
+#define _ABAC_NATIVE_POLTREE_H
+
+#include <stdint.h>
+
+#include "dataset.h"
+
+/*
+ * PolTree builder, a native port of build_attr_tree() and build_weighted_attr_tree()
+ * in tree.py. Nodes are stored in creation order, which is the DFS preorder the
+ * serialized format and the kernel parser expect.
+ */
+
+struct tree_node {
+	int32_t pid;		/* parent node, -1 for the root */
+	uint32_t value;		/* value of the parent attribute leading here */
+	uint32_t attr;		/* attribute tested here or NO_VALUE for a leaf */
+	const char *op;		/* operation of a leaf */
+};
+
+struct tree {
+	struct tree_node *nodes;
+	uint32_t n;
+	size_t cap;
+};
+
+/* A traced access request, see load_trace() in generate_tree_abacfs.py */
+struct request {
+	uint32_t user;
+	uint64_t weight;
+};
+
+/* Per-thread scratch space, sized by the string table of the dataset */
+struct tree_builder {
+	const struct dataset *d;
+	struct tree *t;
+	uint32_t *stamp;
+	uint32_t cur;
+	uint64_t *weight;
+};
+
+void builder_init(struct tree_builder *b, const struct dataset *d);
+void builder_free(struct tree_builder *b);
+
+void tree_init(struct tree *t);
+void tree_free(struct tree *t);
+
+/*
+ * Build the tree of an object covered by @rules (ids in policy order) into @t.
+ * When @nreqs is not zero the tree is ordered for the traced @reqs.
+ */
+void build_tree(struct tree_builder *b, struct tree *t, const uint32_t *rules, uint32_t nrules,
+		const struct request *reqs, uint32_t nreqs);
+
+/* Append the serialized form of @t, "n|nid pid value attr|...", original or encoded */
+void format_tree(struct sbuf *sb, const struct dataset *d, const struct tree *t, int enc);
+
+#endif /* _ABAC_NATIVE_POLTREE_H */
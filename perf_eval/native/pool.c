@@ -0,0 +1,80 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "util.h"
+
+struct pool {
+	const struct pool_ops *ops;
+	void *ctx;
+	pthread_barrier_t start;
+	pthread_barrier_t done;
+	int finished;
+	uint32_t chunk_start;
+	uint32_t chunk_end;
+	uint32_t next;
+};
+
+static void *pool_worker(void *arg)
+{
+	struct pool *p = arg;
+	void *state = p->ops->thread_init ? p->ops->thread_init(p->ctx) : NULL;
+	uint32_t i;
+
+	for (;;) {
+		pthread_barrier_wait(&p->start);
+		if (p->finished)
+			break;
+		while ((i = __atomic_fetch_add(&p->next, 1, __ATOMIC_RELAXED)) < p->chunk_end)
+			p->ops->work(p->ctx, state, i, i - p->chunk_start);
+		pthread_barrier_wait(&p->done);
+	}
+	if (p->ops->thread_free)
+		p->ops->thread_free(p->ctx, state);
+	return NULL;
+}
+
+void run_pool(uint32_t n, uint32_t chunk, long nthreads, const struct pool_ops *ops, void *ctx)
+{
+	struct pool p = {
+		.ops = ops,
+		.ctx = ctx,
+	};
+	pthread_t *threads;
+	long i;
+
+	if (nthreads < 1)
+		nthreads = 1;
+	pthread_barrier_init(&p.start, NULL, nthreads + 1);
+	pthread_barrier_init(&p.done, NULL, nthreads + 1);
+	threads = xmalloc(nthreads * sizeof(*threads));
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&threads[i], NULL, pool_worker, &p))
+			die("failed to create worker thread");
+
+	for (p.chunk_start = 0; p.chunk_start < n; p.chunk_start = p.chunk_end) {
+		p.chunk_end = p.chunk_start + chunk;
+		if (p.chunk_end > n || p.chunk_end < p.chunk_start)
+			p.chunk_end = n;
+		p.next = p.chunk_start;
+		pthread_barrier_wait(&p.start);
+		pthread_barrier_wait(&p.done);
+		if (ops->flush)
+			ops->flush(ctx, p.chunk_start, p.chunk_end);
+	}
+	p.finished = 1;
+	pthread_barrier_wait(&p.start);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_barrier_destroy(&p.start);
+	pthread_barrier_destroy(&p.done);
+}
+
+long default_threads(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? n : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef _ABAC_NATIVE_POOL_H
+#define _ABAC_NATIVE_POOL_H
+
+#include <stdint.h>
+
+/*
+ * Process items 0 .. n - 1 in chunks with a pool of threads
+ *
+ * Workers claim items of the current chunk from a shared counter and call @work with
+ * the item and its slot in the chunk. Once a chunk is complete the calling thread
+ * runs @flush, which can write per-slot results in item order, before the next chunk
+ * starts.
+ */
+struct pool_ops {
+	/* Per-thread state, optional */
+	void *(*thread_init)(void *ctx);
+	void (*thread_free)(void *ctx, void *state);
+	void (*work)(void *ctx, void *state, uint32_t item, uint32_t slot);
+	void (*flush)(void *ctx, uint32_t start, uint32_t end);
+};
+
+void run_pool(uint32_t n, uint32_t chunk, long nthreads, const struct pool_ops *ops, void *ctx);
+/* Number of worker threads to use when none is given */
+long default_threads(void);
+
+#endif /* _ABAC_NATIVE_POOL_H */
@@ -0,0 +1,171 @@
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "util.h"
+
+void die(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	exit(1);
+}
+
+void *xmalloc(size_t size)
+{
+	void *p = malloc(size ? size : 1);
+
+	if (!p)
+		die("out of memory allocating %zu bytes", size);
+	return p;
+}
+
+void *xcalloc(size_t n, size_t size)
+{
+	void *p = calloc(n ? n : 1, size ? size : 1);
+
+	if (!p)
+		die("out of memory allocating %zu x %zu bytes", n, size);
+	return p;
+}
+
+void *xrealloc(void *ptr, size_t size)
+{
+	void *p = realloc(ptr, size ? size : 1);
+
+	if (!p)
+		die("out of memory allocating %zu bytes", size);
+	return p;
+}
+
+char *xstrdup(const char *s)
+{
+	size_t len = strlen(s) + 1;
+
+	return memcpy(xmalloc(len), s, len);
+}
+
+void *grow(void *ptr, size_t *cap, size_t need, size_t size)
+{
+	size_t cap_new;
+
+	if (need <= *cap)
+		return ptr;
+	cap_new = *cap ? *cap : 16;
+	while (cap_new < need)
+		cap_new *= 2;
+	*cap = cap_new;
+	return xrealloc(ptr, cap_new * size);
+}
+
+void sbuf_init(struct sbuf *sb)
+{
+	sb->buf = NULL;
+	sb->len = 0;
+	sb->cap = 0;
+}
+
+void sbuf_free(struct sbuf *sb)
+{
+	free(sb->buf);
+	sbuf_init(sb);
+}
+
+void sbuf_reset(struct sbuf *sb)
+{
+	sb->len = 0;
+	if (sb->buf)
+		sb->buf[0] = '\0';
+}
+
+void sbuf_add(struct sbuf *sb, const char *s, size_t len)
+{
+	sb->buf = grow(sb->buf, &sb->cap, sb->len + len + 1, 1);
+	memcpy(sb->buf + sb->len, s, len);
+	sb->len += len;
+	sb->buf[sb->len] = '\0';
+}
+
+void sbuf_puts(struct sbuf *sb, const char *s)
+{
+	sbuf_add(sb, s, strlen(s));
+}
+
+void sbuf_putc(struct sbuf *sb, char c)
+{
+	sbuf_add(sb, &c, 1);
+}
+
+void sbuf_printf(struct sbuf *sb, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	sb->buf = grow(sb->buf, &sb->cap, sb->len + n + 1, 1);
+	va_start(ap, fmt);
+	vsnprintf(sb->buf + sb->len, n + 1, fmt, ap);
+	va_end(ap);
+	sb->len += n;
+}
+
+void sbuf_chop(struct sbuf *sb)
+{
+	if (sb->len == 0)
+		return;
+	sb->buf[--sb->len] = '\0';
+}
+
+char *read_file(const char *fname, size_t *len)
+{
+	FILE *f = xfopen(fname, "rb");
+	size_t cap = 0, n = 0, r;
+	char *buf = NULL;
+
+	do {
+		buf = grow(buf, &cap, n + (1 << 20) + 1, 1);
+		r = fread(buf + n, 1, cap - n - 1, f);
+		n += r;
+	} while (r > 0);
+	if (ferror(f))
+		die("error reading %s", fname);
+	fclose(f);
+	buf[n] = '\0';
+	*len = n;
+	return buf;
+}
+
+void mkdir_p(const char *path)
+{
+	char *p = xstrdup(path);
+	char *c;
+
+	for (c = p + 1; *c; c++) {
+		if (*c != '/')
+			continue;
+		*c = '\0';
+		if (mkdir(p, 0755) && errno != EEXIST)
+			die("mkdir %s: %s", p, strerror(errno));
+		*c = '/';
+	}
+	if (mkdir(p, 0755) && errno != EEXIST)
+		die("mkdir %s: %s", p, strerror(errno));
+	free(p);
+}
+
+FILE *xfopen(const char *fname, const char *mode)
+{
+	FILE *f = fopen(fname, mode);
+
+	if (!f)
+		die("%s: %s", fname, strerror(errno));
+	return f;
+}
@@ -0,0 +1,41 @@
+#ifndef _ABAC_NATIVE_UTIL_H
+#define _ABAC_NATIVE_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Allocation helpers that exit on failure, the tools have no way to recover */
+void *xmalloc(size_t size);
+void *xcalloc(size_t n, size_t size);
+void *xrealloc(void *ptr, size_t size);
+char *xstrdup(const char *s);
+void die(const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+/* Grow @ptr (holding @cap elements of @size bytes) so that it can hold @need elements */
+void *grow(void *ptr, size_t *cap, size_t need, size_t size);
+
+/* Growable string buffer used to build output lines */
+struct sbuf {
+	char *buf;
+	size_t len;
+	size_t cap;
+};
+
+void sbuf_init(struct sbuf *sb);
+void sbuf_free(struct sbuf *sb);
+void sbuf_reset(struct sbuf *sb);
+void sbuf_add(struct sbuf *sb, const char *s, size_t len);
+void sbuf_puts(struct sbuf *sb, const char *s);
+void sbuf_putc(struct sbuf *sb, char c);
+void sbuf_printf(struct sbuf *sb, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+/* Remove the last character, mirrors the data[:-1] idiom of the python generators */
+void sbuf_chop(struct sbuf *sb);
+
+/* Read a whole file into a NUL terminated buffer */
+char *read_file(const char *fname, size_t *len);
+/* Create @path and all its parents */
+void mkdir_p(const char *path);
+FILE *xfopen(const char *fname, const char *mode);
+
+#endif /* _ABAC_NATIVE_UTIL_H */
@@ -2,10 +2,14 @@
 import sys
 import json
 import os
+import glob
+import random
 import statistics
+import struct
+import subprocess
 from time import perf_counter_ns
 
-KERNEL_MODELS = ['abac_trees', 'abac_trees_enc', 'abac_rules', 'abac_rules_enc'] 
+KERNEL_MODELS = ['abac_trees', 'abac_trees_enc', 'abac_rules', 'abac_rules_enc', 'abac_adaptive', 'abac_adaptive_enc', 'abac_mdd', 'abac_mdd_enc', 'abac_index', 'abac_index_enc'] 
 ITERATIONS = 50
 
 def load_data(u_path, k_path):
@@ -31,17 +35,36 @@ def stop_recording():
     #print("Kernel recording stopped...")
 
 
-def get_kernel_time():
-    # get access times measured inside kernel module
-    with open('/sys/kernel/security/abac/perf') as f:
-        t = f.read()
-    # t contains the time in nanoseconds followed by newline
-    t = t.strip()
-    # Return time in milliseconds
-    #return int(t)/1000000
-    return int(t)
+# struct abac_sample in security/abac/include/samples.h
+# timestamp, ns, uid, cpu, op, allowed
+SAMPLE = struct.Struct('=QQIHBB')
+
+def get_kernel_times():
+    # get access times measured inside kernel module while recording
+    # one sample per check, a read of a file may be checked more than once
+    # the samples files are only readable by root, the benchmark itself runs
+    # as a regular user so the buffers are read through sudo
+    samples = []
+    for fname in glob.glob('/sys/kernel/security/abac/samples*'):
+        if os.geteuid() == 0:
+            with open(fname, 'rb') as f:
+                data = f.read()
+        else:
+            data = subprocess.run(['sudo', '-n', 'cat', fname], check=True,
+                                  stdout=subprocess.PIPE).stdout
+        samples.extend(SAMPLE.iter_unpack(data[:len(data) - len(data) % SAMPLE.size]))
+    samples.sort()
+    return [s[1] for s in samples]
+
+def select_engine(kernel_model):
+    # Switch the LSM to the engine of the model, this unloads any loaded data
+    with open('/sys/kernel/security/abac/engine', 'w') as f:
+        f.write(kernel_model[len('abac_'):])
 
 def load_into_kernel(data_path, kernel_model):
+    if kernel_model not in KERNEL_MODELS:
+        sys.exit(f"invalid kernel model\nValid models - {KERNEL_MODELS}")
+    select_engine(kernel_model)
     print("\nLoading data...")
     if kernel_model == "abac_trees":
         load_data(f'{data_path}/trees/original/user_attr', '/sys/kernel/security/abac/user_attr')
@@ -51,16 +74,26 @@ def load_into_kernel(data_path, kernel_model):
         load_data(f'{data_path}/trees/encoded/user_attr', '/sys/kernel/security/abac/user_attr')
         load_data(f'{data_path}/trees/encoded/env_attr', '/sys/kernel/security/abac/env_attr')
         load_data(f'{data_path}/trees/encoded/obj_attr', '/sys/kernel/security/abac/obj_attr')
-    elif kernel_model == "abac_rules":
+    elif kernel_model in ("abac_rules", "abac_adaptive", "abac_mdd"):
         load_data(f'{data_path}/rules/original/user_attr', '/sys/kernel/security/abac/user_attr')
         load_data(f'{data_path}/rules/original/env_attr', '/sys/kernel/security/abac/env_attr')
         load_data(f'{data_path}/rules/original/obj_rules', '/sys/kernel/security/abac/obj_rules')
         load_data(f'{data_path}/rules/original/policy', '/sys/kernel/security/abac/policy')
-    elif kernel_model == "abac_rules_enc":
+    elif kernel_model in ("abac_rules_enc", "abac_adaptive_enc", "abac_mdd_enc"):
         load_data(f'{data_path}/rules/encoded/user_attr', '/sys/kernel/security/abac/user_attr')
         load_data(f'{data_path}/rules/encoded/env_attr', '/sys/kernel/security/abac/env_attr')
         load_data(f'{data_path}/rules/encoded/obj_rules', '/sys/kernel/security/abac/obj_rules')
         load_data(f'{data_path}/rules/encoded/policy', '/sys/kernel/security/abac/policy')
+    elif kernel_model == "abac_index":
+        load_data(f'{data_path}/rules/original/user_attr', '/sys/kernel/security/abac/user_attr')
+        load_data(f'{data_path}/rules/original/env_attr', '/sys/kernel/security/abac/env_attr')
+        load_data(f'{data_path}/rules/original/obj_attrs', '/sys/kernel/security/abac/obj_attrs')
+        load_data(f'{data_path}/rules/original/policy', '/sys/kernel/security/abac/policy')
+    elif kernel_model == "abac_index_enc":
+        load_data(f'{data_path}/rules/encoded/user_attr', '/sys/kernel/security/abac/user_attr')
+        load_data(f'{data_path}/rules/encoded/env_attr', '/sys/kernel/security/abac/env_attr')
+        load_data(f'{data_path}/rules/encoded/obj_attrs', '/sys/kernel/security/abac/obj_attrs')
+        load_data(f'{data_path}/rules/encoded/policy', '/sys/kernel/security/abac/policy')
     else:
         sys.exit(f"invalid kernel model\nValid models - {KERNEL_MODELS}")
     print("\nData loaded into the kernel")
@@ -106,11 +139,10 @@ def main(config_path, data_path, kernel_model, dac_only=False):
             end = perf_counter_ns()
             # User time is counted per access
             user_time.append(end - start)
-            # get kernel time 
-            kernel_time.append(get_kernel_time())
     # Turn off recording mode in kernel
     if not dac_only:
         stop_recording()
+        kernel_time = get_kernel_times()
 
     # performance statistics
     stats = {}
@@ -161,7 +193,7 @@ def main(config_path, data_path, kernel_model, dac_only=False):
 if __name__ == "__main__":
     if len(sys.argv) < 4:
         sys.exit(f"Invalid Usage\npython3 {sys.argv[0]} <config_path> <data_path> <kernel_model> <dac_only>\
-                \nKernel model is the ABAC lsm that is currently loaded. Must be one of abac_trees, abac_trees_enc, abac_rules, abac_rules_enc")
+                \nKernel model is the ABAC engine to evaluate. Must be one of abac_trees, abac_trees_enc, abac_rules, abac_rules_enc, abac_adaptive, abac_adaptive_enc, abac_mdd, abac_mdd_enc, abac_index, abac_index_enc")
     if len(sys.argv) == 5:
         main(sys.argv[1], sys.argv[2], sys.argv[3], True)
     else:
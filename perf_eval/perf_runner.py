@@ -35,7 +35,7 @@ def main(kernel_model, dac_only=False):
 if __name__ == "__main__":
     if len(sys.argv) < 3:
         sys.exit(f"Invalid Usage\npython3 {sys.argv[0]} <kernel_model>\
-                \nKernel model is the ABAC lsm that is currently loaded. Must be one of abac_trees, abac_trees_enc, abac_rules, abac_rules_enc")
+                \nKernel model is the ABAC engine to evaluate. Must be one of abac_trees, abac_trees_enc, abac_rules, abac_rules_enc, abac_adaptive, abac_adaptive_enc, abac_mdd, abac_mdd_enc, abac_index, abac_index_enc")
     if len(sys.argv) == 3:
         main(sys.argv[1], dac_only=True)
     else:
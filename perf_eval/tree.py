@@ -95,6 +95,89 @@ def build_attr_tree_r(attributes, rules, umap, emap, nid):
         child.parent = n
     return n
 
+def get_request_value(a, uid, umap, current_env):
+    """
+    Value of attribute @a seen by an access request of user @uid
+    User attributes come from the user mapping, environmental ones from the current environment
+    """
+    if a in umap[uid]:
+        return umap[uid][a]
+    return current_env.get(a)
+
+def min_cost_attr(attributes, rules, umap, current_env, requests):
+    """
+    Get the attribute that minimises the expected traversal cost of the traced @requests
+    reaching this node, and also return its possible values.
+    @requests is a list of (uid, weight) pairs.
+
+    Every path that grants access goes through all attributes, so the order of attributes only
+    changes how early denied requests stop. The chosen attribute is the one whose branches are
+    missed by the largest weight of requests (they stop at this node). Ties are broken by the
+    weighted entropy of the requests that continue, so hot requests are spread over branches.
+    """
+    total = sum(w for _, w in requests)
+    best_key = None
+    best_attr = None
+    best_vals = None
+    for a in attributes:
+        vals = get_possible_values(a, rules)
+        stopped = 0
+        branch_weight = {}
+        for uid, w in requests:
+            v = get_request_value(a, uid, umap, current_env)
+            if v in vals:
+                branch_weight[v] = branch_weight.get(v, 0) + w
+            else:
+                stopped += w
+        entropy = 0
+        for w in branch_weight.values():
+            prob = w / total
+            entropy += -1 * (prob * math.log(prob))
+        key = (stopped, entropy)
+        if best_key is None or key > best_key:
+            best_key = key
+            best_attr = a
+            best_vals = vals
+    return best_attr, best_vals
+
+def build_weighted_attr_tree(attributes, rules, umap, emap, current_env, requests):
+    """
+    Build an attribute tree for an object using the access requests recorded for it.
+    @requests is a list of (uid, weight) pairs taken from the kernel access trace.
+    Sub-trees that no traced request reaches fall back to the entropy based selection.
+    """
+    requests = [(uid, w) for uid, w in requests if uid in umap]
+    return build_weighted_attr_tree_r(attributes, rules, umap, emap, current_env, requests, [0])
+
+def build_weighted_attr_tree_r(attributes, rules, umap, emap, current_env, requests, nid):
+    """
+    Recursive method to build attribute tree weighted by traced access requests
+    """
+    if len(attributes) == 0:
+        return AttrNode(nid[0], op = rules[0]["op"])
+    if len(requests) == 0:
+        a, vals = max_entropy_attr(attributes, rules, umap, emap)
+    else:
+        a, vals = min_cost_attr(attributes, rules, umap, current_env, requests)
+    n = AttrNode(nid[0], attr = a)
+    # Split the requests over the branches of this node
+    child_requests = {v: [] for v in vals}
+    for uid, w in requests:
+        v = get_request_value(a, uid, umap, current_env)
+        if v in child_requests:
+            child_requests[v].append((uid, w))
+    # The kernel inserts each branch at the head of its parent's branch list, so the
+    # branch serialized last is compared first. Add the hottest branch last.
+    vals = sorted(vals, key=lambda v: sum(w for _, w in child_requests[v]))
+    for v in vals:
+        child_rules = filter_rules(a, v, rules)
+        child_attributes = [x for x in attributes if x != a]
+        nid[0] += 1
+        child = build_weighted_attr_tree_r(child_attributes, child_rules, umap, emap, current_env, child_requests[v], nid)
+        n.add_child(v, child)
+        child.parent = n
+    return n
+
 def count_nodes(tree):
     """
     Recursive method to count number of nodes in the tree
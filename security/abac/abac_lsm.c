@@ -0,0 +1,366 @@
+#include <linux/limits.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include <linux/fs.h>
+#include <linux/lsm_hooks.h>
+#include <linux/timekeeping.h>
+#include <linux/dcache.h>
+#include <linux/rcupdate.h>
+#include <linux/seqlock.h>
+#include <linux/cred.h>
+#include <linux/xattr.h>
+#include "abacfs.h"
+#include "access_trace.h"
+#include "latency_hist.h"
+#include "samples.h"
+#define CREATE_TRACE_POINTS
+#include "abac_trace.h"
+
+static const char* secured_dir = "/home/secured/";
+static const int secured_dir_len = 14;
+/* Components of secured_dir */
+static const char *const secured_names[] = { "home", "secured" };
+#define SECURED_DEPTH ARRAY_SIZE(secured_names)
+
+// Check if path is secured
+int is_secured(char *accessed_path)
+{
+	if (strncmp(secured_dir, accessed_path, secured_dir_len) == 0) {
+		return 1;
+	}
+	return 0;
+}
+
+static int __is_secured_dentry(struct dentry *dentry)
+{
+	/* Same as is_secured() on the path dentry_path_raw() would build */
+	struct dentry *top[SECURED_DEPTH], *d;
+	unsigned int depth = 0, i;
+
+	/* Keep the SECURED_DEPTH ancestors closest to the root */
+	for (d = dentry; !IS_ROOT(d); d = READ_ONCE(d->d_parent)) {
+		for (i = SECURED_DEPTH - 1; i > 0; i--) {
+			top[i] = top[i - 1];
+		}
+		top[0] = d;
+		depth++;
+	}
+	if (depth <= SECURED_DEPTH) {
+		return 0;
+	}
+	for (i = 0; i < SECURED_DEPTH; i++) {
+		if (strcmp((const char *)smp_load_acquire(&top[i]->d_name.name), secured_names[i])) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Check if the path of a dentry is secured without building it
+static int is_secured_dentry(struct dentry *dentry)
+{
+	unsigned int seq;
+	int secured;
+
+	rcu_read_lock();
+	do {
+		seq = read_seqbegin(&rename_lock);
+		secured = __is_secured_dentry(dentry);
+	} while (read_seqretry(&rename_lock, seq));
+	rcu_read_unlock();
+	return secured;
+}
+
+// get full filename
+char *get_full_name(struct file *file, char *buf, int buflen)
+{
+	struct dentry *dentry = file->f_path.dentry;
+	char *ret = dentry_path_raw(dentry, buf, buflen);
+	return ret;
+}
+
+/*
+ * Object attributes from extended attributes. For the engines with a
+ * lookup_xattr() op, a file with a security.abac xattr is decided with the
+ * object that the engine keeps for the value of the xattr, and files without
+ * one fall back to the entry of their path. The xattr is read on the first
+ * access to the inode and the object, the absence of the xattr or a value
+ * the engine has no object for, is cached in the inode security blob. Files
+ * with such a value are denied. Setting the xattr drops the cached object and
+ * bumps the generation of the blob, so the next access reads it again and a
+ * fill that read the previous value does not stay. Removing it caches its
+ * absence. Engines never free the objects they return, so a blob never points
+ * at freed memory, whatever engine and policy are loaded since it was filled.
+ */
+#define XATTR_NAME_ABAC XATTR_SECURITY_PREFIX "abac"
+#define ABAC_XATTR_MAX 256
+
+struct abac_inode {
+	/* Object of the xattr, ERR_PTR(-ENODATA) if there is no xattr and
+	 * ERR_PTR(-EINVAL) if the engine has no object for its value */
+	void *obj;
+	/* Changes of the xattr */
+	atomic_t gen;
+};
+
+static struct lsm_blob_sizes abac_blob_sizes __lsm_ro_after_init = {
+	.lbs_inode = sizeof(struct abac_inode),
+};
+
+static struct abac_inode *abac_inode(const struct inode *inode)
+{
+	return inode->i_security + abac_blob_sizes.lbs_inode;
+}
+
+static void *lookup_xattr(const struct abac_engine *e, struct dentry *dentry)
+{
+	/* Object of the xattr of @dentry, an error pointer cached like one,
+	 * see struct abac_inode, or NULL if the xattr cannot be read now */
+	struct inode *inode = d_backing_inode(dentry);
+	struct abac_inode *isec = abac_inode(inode);
+	void *obj, *cur;
+	char *value;
+	int len, gen;
+
+	obj = smp_load_acquire(&isec->obj);
+	if (obj != NULL) {
+		return obj;
+	}
+	/* Read before the xattr, see set_xattr_obj() */
+	gen = atomic_read_acquire(&isec->gen);
+	value = kmalloc(ABAC_XATTR_MAX + 1, GFP_KERNEL);
+	if (!value) {
+		return NULL;
+	}
+	len = __vfs_getxattr(dentry, inode, XATTR_NAME_ABAC, value, ABAC_XATTR_MAX);
+	if (len == -ENODATA || len == -EOPNOTSUPP) {
+		obj = ERR_PTR(-ENODATA);
+	} else if (len == -ERANGE) {
+		/* Longer than any value an engine accepts */
+		obj = ERR_PTR(-EINVAL);
+	} else if (len >= 0) {
+		/* setfattr values often end with a newline */
+		while (len > 0 && (value[len - 1] == '\n' || value[len - 1] == '\0')) {
+			len--;
+		}
+		value[len] = '\0';
+		obj = e->lookup_xattr(value);
+	}
+	kfree(value);
+	if (obj == NULL) {
+		/* Not cached, the next access tries again */
+		return NULL;
+	}
+	cur = cmpxchg(&isec->obj, NULL, obj);
+	if (cur != NULL) {
+		return cur;
+	}
+	/* The xattr changed since it was read, the blob may have been dropped
+	 * before it was filled. The fully ordered cmpxchg() makes this check
+	 * see the change, or the change drop the blob after the fill */
+	if (atomic_read(&isec->gen) != gen) {
+		cmpxchg(&isec->obj, obj, NULL);
+	}
+	return obj;
+}
+
+static void *lookup_object(const struct abac_engine *e, struct dentry *dentry)
+{
+	void *obj;
+
+	if (e->lookup_xattr) {
+		obj = lookup_xattr(e, dentry);
+		if (obj != ERR_PTR(-ENODATA)) {
+			/* A value without object is denied, like an unknown path */
+			return IS_ERR(obj) ? NULL : obj;
+		}
+	}
+	return e->lookup_dentry(dentry);
+}
+
+static void set_xattr_obj(struct dentry *dentry, void *obj)
+{
+	/* Bump the generation before replacing the object, so a lookup_xattr()
+	 * that read the previous value either sees the new generation or has
+	 * its fill replaced here */
+	struct abac_inode *isec = abac_inode(d_backing_inode(dentry));
+
+	atomic_inc(&isec->gen);
+	smp_mb__after_atomic();
+	smp_store_release(&isec->obj, obj);
+}
+
+static void abac_inode_post_setxattr(struct dentry *dentry, const char *name,
+				     const void *value, size_t size, int flags)
+{
+	if (strcmp(name, XATTR_NAME_ABAC) == 0) {
+		set_xattr_obj(dentry, NULL);
+	}
+}
+
+static int abac_inode_removexattr(struct dentry *dentry, const char *name)
+{
+	/* Hooks returning 0 skip the default capability check of the xattr.
+	 * There is no hook after the removal, and a blob dropped here could be
+	 * filled again from the xattr before it is gone, so the blob is set to
+	 * no xattr once the removal is allowed */
+	int err = cap_inode_removexattr(dentry, name);
+
+	if (err == 0 && strcmp(name, XATTR_NAME_ABAC) == 0) {
+		set_xattr_obj(dentry, ERR_PTR(-ENODATA));
+	}
+	return err;
+}
+
+static enum operation get_op(int mask) {
+	/* Conver access bit mask into valid abac operation */
+	//printk("Mask: %d", mask);
+	switch (mask) {
+		case MAY_WRITE:
+		case MAY_APPEND:
+			return ABAC_MODIFY;
+		case MAY_READ:
+		//case MAY_OPEN:
+		//case MAY_ACCESS:
+			return ABAC_READ;
+	}
+	return ABAC_IGNORE;
+}
+
+// File read/write hook
+static int abac_file_permission(struct file *file, int mask)
+{
+	u64 start, end, diff, path_end = 0, user_end = 0, obj_end = 0;
+	bool stages = trace_abac_decision_enabled();
+	bool trace = READ_ONCE(tracing);
+	unsigned int uid;
+	char *path, *buff;
+	struct dentry *dentry;
+	const struct abac_engine *e;
+	void *obj;
+	avp *user_attr;
+	int decision, idx;
+	enum operation op;
+
+	uid = current_uid().val;
+	if (uid < 1000) {
+		return 0;
+	}
+	//start = ktime_get_real_ns();
+	start = ktime_get_ns();
+	dentry = file->f_path.dentry;
+	if (!is_secured_dentry(dentry)) {
+		return 0;
+	}
+	/* Objects are looked up from the dentry, the path is only built for
+	 * the access trace and the decision tracepoint */
+	path = (char *)secured_dir;
+	buff = NULL;
+	if (trace || stages) {
+		buff = kmalloc(PATH_MAX, GFP_KERNEL);
+		if (buff) {
+			path = dentry_path_raw(dentry, buff, PATH_MAX);
+			if (IS_ERR(path)) {
+				path = (char *)secured_dir;
+			}
+		}
+	}
+	if (stages) {
+		path_end = ktime_get_ns();
+	}
+	op = get_op(mask);
+	if (trace && op != ABAC_IGNORE) {
+		record_access(uid, path, op);
+	}
+
+	//printk("ABAC LSM: %d accessing %s\n", uid, path);
+	// operation
+	/*
+	if (op == ABAC_READ) {
+		printk("ABAC READ");
+	} else if (op == ABAC_MODIFY) {
+		printk("ABAC MODIFY");
+	} else {
+		printk("ABAC IGNORE");
+	}
+	*/
+	
+	idx = engine_read_lock();
+	e = get_engine();
+	if (e == NULL) {
+		/* The engine is being switched and nothing is loaded, DENY */
+		engine_read_unlock(idx);
+		kfree(buff);
+		return -EPERM;
+	}
+
+	// Print user attributes
+	user_attr = get_user_attrs(uid);
+	if (stages) {
+		user_end = ktime_get_ns();
+	}
+	//printk("User attributes");
+	//print_avp(user_attr);
+	//printk("-----------------------------------");
+	
+	// Print environmental attrs
+	//printk("Environmental attributes");
+	//print_avp(env_attr);
+	//printk("-----------------------------------");
+
+	// Print object rules
+	//printk("Object rules");
+	obj = lookup_object(e, dentry);
+	if (stages) {
+		obj_end = ktime_get_ns();
+	}
+	//printk("-----------------------------------");
+
+	decision = e->resolve(user_attr, obj, op);
+	//printk("decision: %s\n", decision == 1 ? "ALLOWED" : "DENIED");
+	//end = ktime_get_real_ns();
+	end = ktime_get_ns();
+	diff = end - start;
+	record_latency(decision == 1, op, diff);
+	if (stages) {
+		trace_abac_decision(e->name, uid, path, op, decision == 1, path_end - start,
+				    user_end - path_end, obj_end - user_end, end - obj_end);
+	}
+	engine_read_unlock(idx);
+	kfree(buff);
+	if (recording) {
+		prev_access_time = diff;
+		record_sample(start, uid, op, decision == 1, diff);
+		snprintf(perf_buf, 64, "%llu\n", prev_access_time);
+	}
+	return decision == 1 ? 0 : -EPERM;
+}
+
+// The hooks we wish to be installed.
+static struct security_hook_list abac_hooks[] __lsm_ro_after_init = {
+	LSM_HOOK_INIT(file_permission, abac_file_permission),
+	LSM_HOOK_INIT(inode_post_setxattr, abac_inode_post_setxattr),
+	LSM_HOOK_INIT(inode_removexattr, abac_inode_removexattr),
+};
+
+
+// Initialize our module.
+static int __init abac_init(void)
+{
+	const struct abac_engine *e = find_engine(CONFIG_SECURITY_ABAC_DEFAULT_ENGINE);
+
+	if (e == NULL) {
+		printk(KERN_ERR "ABAC LSM: Unknown engine %s, using rules\n", CONFIG_SECURITY_ABAC_DEFAULT_ENGINE);
+		e = &rules_engine;
+	}
+	set_engine(e);
+	security_add_hooks(abac_hooks, ARRAY_SIZE(abac_hooks), "abac");
+	printk(KERN_INFO "ABAC LSM: Initialized.\n Files in %s are protected by ABAC policy\n Engine: %s\n", secured_dir, e->name);
+	return 0;
+}
+
+DEFINE_LSM(abac) = {
+	.init = abac_init,
+	.name = "abac",
+	.blobs = &abac_blob_sizes,
+};
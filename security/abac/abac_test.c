@@ -0,0 +1,1013 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the evaluation engines
+ *
+ * Every suite selects one engine and every case loads a small fixed dataset through
+ * the same functions that back the securityfs files, then checks the decisions of
+ * engine_decide(). The datasets of the ten engines describe the same policy, so all
+ * suites expect the same decisions. Loading replaces the global user, object and
+ * policy tables, so the suites are only meant for test kernels run with kunit.py,
+ * where nothing else has been loaded.
+ *
+ * The bench case of every suite times a fixed loop of decisions and logs ns/decision
+ * so a slower engine shows up in the kunit.py output next to any change in decisions.
+ */
+#include <kunit/test.h>
+#include <linux/dcache.h>
+#include <linux/hash.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/timekeeping.h>
+#include "abacfs.h"
+#include "adaptive.h"
+#include "path_trie.h"
+
+struct abac_test_dataset {
+	const char *engine;
+	const char *user_attr;
+	const char *env_attr;
+	/* Environment of the env_change case */
+	const char *night_env;
+	const char *objects;
+	/* NULL for the tree engines */
+	const char *policy;
+};
+
+static const char test_user_attr[] =
+	"1000:role=doctor,dept=cardio\n"
+	"1001:role=nurse,dept=cardio\n"
+	"1002:role=doctor,dept=neuro\n";
+static const char test_env_attr[] = "shift=day\nsite=main";
+static const char test_night_env[] = "shift=night\nsite=main";
+/* Rule 4 is dominated by rule 1 and pruned from the lists that hold both */
+static const char test_policy[] =
+	"5\n"
+	"0:role=doctor,dept=cardio|shift=day|MODIFY|chart=cardio\n"
+	"1:role=nurse|shift=day,site=main|READ|chart=cardio,scan=mri\n"
+	"2:role=doctor|shift=night|MODIFY|scan=mri,notes=neuro\n"
+	"3:dept=neuro|site=main|READ|notes=neuro\n"
+	"4:role=nurse,dept=cardio|shift=day,site=main|READ|chart=cardio,scan=mri";
+static const char test_obj_rules[] =
+	"/home/secured/chart:0,4,1\n"
+	"/home/secured/scan:2,1\n"
+	"/home/secured/notes:2,3";
+/*
+ * ward is covered by enough rules for the adaptive engines to compile a tree,
+ * rounds by the same rules so the mdd engines give both the same root
+ */
+static const char test_compiled_obj_rules[] =
+	"/home/secured/chart:0,1\n"
+	"/home/secured/scan:2,1\n"
+	"/home/secured/notes:2,3\n"
+	"/home/secured/ward:0,1,2,3\n"
+	"/home/secured/rounds:3,2,1,0,2";
+/*
+ * The index engines derive the lists of test_obj_rules from the object pairs of the
+ * policy rules, ward has no attributes and is covered by all of them, no rule has
+ * both pairs of report
+ */
+static const char test_obj_attrs[] =
+	"/home/secured/chart:chart=cardio\n"
+	"/home/secured/scan:scan=mri\n"
+	"/home/secured/notes:notes=neuro\n"
+	"/home/secured/ward:\n"
+	"/home/secured/report:chart=cardio,notes=neuro";
+static const char test_obj_attr[] =
+	"/home/secured/chart:7|0 - - role|1 0 doctor dept|2 1 cardio shift|3 2 day MODIFY"
+	"|4 0 nurse shift|5 4 day site|6 5 main READ\n"
+	"/home/secured/scan:6|0 - - role|1 0 doctor shift|2 1 night MODIFY"
+	"|3 0 nurse shift|4 3 day site|5 4 main READ\n"
+	"/home/secured/notes:5|0 - - dept|1 0 neuro site|2 1 main READ"
+	"|3 0 cardio shift|4 3 night MODIFY";
+
+/*
+ * The same dataset with role=1, dept=2, shift=3, site=4, chart=5, scan=6, notes=7 and
+ * values numbered per attribute
+ */
+static const char test_enc_user_attr[] =
+	"1000:1=11,2=21\n"
+	"1001:1=12,2=21\n"
+	"1002:1=11,2=22\n";
+static const char test_enc_env_attr[] = "3=31\n4=41";
+static const char test_enc_night_env[] = "3=32\n4=41";
+static const char test_enc_policy[] =
+	"5\n"
+	"0:1=11,2=21|3=31|MODIFY|5=51\n"
+	"1:1=12|3=31,4=41|READ|5=51,6=61\n"
+	"2:1=11|3=32|MODIFY|6=61,7=71\n"
+	"3:2=22|4=41|READ|7=71\n"
+	"4:1=12,2=21|3=31,4=41|READ|5=51,6=61";
+static const char test_enc_obj_attrs[] =
+	"/home/secured/chart:5=51\n"
+	"/home/secured/scan:6=61\n"
+	"/home/secured/notes:7=71\n"
+	"/home/secured/ward:\n"
+	"/home/secured/report:5=51,7=71";
+static const char test_enc_obj_attr[] =
+	"/home/secured/chart:7|0 - - 1|1 0 11 2|2 1 21 3|3 2 31 MODIFY|4 0 12 3|5 4 31 4|6 5 41 READ\n"
+	"/home/secured/scan:6|0 - - 1|1 0 11 3|2 1 32 MODIFY|3 0 12 3|4 3 31 4|5 4 41 READ\n"
+	"/home/secured/notes:5|0 - - 2|1 0 22 4|2 1 41 READ|3 0 21 3|4 3 32 MODIFY";
+
+static const struct abac_test_dataset rules_dataset = {
+	"rules", test_user_attr, test_env_attr, test_night_env, test_obj_rules, test_policy,
+};
+static const struct abac_test_dataset rules_enc_dataset = {
+	"rules_enc", test_enc_user_attr, test_enc_env_attr, test_enc_night_env, test_obj_rules,
+	test_enc_policy,
+};
+static const struct abac_test_dataset trees_dataset = {
+	"trees", test_user_attr, test_env_attr, test_night_env, test_obj_attr, NULL,
+};
+static const struct abac_test_dataset trees_enc_dataset = {
+	"trees_enc", test_enc_user_attr, test_enc_env_attr, test_enc_night_env, test_enc_obj_attr,
+	NULL,
+};
+static const struct abac_test_dataset adaptive_dataset = {
+	"adaptive", test_user_attr, test_env_attr, test_night_env, test_compiled_obj_rules,
+	test_policy,
+};
+static const struct abac_test_dataset adaptive_enc_dataset = {
+	"adaptive_enc", test_enc_user_attr, test_enc_env_attr, test_enc_night_env,
+	test_compiled_obj_rules, test_enc_policy,
+};
+static const struct abac_test_dataset mdd_dataset = {
+	"mdd", test_user_attr, test_env_attr, test_night_env, test_compiled_obj_rules, test_policy,
+};
+static const struct abac_test_dataset mdd_enc_dataset = {
+	"mdd_enc", test_enc_user_attr, test_enc_env_attr, test_enc_night_env,
+	test_compiled_obj_rules, test_enc_policy,
+};
+static const struct abac_test_dataset index_dataset = {
+	"index", test_user_attr, test_env_attr, test_night_env, test_obj_attrs, test_policy,
+};
+static const struct abac_test_dataset index_enc_dataset = {
+	"index_enc", test_enc_user_attr, test_enc_env_attr, test_enc_night_env,
+	test_enc_obj_attrs, test_enc_policy,
+};
+
+#define BENCH_LOOPS 100000
+
+struct abac_test_data {
+	const struct abac_test_dataset *set;
+	const struct abac_engine *engine;
+	const struct abac_engine *saved_engine;
+	char *bufs[4];
+	avp *saved_env;
+};
+
+struct abac_test_request {
+	unsigned int uid;
+	const char *path;
+	enum operation op;
+	int allowed;
+};
+
+static const struct abac_test_request test_requests[] = {
+	{ 1000, "/home/secured/chart", ABAC_MODIFY, 1 },
+	{ 1000, "/home/secured/chart", ABAC_READ, 1 },
+	{ 1001, "/home/secured/chart", ABAC_READ, 1 },
+	{ 1001, "/home/secured/chart", ABAC_MODIFY, 0 },
+	{ 1002, "/home/secured/chart", ABAC_READ, 0 },
+	{ 1001, "/home/secured/scan", ABAC_READ, 1 },
+	{ 1002, "/home/secured/scan", ABAC_MODIFY, 0 },
+	{ 1002, "/home/secured/notes", ABAC_READ, 1 },
+	{ 1002, "/home/secured/notes", ABAC_MODIFY, 0 },
+	{ 1000, "/home/secured/notes", ABAC_READ, 0 },
+};
+
+static int decide(unsigned int uid, const char *path, enum operation op)
+{
+	return engine_decide(uid, (char *)path, op);
+}
+
+static char *test_dup(struct kunit *test, const char *s)
+{
+	char *buf = kstrdup(s, GFP_KERNEL);
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, buf);
+	return buf;
+}
+
+static int abac_test_load(struct kunit *test, const struct abac_test_dataset *set)
+{
+	struct abac_test_data *data;
+
+	data = kunit_kzalloc(test, sizeof(*data), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, data);
+	test->priv = data;
+	data->set = set;
+	data->engine = find_engine(set->engine);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, data->engine);
+	data->saved_engine = set_engine(data->engine);
+
+	/* Same order as perf_eval/perf.py, compile_policy() ranks with the users */
+	data->bufs[0] = test_dup(test, set->user_attr);
+	parse_user_attr(data->bufs[0]);
+	data->saved_env = env_attr;
+	data->bufs[1] = test_dup(test, set->env_attr);
+	env_attr = parse_env_attr(data->bufs[1]);
+	data->bufs[2] = test_dup(test, set->objects);
+	data->engine->load_objects(data->bufs[2]);
+	if (set->policy) {
+		data->bufs[3] = test_dup(test, set->policy);
+		data->engine->load_policy(data->bufs[3]);
+	}
+	return 0;
+}
+
+static void abac_test_exit(struct kunit *test)
+{
+	struct abac_test_data *data = test->priv;
+	int i;
+
+	if (data->set->policy)
+		data->engine->clear_policy();
+	data->engine->clear_objects();
+	clear_user_attrs();
+	clear_avp_list(env_attr);
+	env_attr = data->saved_env;
+	set_engine(data->saved_engine);
+	for (i = 0; i < ARRAY_SIZE(data->bufs); i++)
+		kfree(data->bufs[i]);
+}
+
+static void check_requests(struct kunit *test)
+{
+	const struct abac_test_request *req;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(test_requests); i++) {
+		req = &test_requests[i];
+		KUNIT_EXPECT_EQ_MSG(test, decide(req->uid, req->path, req->op), req->allowed,
+				    "uid %u path %s op %d", req->uid, req->path, req->op);
+	}
+}
+
+static void abac_test_decisions(struct kunit *test)
+{
+	check_requests(test);
+}
+
+static void abac_test_denied_by_default(struct kunit *test)
+{
+	/* Unknown users and objects are denied, even for irrelevant operations */
+	KUNIT_EXPECT_EQ(test, decide(2000, "/home/secured/chart", ABAC_READ), 0);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/unknown", ABAC_READ), 0);
+	KUNIT_EXPECT_EQ(test, decide(2000, "/home/secured/chart", ABAC_IGNORE), 0);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart", ABAC_IGNORE), 1);
+}
+
+static void abac_test_uid_collision(struct kunit *test)
+{
+	/* A uid hashing to the bucket of a loaded user is still unknown */
+	unsigned int uid = 2000;
+
+	/* user_attr_map has 2 ^ 8 buckets */
+	while (hash_32(uid, 8) != hash_32(1000, 8)) {
+		uid++;
+	}
+	KUNIT_EXPECT_PTR_EQ(test, get_user_attrs(uid), (avp *)NULL);
+	KUNIT_EXPECT_EQ(test, decide(uid, "/home/secured/chart", ABAC_READ), 0);
+	KUNIT_EXPECT_EQ(test, decide(uid, "/home/secured/chart", ABAC_IGNORE), 0);
+}
+
+static void abac_test_env_change(struct kunit *test)
+{
+	/* Decisions follow env_attr, not the environment the data was loaded with */
+	struct abac_test_data *data = test->priv;
+	avp *loaded_env = env_attr;
+	char *buf = test_dup(test, data->set->night_env);
+
+	env_attr = parse_env_attr(buf);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart", ABAC_MODIFY), 0);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/scan", ABAC_MODIFY), 1);
+	clear_avp_list(env_attr);
+	env_attr = loaded_env;
+	kfree(buf);
+}
+
+static void abac_test_no_engine(struct kunit *test)
+{
+	/* Requests are denied while the engine is switched */
+	struct abac_test_data *data = test->priv;
+
+	KUNIT_EXPECT_PTR_EQ(test, set_engine(NULL), data->engine);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart", ABAC_MODIFY), 0);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart", ABAC_IGNORE), 0);
+	set_engine(data->engine);
+	check_requests(test);
+}
+
+static void abac_rules_test_check_avps(struct kunit *test)
+{
+	avp *user = get_user_attrs(1000);
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, user);
+	KUNIT_EXPECT_EQ(test, check_avps(user, get_rule(0)->user), 1);
+	KUNIT_EXPECT_EQ(test, check_avps(user, get_rule(1)->user), 0);
+	/* An empty predicate list always holds */
+	KUNIT_EXPECT_EQ(test, check_avps(user, NULL), 1);
+	KUNIT_EXPECT_EQ(test, check_avps(env_attr, get_rule(1)->env), 1);
+	KUNIT_EXPECT_EQ(test, check_avps(env_attr, get_rule(2)->env), 0);
+}
+
+static u64 reverse_rank(unsigned int id)
+{
+	return id;
+}
+
+static void abac_rules_test_reorder(struct kunit *test)
+{
+	/* Reordering covering rule lists must not change any decision */
+	check_requests(test);
+	reorder_obj_rule_map(reverse_rank);
+	check_requests(test);
+	update_rule_scores();
+	reorder_obj_rule_map(get_rule_score);
+	check_requests(test);
+}
+
+static void abac_rules_test_paused_hits(struct kunit *test)
+{
+	/* Decisions taken while hits are paused leave the rule scores alone */
+	unsigned int i, n = get_policy_size();
+	u64 *before;
+
+	before = kunit_kzalloc(test, n * sizeof(u64) + 1, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, before);
+	update_rule_scores();
+	for (i = 0; i < n; i++) {
+		before[i] = get_rule_score(i);
+	}
+	pause_rule_hits(1);
+	check_requests(test);
+	pause_rule_hits(0);
+	update_rule_scores();
+	for (i = 0; i < n; i++) {
+		KUNIT_EXPECT_EQ(test, get_rule_score(i), before[i] / 2);
+	}
+}
+
+static void abac_trees_test_compiled_once(struct kunit *test)
+{
+	/* Trees are built on first access and reused afterwards */
+	struct node *root = get_obj_tree("/home/secured/chart");
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, root);
+	KUNIT_EXPECT_PTR_EQ(test, get_obj_tree("/home/secured/chart"), root);
+	check_requests(test);
+	check_requests(test);
+}
+
+static void abac_trees_test_malformed(struct kunit *test)
+{
+	/* Malformed tree records are skipped when loaded, the others still work.
+	 * The values are numbers so the records read the same when encoded */
+	static const char * const bad[] = {
+		"/home/secured/bad0:x|0 - - 1|1 0 11 READ",
+		"/home/secured/bad1:2|1 - - 1|1 0 11 READ",
+		"/home/secured/bad2:3|0 - - 1|2 1 11 READ",
+		"/home/secured/bad3:2|0 - - 1|5 0 11 READ",
+		"/home/secured/bad4:2|0 - - 1|1 0 11 READ|1 0 12 READ",
+		"/home/secured/bad5:2|0 - - 1|1 0",
+		"/home/secured/bad6",
+	};
+	struct abac_test_data *data = test->priv;
+	char *objects, path[32];
+	size_t len;
+	int i;
+
+	len = strlen(data->set->objects) + 1;
+	for (i = 0; i < ARRAY_SIZE(bad); i++) {
+		len += strlen(bad[i]) + 1;
+	}
+	/* Same steps as a write to the obj_attr file */
+	data->engine->clear_objects();
+	objects = kzalloc(len, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, objects);
+	strcpy(objects, data->set->objects);
+	for (i = 0; i < ARRAY_SIZE(bad); i++) {
+		strcat(objects, "\n");
+		strcat(objects, bad[i]);
+	}
+	kfree(data->bufs[2]);
+	data->bufs[2] = objects;
+	data->engine->load_objects(data->bufs[2]);
+
+	check_requests(test);
+	for (i = 0; i < ARRAY_SIZE(bad); i++) {
+		snprintf(path, sizeof(path), "%.*s", (int)strcspn(bad[i], ":"), bad[i]);
+		KUNIT_EXPECT_PTR_EQ(test, get_obj_tree(path), NULL);
+		KUNIT_EXPECT_EQ(test, decide(1000, path, ABAC_READ), 0);
+	}
+}
+
+static void abac_adaptive_test_forms(struct kunit *test)
+{
+	/* Objects choose their form on first access and again after a policy load */
+	struct abac_test_data *data = test->priv;
+	struct rule_obj *ward = get_rule_obj("/home/secured/ward");
+	struct rule_obj *chart = get_rule_obj("/home/secured/chart");
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ward);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, chart);
+	KUNIT_EXPECT_EQ(test, ward->form, ADAPTIVE_NONE);
+	check_requests(test);
+	decide(1000, "/home/secured/ward", ABAC_READ);
+	KUNIT_EXPECT_EQ(test, ward->form, ADAPTIVE_TREE);
+	KUNIT_EXPECT_NOT_ERR_OR_NULL(test, ward->tree);
+	KUNIT_EXPECT_EQ(test, chart->form, ADAPTIVE_LIST);
+
+	/* Same steps as a write to the policy file */
+	data->engine->clear_policy();
+	KUNIT_EXPECT_EQ(test, ward->form, ADAPTIVE_NONE);
+	KUNIT_EXPECT_PTR_EQ(test, ward->tree, NULL);
+	kfree(data->bufs[3]);
+	data->bufs[3] = test_dup(test, data->set->policy);
+	data->engine->load_policy(data->bufs[3]);
+	check_requests(test);
+	decide(1000, "/home/secured/ward", ABAC_READ);
+	KUNIT_EXPECT_EQ(test, ward->form, ADAPTIVE_TREE);
+}
+
+static void check_ward(struct kunit *test)
+{
+	/* The compiled form of ward decides like its rule list */
+	static const enum operation ops[] = { ABAC_MODIFY, ABAC_READ, ABAC_IGNORE };
+	obj_rule *list = get_obj_rule_list("/home/secured/ward");
+	unsigned int uid;
+	int i;
+
+	for (uid = 1000; uid <= 1003; uid++) {
+		for (i = 0; i < ARRAY_SIZE(ops); i++) {
+			KUNIT_EXPECT_EQ_MSG(test, decide(uid, "/home/secured/ward", ops[i]),
+					    resolve_rules(get_user_attrs(uid), list, ops[i]),
+					    "uid %u op %d", uid, ops[i]);
+		}
+	}
+}
+
+static void abac_test_compiled_matches_list(struct kunit *test)
+{
+	struct abac_test_data *data = test->priv;
+	avp *loaded_env = env_attr;
+	char *buf = test_dup(test, data->set->night_env);
+
+	check_ward(test);
+	env_attr = parse_env_attr(buf);
+	check_ward(test);
+	clear_avp_list(env_attr);
+	env_attr = loaded_env;
+	kfree(buf);
+}
+
+static void abac_mdd_test_shared_root(struct kunit *test)
+{
+	/* Objects with the same covering rules share their root, also after a reload */
+	struct abac_test_data *data = test->priv;
+	struct rule_obj *ward = get_rule_obj("/home/secured/ward");
+	struct rule_obj *rounds = get_rule_obj("/home/secured/rounds");
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ward);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, rounds);
+	KUNIT_EXPECT_NOT_ERR_OR_NULL(test, ward->mdd);
+	KUNIT_EXPECT_PTR_EQ(test, ward->mdd, rounds->mdd);
+	KUNIT_EXPECT_PTR_NE(test, ward->mdd, get_rule_obj("/home/secured/chart")->mdd);
+
+	/* Same steps as a write to the policy file */
+	data->engine->clear_policy();
+	KUNIT_EXPECT_PTR_EQ(test, ward->mdd, NULL);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/ward", ABAC_READ), 0);
+	kfree(data->bufs[3]);
+	data->bufs[3] = test_dup(test, data->set->policy);
+	data->engine->load_policy(data->bufs[3]);
+	KUNIT_EXPECT_NOT_ERR_OR_NULL(test, ward->mdd);
+	KUNIT_EXPECT_PTR_EQ(test, ward->mdd, rounds->mdd);
+	check_requests(test);
+}
+
+static unsigned int rule_set(const char *path)
+{
+	/* Covering rule ids of @path as a bitmask, the derived lists are not sorted */
+	obj_rule *r;
+	unsigned int set = 0;
+
+	for (r = get_obj_rule_list((char *)path); r != NULL; r = r->next)
+		set |= 1 << r->id;
+	return set;
+}
+
+static void check_derived(struct kunit *test)
+{
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/chart"), 0x3);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/scan"), 0x6);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/notes"), 0xc);
+	/* Rule 4 is pruned, see test_policy */
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/ward"), 0xf);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/report"), 0);
+	KUNIT_EXPECT_EQ(test, get_obj_rule_list("/home/secured/report"), NULL);
+}
+
+static void abac_rules_test_pruned(struct kunit *test)
+{
+	/* Rule 4 is dropped from chart, also when the policy is loaded again */
+	struct abac_test_data *data = test->priv;
+	struct rule_obj *chart = get_rule_obj("/home/secured/chart");
+	char *line, *next;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, chart);
+	KUNIT_EXPECT_TRUE(test, rule_dominates(1, 4));
+	KUNIT_EXPECT_FALSE(test, rule_dominates(4, 1));
+	KUNIT_EXPECT_FALSE(test, rule_dominates(0, 4));
+	/* Lists are pruned when they are compiled, on first access */
+	KUNIT_EXPECT_PTR_EQ(test, chart->head, (obj_rule *)NULL);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/chart"), 0x3);
+	KUNIT_EXPECT_EQ(test, chart->pruned, 1);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/scan"), 0x6);
+	KUNIT_EXPECT_EQ(test, get_rule_obj("/home/secured/scan")->pruned, 0);
+
+	/* Same steps as a write to the policy file, without rule 1 nothing is dominated */
+	data->engine->clear_policy();
+	kfree(data->bufs[3]);
+	data->bufs[3] = test_dup(test, data->set->policy);
+	line = strstr(data->bufs[3], "\n1:");
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, line);
+	next = strchr(line + 1, '\n');
+	memmove(line, next, strlen(next) + 1);
+	data->engine->load_policy(data->bufs[3]);
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/chart"), 0x13);
+	KUNIT_EXPECT_EQ(test, chart->pruned, 0);
+	KUNIT_EXPECT_EQ(test, decide(1001, "/home/secured/chart", ABAC_READ), 1);
+	KUNIT_EXPECT_EQ(test, decide(1001, "/home/secured/scan", ABAC_READ), 0);
+}
+
+static void abac_rules_test_ranges(struct kunit *test)
+{
+	/* notes lists rule 3 before rule 2, its range puts the MODIFY rule first.
+	 * Ranges are built on first access */
+	struct rule_obj *notes = get_rule_obj("/home/secured/notes");
+	struct rule_range *range;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, rule_store);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, notes);
+	KUNIT_EXPECT_PTR_EQ(test, notes->range, (struct rule_range *)NULL);
+	range = get_rule_obj_range(notes);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, range);
+	KUNIT_EXPECT_PTR_EQ(test, get_rule_obj_range(notes), range);
+	KUNIT_EXPECT_EQ(test, range->n, 2);
+	KUNIT_EXPECT_EQ(test, range->n_modify, 1);
+	KUNIT_EXPECT_EQ(test, rule_store->id[range->slot[0]], 2);
+	KUNIT_EXPECT_EQ(test, rule_store->id[range->slot[1]], 3);
+	KUNIT_EXPECT_EQ(test, rule_store->op[range->slot[0]], ABAC_MODIFY);
+}
+
+static void abac_index_test_derived(struct kunit *test)
+{
+	/* The lists are derived again when either the policy or the objects are loaded */
+	struct abac_test_data *data = test->priv;
+
+	check_derived(test);
+
+	/* Same steps as a write to the policy file */
+	data->engine->clear_policy();
+	KUNIT_EXPECT_EQ(test, rule_set("/home/secured/chart"), 0);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart", ABAC_MODIFY), 0);
+	kfree(data->bufs[3]);
+	data->bufs[3] = test_dup(test, data->set->policy);
+	data->engine->load_policy(data->bufs[3]);
+	check_derived(test);
+	check_requests(test);
+
+	/* Same steps as a write to the obj_attrs file */
+	data->engine->clear_objects();
+	kfree(data->bufs[2]);
+	data->bufs[2] = test_dup(test, data->set->objects);
+	data->engine->load_objects(data->bufs[2]);
+	check_derived(test);
+	check_requests(test);
+}
+
+static void set_dentry(struct dentry *d, struct dentry *parent, const char *name)
+{
+	d->d_parent = parent ? parent : d;
+	d->d_name.name = (const unsigned char *)name;
+	d->d_name.len = strlen(name);
+}
+
+static void abac_test_lookup_dentry(struct kunit *test)
+{
+	/* A dentry chain finds the object its path finds, and nothing else */
+	const struct abac_engine *e = ((struct abac_test_data *)test->priv)->engine;
+	struct dentry root, home, secured, chart, scan, unknown, part;
+
+	set_dentry(&root, NULL, "/");
+	set_dentry(&home, &root, "home");
+	set_dentry(&secured, &home, "secured");
+	set_dentry(&chart, &secured, "chart");
+	set_dentry(&scan, &secured, "scan");
+	set_dentry(&unknown, &secured, "unknown");
+	set_dentry(&part, &secured, "char");
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, e->lookup_dentry);
+	KUNIT_EXPECT_NOT_ERR_OR_NULL(test, e->lookup_dentry(&chart));
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&chart), e->lookup("/home/secured/chart"));
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&scan), e->lookup("/home/secured/scan"));
+	KUNIT_EXPECT_PTR_NE(test, e->lookup_dentry(&chart), e->lookup_dentry(&scan));
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&unknown), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&part), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&secured), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&root), NULL);
+}
+
+static void abac_test_inherited(struct kunit *test)
+{
+	/* Paths without an entry are decided by the entry of their nearest ancestor */
+	const struct abac_engine *e = ((struct abac_test_data *)test->priv)->engine;
+	struct dentry root, home, secured, chart, dir, file;
+
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup("/home/secured/chart/a/b"),
+			    e->lookup("/home/secured/chart"));
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup("/home/secured/chartx"), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup("/home/secured"), NULL);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart/a", ABAC_MODIFY), 1);
+	KUNIT_EXPECT_EQ(test, decide(1001, "/home/secured/chart/a", ABAC_MODIFY), 0);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/notes/a/b", ABAC_READ), 1);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart/a", ABAC_READ), 0);
+
+	set_dentry(&root, NULL, "/");
+	set_dentry(&home, &root, "home");
+	set_dentry(&secured, &home, "secured");
+	set_dentry(&chart, &secured, "chart");
+	set_dentry(&dir, &chart, "a");
+	set_dentry(&file, &dir, "b");
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&file), e->lookup("/home/secured/chart"));
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_dentry(&secured), NULL);
+}
+
+static void abac_rules_test_nearest_ancestor(struct kunit *test)
+{
+	/* A deeper entry overrides the one of its directory for the paths below it */
+	struct abac_test_data *data = test->priv;
+	const char *private = "\n/home/secured/chart/private:3";
+	char *objects;
+
+	/* Same steps as a write to the obj_rules file */
+	data->engine->clear_objects();
+	objects = kzalloc(strlen(data->set->objects) + strlen(private) + 1, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, objects);
+	strcpy(objects, data->set->objects);
+	strcat(objects, private);
+	kfree(data->bufs[2]);
+	data->bufs[2] = objects;
+	data->engine->load_objects(data->bufs[2]);
+
+	check_requests(test);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart/private", ABAC_READ), 1);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart/private/x", ABAC_READ), 1);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart/private/x", ABAC_MODIFY), 0);
+	KUNIT_EXPECT_EQ(test, decide(1000, "/home/secured/chart/public", ABAC_MODIFY), 1);
+	KUNIT_EXPECT_EQ(test, decide(1002, "/home/secured/chart/public", ABAC_READ), 0);
+}
+
+static void abac_test_path_trie(struct kunit *test)
+{
+	/* Components are shared by the paths and prefix lookups stop at the
+	 * deepest node that holds an object */
+	struct path_trie *t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	int home, chart;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, t);
+	KUNIT_ASSERT_EQ(test, path_trie_init(t, 3), 0);
+	KUNIT_EXPECT_EQ(test, t->bits, PATH_TRIE_MIN_BITS);
+	path_trie_insert(t, "/home/secured/chart")->obj = &chart;
+	path_trie_insert(t, "/home/secured/scan");
+	KUNIT_EXPECT_EQ(test, t->nodes, 4);
+	path_trie_insert(t, "/home")->obj = &home;
+	KUNIT_EXPECT_EQ(test, t->nodes, 4);
+
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "/home/secured/chart"), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "//home/secured//chart/"), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "/home/secured/scan"), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "/home/secured/char"), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "/home/secured/chart/x"), NULL);
+
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_prefix(t, "/home/secured/chart/x"), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_prefix(t, "/home/secured/scan"), &home);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_prefix(t, "/home/other"), &home);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_prefix(t, "/srv"), NULL);
+	path_trie_clear(t);
+	KUNIT_EXPECT_EQ(test, t->nodes, 0);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup(t, "/home"), NULL);
+
+	/* Large object files get a bucket per object */
+	KUNIT_ASSERT_EQ(test, path_trie_init(t, 5000), 0);
+	KUNIT_EXPECT_EQ(test, t->bits, 13);
+	path_trie_clear(t);
+}
+
+static void abac_test_path_trie_deep(struct kunit *test)
+{
+	/* Dentry chains deeper than PATH_TRIE_MAX_DEPTH find the objects their
+	 * paths find */
+	const int extra = PATH_TRIE_MAX_DEPTH + 6;
+	struct path_trie *t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	struct dentry *d = kunit_kzalloc(test, (extra + 4) * sizeof(*d), GFP_KERNEL);
+	char *path = kunit_kzalloc(test, 32 + 2 * extra, GFP_KERNEL);
+	int chart, i;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, t);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, d);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, path);
+	KUNIT_ASSERT_EQ(test, path_trie_init(t, 1), 0);
+	path_trie_insert(t, "/home/secured/chart")->obj = &chart;
+
+	set_dentry(&d[0], NULL, "/");
+	set_dentry(&d[1], &d[0], "home");
+	set_dentry(&d[2], &d[1], "secured");
+	set_dentry(&d[3], &d[2], "chart");
+	strcpy(path, "/home/secured/chart");
+	for (i = 4; i < extra + 4; i++) {
+		set_dentry(&d[i], &d[i - 1], "x");
+		strcat(path, "/x");
+	}
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_prefix(t, path), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_dentry(t, &d[extra + 3], 1), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_dentry(t, &d[extra + 3], 0), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_dentry(t, &d[PATH_TRIE_MAX_DEPTH], 1), &chart);
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_dentry(t, &d[3], 0), &chart);
+
+	/* Above the limit the top components decide, a mismatch finds nothing */
+	set_dentry(&d[2], &d[1], "other");
+	KUNIT_EXPECT_PTR_EQ(test, path_trie_lookup_dentry(t, &d[extra + 3], 1), NULL);
+	path_trie_clear(t);
+}
+
+static void check_class(struct kunit *test, void *class, const char *path)
+{
+	/* The class decides every request like the object at @path */
+	const struct abac_engine *e = ((struct abac_test_data *)test->priv)->engine;
+	const struct abac_test_request *req;
+	int i;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, class);
+	for (i = 0; i < ARRAY_SIZE(test_requests); i++) {
+		req = &test_requests[i];
+		if (strcmp(req->path, path) == 0) {
+			KUNIT_EXPECT_EQ_MSG(test, e->resolve(get_user_attrs(req->uid), class, req->op),
+					    req->allowed, "uid %u path %s op %d", req->uid, path, req->op);
+		}
+	}
+}
+
+static void abac_index_test_xattr(struct kunit *test)
+{
+	/* xattr values are interned into classes derived like the objects */
+	struct abac_test_data *data = test->priv;
+	const struct abac_engine *e = data->engine;
+	char chart[] = "chart=cardio", notes[] = "notes=neuro";
+	char enc_chart[] = "5=51", enc_notes[] = "7=71";
+	char bad[] = "chart", empty[] = "";
+	char *chart_value = e->encoded ? enc_chart : chart;
+	char *notes_value = e->encoded ? enc_notes : notes;
+	void *class;
+
+	class = e->lookup_xattr(chart_value);
+	check_class(test, class, "/home/secured/chart");
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_xattr(chart_value), class);
+	check_class(test, e->lookup_xattr(notes_value), "/home/secured/notes");
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_xattr(bad), ERR_PTR(-EINVAL));
+	KUNIT_EXPECT_NOT_ERR_OR_NULL(test, e->lookup_xattr(empty));
+
+	/* Same steps as a write to the policy file, classes outlive the policy */
+	data->engine->clear_policy();
+	KUNIT_EXPECT_EQ(test, e->resolve(get_user_attrs(1000), class, ABAC_MODIFY), 0);
+	kfree(data->bufs[3]);
+	data->bufs[3] = test_dup(test, data->set->policy);
+	data->engine->load_policy(data->bufs[3]);
+	KUNIT_EXPECT_PTR_EQ(test, e->lookup_xattr(chart_value), class);
+	check_class(test, class, "/home/secured/chart");
+}
+
+static void abac_test_bench(struct kunit *test)
+{
+	const struct abac_test_request *req;
+	unsigned int allowed = 0, expected = 0;
+	u64 start, elapsed;
+	int i;
+
+	for (i = 0; i < BENCH_LOOPS; i++)
+		expected += test_requests[i % ARRAY_SIZE(test_requests)].allowed;
+	start = ktime_get_ns();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		req = &test_requests[i % ARRAY_SIZE(test_requests)];
+		allowed += decide(req->uid, req->path, req->op);
+	}
+	elapsed = ktime_get_ns() - start;
+	KUNIT_EXPECT_EQ(test, allowed, expected);
+	kunit_info(test, "%d decisions, %llu ns/decision\n", BENCH_LOOPS,
+		   div_u64(elapsed, BENCH_LOOPS));
+}
+
+static int abac_rules_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &rules_dataset);
+}
+
+static int abac_rules_enc_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &rules_enc_dataset);
+}
+
+static int abac_trees_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &trees_dataset);
+}
+
+static int abac_trees_enc_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &trees_enc_dataset);
+}
+
+static int abac_adaptive_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &adaptive_dataset);
+}
+
+static int abac_adaptive_enc_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &adaptive_enc_dataset);
+}
+
+static int abac_mdd_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &mdd_dataset);
+}
+
+static int abac_mdd_enc_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &mdd_enc_dataset);
+}
+
+static int abac_index_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &index_dataset);
+}
+
+static int abac_index_enc_test_init(struct kunit *test)
+{
+	return abac_test_load(test, &index_enc_dataset);
+}
+
+static struct kunit_case abac_rules_test_cases[] = {
+	KUNIT_CASE(abac_test_decisions),
+	KUNIT_CASE(abac_test_denied_by_default),
+	KUNIT_CASE(abac_test_uid_collision),
+	KUNIT_CASE(abac_test_env_change),
+	KUNIT_CASE(abac_test_no_engine),
+	KUNIT_CASE(abac_rules_test_check_avps),
+	KUNIT_CASE(abac_rules_test_reorder),
+	KUNIT_CASE(abac_rules_test_paused_hits),
+	KUNIT_CASE(abac_rules_test_pruned),
+	KUNIT_CASE(abac_rules_test_ranges),
+	KUNIT_CASE(abac_test_path_trie),
+	KUNIT_CASE(abac_test_path_trie_deep),
+	KUNIT_CASE(abac_rules_test_nearest_ancestor),
+	KUNIT_CASE(abac_test_lookup_dentry),
+	KUNIT_CASE(abac_test_inherited),
+	KUNIT_CASE(abac_test_bench),
+	{}
+};
+
+static struct kunit_case abac_trees_test_cases[] = {
+	KUNIT_CASE(abac_test_decisions),
+	KUNIT_CASE(abac_test_denied_by_default),
+	KUNIT_CASE(abac_test_uid_collision),
+	KUNIT_CASE(abac_test_env_change),
+	KUNIT_CASE(abac_test_no_engine),
+	KUNIT_CASE(abac_trees_test_compiled_once),
+	KUNIT_CASE(abac_trees_test_malformed),
+	KUNIT_CASE(abac_test_lookup_dentry),
+	KUNIT_CASE(abac_test_inherited),
+	KUNIT_CASE(abac_test_bench),
+	{}
+};
+
+static struct kunit_case abac_adaptive_test_cases[] = {
+	KUNIT_CASE(abac_test_decisions),
+	KUNIT_CASE(abac_test_denied_by_default),
+	KUNIT_CASE(abac_test_uid_collision),
+	KUNIT_CASE(abac_test_env_change),
+	KUNIT_CASE(abac_test_no_engine),
+	KUNIT_CASE(abac_adaptive_test_forms),
+	KUNIT_CASE(abac_test_compiled_matches_list),
+	KUNIT_CASE(abac_test_lookup_dentry),
+	KUNIT_CASE(abac_test_inherited),
+	KUNIT_CASE(abac_test_bench),
+	{}
+};
+
+static struct kunit_case abac_mdd_test_cases[] = {
+	KUNIT_CASE(abac_test_decisions),
+	KUNIT_CASE(abac_test_denied_by_default),
+	KUNIT_CASE(abac_test_uid_collision),
+	KUNIT_CASE(abac_test_env_change),
+	KUNIT_CASE(abac_test_no_engine),
+	KUNIT_CASE(abac_mdd_test_shared_root),
+	KUNIT_CASE(abac_test_compiled_matches_list),
+	KUNIT_CASE(abac_test_lookup_dentry),
+	KUNIT_CASE(abac_test_inherited),
+	KUNIT_CASE(abac_test_bench),
+	{}
+};
+
+static struct kunit_case abac_index_test_cases[] = {
+	KUNIT_CASE(abac_test_decisions),
+	KUNIT_CASE(abac_test_denied_by_default),
+	KUNIT_CASE(abac_test_uid_collision),
+	KUNIT_CASE(abac_test_env_change),
+	KUNIT_CASE(abac_test_no_engine),
+	KUNIT_CASE(abac_rules_test_check_avps),
+	KUNIT_CASE(abac_index_test_derived),
+	KUNIT_CASE(abac_index_test_xattr),
+	KUNIT_CASE(abac_rules_test_ranges),
+	KUNIT_CASE(abac_test_lookup_dentry),
+	KUNIT_CASE(abac_test_inherited),
+	KUNIT_CASE(abac_test_bench),
+	{}
+};
+
+static struct kunit_suite abac_rules_test_suite = {
+	.name = "abac_rules",
+	.init = abac_rules_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_rules_test_cases,
+};
+
+static struct kunit_suite abac_rules_enc_test_suite = {
+	.name = "abac_rules_enc",
+	.init = abac_rules_enc_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_rules_test_cases,
+};
+
+static struct kunit_suite abac_trees_test_suite = {
+	.name = "abac_trees",
+	.init = abac_trees_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_trees_test_cases,
+};
+
+static struct kunit_suite abac_trees_enc_test_suite = {
+	.name = "abac_trees_enc",
+	.init = abac_trees_enc_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_trees_test_cases,
+};
+
+static struct kunit_suite abac_adaptive_test_suite = {
+	.name = "abac_adaptive",
+	.init = abac_adaptive_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_adaptive_test_cases,
+};
+
+static struct kunit_suite abac_adaptive_enc_test_suite = {
+	.name = "abac_adaptive_enc",
+	.init = abac_adaptive_enc_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_adaptive_test_cases,
+};
+
+static struct kunit_suite abac_mdd_test_suite = {
+	.name = "abac_mdd",
+	.init = abac_mdd_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_mdd_test_cases,
+};
+
+static struct kunit_suite abac_mdd_enc_test_suite = {
+	.name = "abac_mdd_enc",
+	.init = abac_mdd_enc_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_mdd_test_cases,
+};
+
+static struct kunit_suite abac_index_test_suite = {
+	.name = "abac_index",
+	.init = abac_index_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_index_test_cases,
+};
+
+static struct kunit_suite abac_index_enc_test_suite = {
+	.name = "abac_index_enc",
+	.init = abac_index_enc_test_init,
+	.exit = abac_test_exit,
+	.test_cases = abac_index_test_cases,
+};
+
+kunit_test_suites(&abac_rules_test_suite, &abac_rules_enc_test_suite,
+		  &abac_trees_test_suite, &abac_trees_enc_test_suite,
+		  &abac_adaptive_test_suite, &abac_adaptive_enc_test_suite,
+		  &abac_mdd_test_suite, &abac_mdd_enc_test_suite,
+		  &abac_index_test_suite, &abac_index_enc_test_suite);
@@ -0,0 +1,678 @@
+#include "abacfs.h"
+#include "access_trace.h"
+#include "latency_hist.h"
+#include "samples.h"
+#include "self_bench.h"
+#include <linux/err.h>
+#include <linux/init.h>
+#include <linux/security.h>
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+
+const size_t MAX_FILE_SIZE = 8388608; // 8MB
+
+struct dentry *abacfs;
+struct dentry *user_attr_file;
+struct dentry *obj_rules_file;
+struct dentry *obj_attr_file;
+struct dentry *obj_attrs_file;
+struct dentry *env_attr_file;
+struct dentry *policy_file;
+struct dentry *action_file;
+struct dentry *perf_file;
+struct dentry *trace_file;
+struct dentry *hist_file;
+struct dentry *stats_file;
+struct dentry *shape_file;
+struct dentry *bench_file;
+struct dentry *engine_file;
+
+char *user_attr_buf = NULL;
+char *obj_buf = NULL;
+char *env_attr_buf = NULL;
+char *policy_buf = NULL;
+char perf_buf[64];
+int recording = 0;
+u64 prev_access_time = 0;
+
+avp *env_attr = NULL;
+
+/* Serializes the loads of the data files and the engine switches */
+static DEFINE_MUTEX(load_mutex);
+
+// method for opening policy file
+static int abac_open(struct inode *i, struct file *f)
+{
+	// TODO: Add a check to let only the root access the policy file
+	return 0;
+}
+
+// copy a data file written from userspace into a new NUL terminated buffer
+static char *copy_file_buf(const char __user *buffer, size_t len, const char *name)
+{
+	char *buf;
+	if (len >= MAX_FILE_SIZE) {
+		printk(KERN_INFO
+		       "Write failed. Buffer too large %zu. Maximum file size is %zu\n",
+		       len, MAX_FILE_SIZE);
+		return ERR_PTR(-EFAULT);
+	}
+	buf = kmalloc(len + 1, GFP_KERNEL);
+	if (!buf) {
+		printk(KERN_INFO
+		       "Write failed. Failed to allocate memory for %s buffer\n", name);
+		return ERR_PTR(-EFAULT);
+	}
+	if (copy_from_user(buf, buffer, len)) {
+		printk(KERN_INFO "Write to %s failed\n", name);
+		kfree(buf);
+		return ERR_PTR(-EFAULT);
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+// method for writing to user_attrs file
+static ssize_t user_attr_write(struct file *filp, const char __user *buffer,
+			       size_t len, loff_t *off)
+{
+	const struct abac_engine *e;
+	char *buf = copy_file_buf(buffer, len, "user_attr");
+	if (IS_ERR(buf)) {
+		return PTR_ERR(buf);
+	}
+	mutex_lock(&load_mutex);
+	// decisions read the user table, see policy_write()
+	e = set_engine(NULL);
+	if (user_attr_buf) {
+		clear_user_attrs();
+		kfree(user_attr_buf);
+	}
+	user_attr_buf = buf;
+	printk("User attributes written to buffer. Attempting to parse...");
+	parse_user_attr(user_attr_buf);
+	//print_user_attrs();
+	printk("User attributes loaded");
+	set_engine(e);
+	mutex_unlock(&load_mutex);
+	return len;
+}
+
+// method for writing to the object files, only the one of the active engine is accepted
+static ssize_t obj_write(const char *name, const char __user *buffer, size_t len)
+{
+	const struct abac_engine *e;
+	char *buf = copy_file_buf(buffer, len, name);
+	if (IS_ERR(buf)) {
+		return PTR_ERR(buf);
+	}
+	mutex_lock(&load_mutex);
+	e = get_engine();
+	if (strcmp(e->obj_file, name) != 0) {
+		printk(KERN_INFO "Write failed. The %s engine loads objects from %s\n",
+		       e->name, e->obj_file);
+		mutex_unlock(&load_mutex);
+		kfree(buf);
+		return -EINVAL;
+	}
+	// decisions read the objects, see policy_write()
+	set_engine(NULL);
+	if (obj_buf) {
+		e->clear_objects();
+		kfree(obj_buf);
+	}
+	obj_buf = buf;
+	printk("Objects written to buffer. Attempting to parse...");
+	e->load_objects(obj_buf);
+	printk("Objects loaded");
+	set_engine(e);
+	mutex_unlock(&load_mutex);
+	return len;
+}
+
+static ssize_t obj_rules_write(struct file *filp, const char __user *buffer, size_t len, loff_t *off)
+{
+	return obj_write("obj_rules", buffer, len);
+}
+
+static ssize_t obj_attr_write(struct file *filp, const char __user *buffer, size_t len, loff_t *off)
+{
+	return obj_write("obj_attr", buffer, len);
+}
+
+static ssize_t obj_attrs_write(struct file *filp, const char __user *buffer, size_t len, loff_t *off)
+{
+	return obj_write("obj_attrs", buffer, len);
+}
+
+// method for writing to env_attrs file
+static ssize_t env_attr_write(struct file *filp, const char __user *buffer,
+			      size_t len, loff_t *off)
+{
+	const struct abac_engine *e;
+	char *buf = copy_file_buf(buffer, len, "env_attr");
+	if (IS_ERR(buf)) {
+		return PTR_ERR(buf);
+	}
+	mutex_lock(&load_mutex);
+	// decisions and the rule reorder worker read env_attr, see policy_write()
+	e = set_engine(NULL);
+	if (env_attr_buf) {
+		clear_avp_list(env_attr);
+		kfree(env_attr_buf);
+	}
+	env_attr_buf = buf;
+	printk("Environment attributes written to buffer. Attempting to parse...");
+	env_attr = parse_env_attr(env_attr_buf);
+	//print_env_attrs(env_attr);
+	printk("Environment attributes loaded");
+	set_engine(e);
+	mutex_unlock(&load_mutex);
+	return len;
+}
+
+// method for writing to policy file
+static ssize_t policy_write(struct file *filp, const char __user *buffer, size_t len, loff_t *off)
+{
+	const struct abac_engine *e;
+	char *buf = copy_file_buf(buffer, len, "policy");
+	if (IS_ERR(buf)) {
+		return PTR_ERR(buf);
+	}
+	mutex_lock(&load_mutex);
+	e = get_engine();
+	if (!e->load_policy) {
+		printk(KERN_INFO "Write failed. The %s engine has no separate policy\n", e->name);
+		mutex_unlock(&load_mutex);
+		kfree(buf);
+		return -EINVAL;
+	}
+	/*
+	 * Decisions and the rule reorder worker read the policy. Taking the
+	 * engine offline waits for the running decisions and stops the worker
+	 * before the policy is freed, requests are denied until it is back.
+	 */
+	set_engine(NULL);
+	if (policy_buf) {
+		e->clear_policy();
+		kfree(policy_buf);
+	}
+	policy_buf = buf;
+	printk("Policy written to buffer. Attempting to parse...");
+	e->load_policy(policy_buf);
+	//print_policy();
+	printk("Policy loaded");
+	set_engine(e);
+	mutex_unlock(&load_mutex);
+	return len;
+}
+
+// free everything loaded for engine @e, called while no engine is active
+static void unload_all(const struct abac_engine *e)
+{
+	if (obj_buf) {
+		e->clear_objects();
+		kfree(obj_buf);
+		obj_buf = NULL;
+	}
+	if (policy_buf) {
+		e->clear_policy();
+		kfree(policy_buf);
+		policy_buf = NULL;
+	}
+	if (user_attr_buf) {
+		clear_user_attrs();
+		kfree(user_attr_buf);
+		user_attr_buf = NULL;
+	}
+	if (env_attr_buf) {
+		clear_avp_list(env_attr);
+		env_attr = NULL;
+		kfree(env_attr_buf);
+		env_attr_buf = NULL;
+	}
+}
+
+// method for writing to engine file
+static ssize_t engine_write(struct file *filp, const char __user *buffer,
+			    size_t len, loff_t *off)
+{
+	const struct abac_engine *e, *old;
+	char name[16];
+	if (len >= sizeof(name)) {
+		return -EINVAL;
+	}
+	if (copy_from_user(name, buffer, len)) {
+		return -EFAULT;
+	}
+	name[len] = '\0';
+	e = find_engine(strim(name));
+	if (!e) {
+		printk(KERN_INFO "Unknown engine %s", name);
+		return -EINVAL;
+	}
+	mutex_lock(&load_mutex);
+	old = set_engine(NULL);
+	// the datasets differ between engines, so nothing loaded is kept
+	unload_all(old);
+	set_engine(e);
+	mutex_unlock(&load_mutex);
+	printk(KERN_INFO "ABAC LSM: Using the %s engine", e->name);
+	return len;
+}
+
+static int engine_show(struct seq_file *m, void *v)
+{
+	show_engines(m);
+	return 0;
+}
+
+static int engine_open(struct inode *i, struct file *f)
+{
+	return single_open(f, engine_show, NULL);
+}
+
+// method for writing to action file
+static ssize_t action_write(struct file *filp, const char __user *buffer,
+			      size_t len, loff_t *off)
+{
+	char *action_buf;
+	ssize_t ret = len;
+	int err;
+	if (len >= MAX_FILE_SIZE) {
+		printk(KERN_INFO
+		       "Write failed. Buffer too large %zu. Maximum file size is %zu\n",
+		       len, MAX_FILE_SIZE);
+		return -EFAULT;
+	}
+	action_buf = kmalloc(len + 1, GFP_KERNEL);
+	if (!action_buf) {
+		printk(KERN_INFO
+		       "Write failed. Failed to allocate memory for action buffer\n");
+		return -EFAULT;
+	}
+	if (copy_from_user(action_buf, buffer, len + 1)) {
+		printk(KERN_INFO "Write to action failed\n");
+		return -EFAULT;
+	}
+	action_buf[len] = '\0';
+	if (strcmp(action_buf, "RECORD") == 0) {
+		//printk("Recording started...");
+		prev_access_time = 0;
+		if (start_samples(abacfs)) {
+			printk(KERN_ERR "ABAC LSM: Failed to create the sample buffers");
+		}
+		recording = 1;
+	} else if (strcmp(action_buf, "STOP") == 0) {
+		//printk("Recording stopped...");
+		recording = 0;
+		stop_samples();
+		// snprintf(perf_buf, 64, "%llu\n", prev_access_time);
+		// printk("Time taken written to /sys/kernel/security/abac/perf");
+		prev_access_time = 0;
+	} else if (strcmp(action_buf, "TRACE_START") == 0) {
+		clear_access_trace();
+		tracing = 1;
+	} else if (strcmp(action_buf, "TRACE_STOP") == 0) {
+		tracing = 0;
+	} else if (strcmp(action_buf, "HIST_RESET") == 0) {
+		reset_latency_hist();
+	} else if (strncmp(action_buf, "BENCH", 5) == 0) {
+		mutex_lock(&load_mutex);
+		err = run_self_bench(action_buf + 5);
+		mutex_unlock(&load_mutex);
+		if (err) {
+			printk(KERN_INFO "Benchmark failed: %d", err);
+			ret = err;
+		}
+	} else {
+		printk("Invalid action...");
+	}
+	kfree(action_buf);
+	return ret;
+}
+
+static ssize_t perf_read(struct file *file, char __user *buf, size_t count, loff_t *off)
+{
+    loff_t pos = *off;
+    loff_t len = strlen(perf_buf);
+
+    if (pos >= len || !count)
+        return 0;
+
+    len -= pos;
+    if (count < len)
+        len = count;
+
+    if (copy_to_user(buf, perf_buf, len))
+        return -EFAULT;
+    *off += len;
+    return len;
+}
+
+static int trace_show(struct seq_file *m, void *v)
+{
+	show_access_trace(m);
+	return 0;
+}
+
+static int trace_open(struct inode *i, struct file *f)
+{
+	return single_open(f, trace_show, NULL);
+}
+
+static int hist_show(struct seq_file *m, void *v)
+{
+	show_latency_hist(m);
+	return 0;
+}
+
+static int hist_open(struct inode *i, struct file *f)
+{
+	return single_open(f, hist_show, NULL);
+}
+
+static const char *const mem_type_names[ABAC_MEM_TYPES] = {
+	[ABAC_MEM_USERS] = "users",
+	[ABAC_MEM_AVPS] = "avps",
+	[ABAC_MEM_OBJECTS] = "objects",
+	[ABAC_MEM_TRIE] = "trie",
+	[ABAC_MEM_RULE_REFS] = "rule_refs",
+	[ABAC_MEM_RULES] = "rules",
+	[ABAC_MEM_TREE_NODES] = "tree_nodes",
+	[ABAC_MEM_BRANCHES] = "branches",
+	[ABAC_MEM_DIAGRAM] = "diagram",
+	[ABAC_MEM_INDEX] = "index",
+	[ABAC_MEM_BUFFERS] = "buffers",
+	[ABAC_MEM_TRACE] = "trace",
+};
+
+// One line per structure type, <type>:<count>:<bytes>, followed by the total
+static int stats_show(struct seq_file *m, void *v)
+{
+	struct abac_mem_stats s = {};
+	u64 count = 0, bytes = 0;
+	int i;
+
+	mutex_lock(&load_mutex);
+	user_mem_stats(&s);
+	avp_list_mem_stats(env_attr, &s);
+	get_engine()->mem_stats(&s);
+	mem_account(&s, ABAC_MEM_BUFFERS, user_attr_buf);
+	mem_account(&s, ABAC_MEM_BUFFERS, obj_buf);
+	mem_account(&s, ABAC_MEM_BUFFERS, env_attr_buf);
+	mem_account(&s, ABAC_MEM_BUFFERS, policy_buf);
+	mutex_unlock(&load_mutex);
+	trace_mem_stats(&s);
+	for (i = 0; i < ABAC_MEM_TYPES; i++) {
+		seq_printf(m, "%s:%llu:%llu\n", mem_type_names[i], s.count[i], s.bytes[i]);
+		count += s.count[i];
+		bytes += s.bytes[i];
+	}
+	seq_printf(m, "total:%llu:%llu\n", count, bytes);
+	return 0;
+}
+
+static int stats_open(struct inode *i, struct file *f)
+{
+	return single_open(f, stats_show, NULL);
+}
+
+static int shape_show(struct seq_file *m, void *v)
+{
+	mutex_lock(&load_mutex);
+	show_user_shape(m);
+	get_engine()->show_shape(m);
+	mutex_unlock(&load_mutex);
+	return 0;
+}
+
+static int shape_open(struct inode *i, struct file *f)
+{
+	return single_open(f, shape_show, NULL);
+}
+
+static int bench_show(struct seq_file *m, void *v)
+{
+	show_self_bench(m);
+	return 0;
+}
+
+static int bench_open(struct inode *i, struct file *f)
+{
+	return single_open(f, bench_show, NULL);
+}
+
+static const struct file_operations user_attr_fops = {
+	.open = abac_open,
+	.write = user_attr_write,
+};
+
+static const struct file_operations obj_rules_fops = {
+	.open = abac_open,
+	.write = obj_rules_write,
+};
+
+static const struct file_operations obj_attr_fops = {
+	.open = abac_open,
+	.write = obj_attr_write,
+};
+
+static const struct file_operations obj_attrs_fops = {
+	.open = abac_open,
+	.write = obj_attrs_write,
+};
+
+static const struct file_operations env_attr_fops = {
+	.open = abac_open,
+	.write = env_attr_write,
+};
+
+static const struct file_operations policy_fops = {
+	.open = abac_open,
+	.write = policy_write,
+};
+
+static const struct file_operations action_fops = {
+	.open = abac_open,
+	.write = action_write,
+};
+
+static const struct file_operations perf_fops = {
+	.open = abac_open,
+	.read = perf_read,
+};
+
+static const struct file_operations trace_fops = {
+	.open = trace_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations hist_fops = {
+	.open = hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations stats_fops = {
+	.open = stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations shape_fops = {
+	.open = shape_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations bench_fops = {
+	.open = bench_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations engine_fops = {
+	.open = engine_open,
+	.read = seq_read,
+	.write = engine_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+
+static void destroy_abac_fs(void)
+{
+	if (user_attr_file) {
+		securityfs_remove(user_attr_file);
+	}
+	if (obj_rules_file) {
+		securityfs_remove(obj_rules_file);
+	}
+	if (obj_attr_file) {
+		securityfs_remove(obj_attr_file);
+	}
+	if (obj_attrs_file) {
+		securityfs_remove(obj_attrs_file);
+	}
+	if (env_attr_file) {
+		securityfs_remove(env_attr_file);
+	}
+	if (policy_file) {
+		securityfs_remove(policy_file);
+	}
+	if (action_file) {
+		securityfs_remove(action_file);
+	}
+	if (perf_file) {
+		securityfs_remove(perf_file);
+	}
+	if (trace_file) {
+		securityfs_remove(trace_file);
+	}
+	if (hist_file) {
+		securityfs_remove(hist_file);
+	}
+	if (stats_file) {
+		securityfs_remove(stats_file);
+	}
+	if (shape_file) {
+		securityfs_remove(shape_file);
+	}
+	if (bench_file) {
+		securityfs_remove(bench_file);
+	}
+	if (engine_file) {
+		securityfs_remove(engine_file);
+	}
+	if (abacfs) {
+		securityfs_remove(abacfs);
+	}
+}
+
+static struct dentry *create_file(const char *filename, const struct file_operations *fops) {
+	struct dentry *f;
+	f = securityfs_create_file(filename, 0666, abacfs, NULL, fops);
+	if (!f) {
+		printk(KERN_ERR "ABAC LSM: Failed to create file /sys/kernel/security/abac/%s", filename);
+		destroy_abac_fs();
+		return NULL;
+	}
+	printk(KERN_INFO "ABAC LSM: Created file /sys/kernel/security/abac/%s", filename);
+	return f;
+}
+
+/* create the abac filesystem */
+static void abac_create_fs(void)
+{
+	// create the root 'abac' directory
+	abacfs = securityfs_create_dir("abac", NULL);
+	if (!abacfs) {
+		printk(KERN_ERR "ABAC LSM: Failed to create abac securityfs at /sys/kernel/security/abac/");
+		destroy_abac_fs();
+	}
+
+	user_attr_file = create_file("user_attr", &user_attr_fops);
+	if (!user_attr_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	obj_rules_file = create_file("obj_rules", &obj_rules_fops);
+	if (!obj_rules_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	obj_attr_file = create_file("obj_attr", &obj_attr_fops);
+	if (!obj_attr_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	obj_attrs_file = create_file("obj_attrs", &obj_attrs_fops);
+	if (!obj_attrs_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	env_attr_file = create_file("env_attr", &env_attr_fops);
+	if (!env_attr_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	policy_file = create_file("policy", &policy_fops);
+	if (!policy_file) {
+		destroy_abac_fs();
+		return ;
+	}
+
+	// Performance evaluation files
+	action_file = create_file("action", &action_fops);
+	if (!action_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	perf_file = create_file("perf", &perf_fops);
+	if (!perf_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	trace_file = create_file("trace", &trace_fops);
+	if (!trace_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	hist_file = create_file("hist", &hist_fops);
+	if (!hist_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	stats_file = create_file("stats", &stats_fops);
+	if (!stats_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	shape_file = create_file("shape", &shape_fops);
+	if (!shape_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	bench_file = create_file("bench", &bench_fops);
+	if (!bench_file) {
+		destroy_abac_fs();
+		return ;
+	}
+	engine_file = create_file("engine", &engine_fops);
+	if (!engine_file) {
+		destroy_abac_fs();
+		return ;
+	}
+}
+
+fs_initcall(abac_create_fs);
@@ -0,0 +1,113 @@
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/hashtable.h>
+#include <linux/spinlock.h>
+#include <linux/jhash.h>
+#include "access_trace.h"
+
+/*
+ * Access trace used to build PolTrees from real workloads.
+ * While tracing is on, every decision on a secured object is counted per
+ * (uid, path, op). The aggregated trace is read from the securityfs 'trace'
+ * file, one entry per line:
+ * <uid>:<path>:<op>:<count>
+ */
+struct trace_hnode {
+	unsigned int uid;
+	enum operation op;
+	u64 count;
+	char *path;
+	struct hlist_node node;
+};
+
+#define TRACE_BUCKETS 12 // (2 ^ 12 = 4096 buckets)
+
+DECLARE_HASHTABLE(trace_map, TRACE_BUCKETS);
+static DEFINE_SPINLOCK(trace_lock);
+static unsigned int trace_entries = 0;
+static u64 trace_dropped = 0;
+int tracing = 0;
+
+static u32 trace_key(unsigned int uid, const char *path, enum operation op) {
+	return jhash(path, strlen(path), jhash_2words(uid, op, 0));
+}
+
+void record_access(unsigned int uid, const char *path, enum operation op) {
+	/* Count one access. Called from the file_permission hook */
+	struct trace_hnode *cur;
+	u32 key = trace_key(uid, path, op);
+
+	spin_lock(&trace_lock);
+	hash_for_each_possible(trace_map, cur, node, key) {
+		if (cur->uid == uid && cur->op == op && strcmp(cur->path, path) == 0) {
+			cur->count++;
+			spin_unlock(&trace_lock);
+			return;
+		}
+	}
+	if (trace_entries == ABAC_TRACE_ENTRIES) {
+		trace_dropped++;
+		spin_unlock(&trace_lock);
+		return;
+	}
+	cur = kcalloc(1, sizeof(struct trace_hnode), GFP_ATOMIC);
+	if (cur) {
+		cur->path = kstrdup(path, GFP_ATOMIC);
+	}
+	if (!cur || !cur->path) {
+		kfree(cur);
+		trace_dropped++;
+		spin_unlock(&trace_lock);
+		return;
+	}
+	cur->uid = uid;
+	cur->op = op;
+	cur->count = 1;
+	hash_add(trace_map, &(cur->node), key);
+	trace_entries++;
+	spin_unlock(&trace_lock);
+}
+
+void show_access_trace(struct seq_file *m) {
+	struct trace_hnode *cur;
+	unsigned bkt;
+
+	spin_lock(&trace_lock);
+	hash_for_each(trace_map, bkt, cur, node) {
+		seq_printf(m, "%u:%s:%s:%llu\n", cur->uid, cur->path,
+			   cur->op == ABAC_MODIFY ? "MODIFY" : "READ", cur->count);
+	}
+	if (trace_dropped) {
+		printk("ABAC LSM: %llu accesses were not traced, trace table is full", trace_dropped);
+	}
+	spin_unlock(&trace_lock);
+}
+
+void clear_access_trace(void) {
+	struct trace_hnode *cur;
+	struct hlist_node *tmp;
+	unsigned bkt;
+
+	spin_lock(&trace_lock);
+	hash_for_each_safe(trace_map, bkt, tmp, cur, node) {
+		hash_del(&(cur->node));
+		kfree(cur->path);
+		kfree(cur);
+	}
+	trace_entries = 0;
+	trace_dropped = 0;
+	spin_unlock(&trace_lock);
+}
+
+void trace_mem_stats(struct abac_mem_stats *s) {
+	struct trace_hnode *cur;
+	unsigned bkt;
+
+	spin_lock(&trace_lock);
+	hash_for_each(trace_map, bkt, cur, node) {
+		mem_account(s, ABAC_MEM_TRACE, cur);
+		mem_account(s, ABAC_MEM_TRACE, cur->path);
+	}
+	spin_unlock(&trace_lock);
+}
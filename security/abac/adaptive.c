@@ -0,0 +1,548 @@
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "abacfs.h"
+#include "adaptive.h"
+#include "engine.h"
+#include "rules.h"
+#include "shape.h"
+
+/*
+ * Adaptive engines. Objects and the policy are loaded like for the rule
+ * engines, and the first access to an object chooses how it is evaluated:
+ * with its covering rule list, or with a decision tree compiled from the
+ * covering rules. Short lists are always kept. For longer ones the tree is
+ * built and kept if the attribute comparisons on its longest path are fewer
+ * than the predicates of the whole list.
+ *
+ * Each inner node tests one user or env attribute. A request follows the
+ * branch of its value, or the 'other' edge that holds the rules which do not
+ * test the attribute. A node grants READ or MODIFY once a covering rule has
+ * all its predicates on the path, so the tree decides like the list as long
+ * as users and env hold one value per attribute, as in the generated
+ * datasets. Trees point to the attribute pairs of the policy and are dropped
+ * before the policy is replaced.
+ */
+#define ADAPTIVE_LIST_RULES 2	/* lists up to this length are always kept */
+#define ADAPTIVE_MAX_RULES 64	/* longer lists are kept too */
+#define ADAPTIVE_MAX_PREDS 32	/* and so are lists with larger rules */
+#define ADAPTIVE_MAX_NODES 256	/* trees that grow larger are dropped */
+
+/* Operation granted at a node, MODIFY includes READ */
+enum {
+	GRANT_NONE,
+	GRANT_READ,
+	GRANT_MODIFY,
+};
+
+struct dbranch {
+	avp *value;
+	struct dtree *child;
+	struct dbranch *next;
+};
+
+struct dtree {
+	/* Attribute tested by the node, NULL for a leaf */
+	avp *attr;
+	/* Look the attribute up in env_attr instead of the user attributes */
+	int env;
+	int grant;
+	struct dbranch *head;
+	struct dtree *other;
+};
+
+/* Covering rule being compiled, pred[] holds its user then its env predicates */
+struct drule {
+	unsigned int npreds;
+	u32 env_mask;
+	int grant;
+	avp *pred[ADAPTIVE_MAX_PREDS];
+};
+
+struct dbuild {
+	struct drule *rules;
+	unsigned int nodes;
+	int failed;
+};
+
+/* Set while the policy is replaced, objects are evaluated as lists meanwhile */
+static int frozen = 1;
+
+static int load_drule(struct drule *d, abac_rule *r) {
+	/* Flatten the predicates of @r, fails if there are too many */
+	avp *a;
+
+	d->npreds = 0;
+	d->env_mask = 0;
+	d->grant = r->op == ABAC_MODIFY ? GRANT_MODIFY : GRANT_READ;
+	for (a = r->user; a != NULL; a = a->next) {
+		if (d->npreds == ADAPTIVE_MAX_PREDS) {
+			return -E2BIG;
+		}
+		d->pred[d->npreds++] = a;
+	}
+	for (a = r->env; a != NULL; a = a->next) {
+		if (d->npreds == ADAPTIVE_MAX_PREDS) {
+			return -E2BIG;
+		}
+		d->env_mask |= 1U << d->npreds;
+		d->pred[d->npreds++] = a;
+	}
+	return 0;
+}
+
+static u32 tested(struct drule *d, u32 left, avp *attr, int env) {
+	/* Predicates among @left that test @attr */
+	u32 mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < d->npreds; i++) {
+		if ((left & (1U << i)) && !!(d->env_mask & (1U << i)) == env &&
+		    avp_same_name(d->pred[i], attr)) {
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+}
+
+static int all_equal(struct drule *d, u32 mask, avp *value) {
+	/* Every predicate in @mask has the value of @value */
+	unsigned int i;
+
+	for (i = 0; i < d->npreds; i++) {
+		if ((mask & (1U << i)) && !avp_equal(d->pred[i], value)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void clear_obj_dtree(struct dtree *t) {
+	struct dbranch *b, *to_free;
+
+	if (t == NULL) {
+		return;
+	}
+	b = t->head;
+	while (b != NULL) {
+		clear_obj_dtree(b->child);
+		to_free = b;
+		b = b->next;
+		kfree(to_free);
+	}
+	clear_obj_dtree(t->other);
+	kfree(t);
+}
+
+static struct dtree *build_dtree(struct dbuild *b, unsigned int *idx, u32 *left, unsigned int n,
+				 int grant) {
+	/* Build the node reached by the rules idx[0..n), left[] holding the
+	 * predicates of each rule not tested on the path yet. Returns NULL if
+	 * nothing can be granted below the node. idx and left are reused */
+	struct dtree *t;
+	struct dbranch *br;
+	struct drule *d;
+	unsigned int i, j, k, m, p, count, best_count, *cidx;
+	u32 mask, *cleft;
+	avp *attr, *value;
+	int env;
+
+	// rules whose predicates were all tested are satisfied
+	for (i = 0; i < n; i++) {
+		d = &b->rules[idx[i]];
+		if (left[i] == 0 && d->grant > grant) {
+			grant = d->grant;
+		}
+	}
+	// keep the rules that could still grant more
+	m = 0;
+	for (i = 0; i < n; i++) {
+		if (left[i] == 0 || b->rules[idx[i]].grant <= grant) {
+			continue;
+		}
+		idx[m] = idx[i];
+		left[m] = left[i];
+		m++;
+	}
+	if (m == 0 && grant == GRANT_NONE) {
+		return NULL;
+	}
+	if (++b->nodes > ADAPTIVE_MAX_NODES) {
+		b->failed = 1;
+		return NULL;
+	}
+	t = kzalloc(sizeof(struct dtree), GFP_KERNEL);
+	if (!t) {
+		b->failed = 1;
+		return NULL;
+	}
+	t->grant = grant;
+	if (m == 0) {
+		return t;
+	}
+
+	// test the attribute left in the most rules first
+	attr = NULL;
+	env = 0;
+	best_count = 0;
+	for (i = 0; i < m; i++) {
+		d = &b->rules[idx[i]];
+		for (p = 0; p < d->npreds; p++) {
+			if (!(left[i] & (1U << p))) {
+				continue;
+			}
+			count = 0;
+			for (j = 0; j < m; j++) {
+				count += tested(&b->rules[idx[j]], left[j], d->pred[p],
+						!!(d->env_mask & (1U << p))) != 0;
+			}
+			if (count > best_count) {
+				best_count = count;
+				attr = d->pred[p];
+				env = !!(d->env_mask & (1U << p));
+			}
+		}
+	}
+	t->attr = attr;
+	t->env = env;
+
+	cidx = kmalloc_array(m, sizeof(unsigned int), GFP_KERNEL);
+	cleft = kmalloc_array(m, sizeof(u32), GFP_KERNEL);
+	if (!cidx || !cleft) {
+		b->failed = 1;
+		goto out;
+	}
+	// rules that do not test the attribute
+	k = 0;
+	for (j = 0; j < m; j++) {
+		if (!tested(&b->rules[idx[j]], left[j], attr, env)) {
+			cidx[k] = idx[j];
+			cleft[k] = left[j];
+			k++;
+		}
+	}
+	if (k) {
+		t->other = build_dtree(b, cidx, cleft, k, grant);
+	}
+	// one branch per value, also holding the rules that do not test the attribute
+	for (i = 0; i < m && !b->failed; i++) {
+		mask = tested(&b->rules[idx[i]], left[i], attr, env);
+		if (!mask) {
+			continue;
+		}
+		value = b->rules[idx[i]].pred[__ffs(mask)];
+		for (br = t->head; br != NULL; br = br->next) {
+			if (avp_equal(br->value, value)) {
+				break;
+			}
+		}
+		if (br != NULL) {
+			continue;
+		}
+		k = 0;
+		for (j = 0; j < m; j++) {
+			d = &b->rules[idx[j]];
+			mask = tested(d, left[j], attr, env);
+			if (mask && !all_equal(d, mask, value)) {
+				continue;
+			}
+			cidx[k] = idx[j];
+			cleft[k] = left[j] & ~mask;
+			k++;
+		}
+		br = kzalloc(sizeof(struct dbranch), GFP_KERNEL);
+		if (!br) {
+			b->failed = 1;
+			break;
+		}
+		br->value = value;
+		br->child = build_dtree(b, cidx, cleft, k, grant);
+		br->next = t->head;
+		t->head = br;
+	}
+out:
+	kfree(cidx);
+	kfree(cleft);
+	return t;
+}
+
+static unsigned int dtree_cost(struct dtree *t) {
+	/* Attribute comparisons on the longest path of @t, one to find the
+	 * attribute of each node and one per branch of the node */
+	struct dbranch *b;
+	unsigned int cost, max, c;
+
+	if (t == NULL || t->attr == NULL) {
+		return 0;
+	}
+	cost = 1;
+	max = dtree_cost(t->other);
+	for (b = t->head; b != NULL; b = b->next) {
+		cost++;
+		c = dtree_cost(b->child);
+		if (c > max) {
+			max = c;
+		}
+	}
+	return cost + max;
+}
+
+static unsigned int dtree_nodes(struct dtree *t) {
+	struct dbranch *b;
+	unsigned int n;
+
+	if (t == NULL) {
+		return 0;
+	}
+	n = 1 + dtree_nodes(t->other);
+	for (b = t->head; b != NULL; b = b->next) {
+		n += dtree_nodes(b->child);
+	}
+	return n;
+}
+
+static void choose_form(struct rule_obj *o) {
+	/* Pick the cheaper representation of @o and publish it */
+	struct dbuild b = {};
+	struct dtree *t = NULL;
+	obj_rule *r, *head;
+	abac_rule *rule;
+	unsigned int n, i, list_cost, *idx = NULL;
+	u32 *left = NULL;
+	int form = ADAPTIVE_LIST;
+
+	head = get_rule_obj_list(o);
+	if (head == NULL) {
+		return;
+	}
+	n = 0;
+	for (r = head; r != NULL; r = r->next) {
+		n += get_rule(r->id) != NULL;
+	}
+	if (n <= ADAPTIVE_LIST_RULES || n > ADAPTIVE_MAX_RULES) {
+		goto publish;
+	}
+	b.rules = kcalloc(n, sizeof(struct drule), GFP_KERNEL);
+	idx = kmalloc_array(n, sizeof(unsigned int), GFP_KERNEL);
+	left = kmalloc_array(n, sizeof(u32), GFP_KERNEL);
+	if (!b.rules || !idx || !left) {
+		goto out;
+	}
+	i = 0;
+	list_cost = 0;
+	for (r = head; r != NULL; r = r->next) {
+		rule = get_rule(r->id);
+		if (rule == NULL) {
+			continue;
+		}
+		if (load_drule(&b.rules[i], rule)) {
+			goto out;
+		}
+		idx[i] = i;
+		left[i] = (u32)((1ULL << b.rules[i].npreds) - 1);
+		list_cost += 1 + b.rules[i].npreds;
+		i++;
+	}
+	t = build_dtree(&b, idx, left, n, GRANT_NONE);
+	if (!b.failed && t != NULL && dtree_cost(t) < list_cost) {
+		if (cmpxchg(&o->tree, NULL, t) == NULL) {
+			t = NULL;
+		}
+		form = ADAPTIVE_TREE;
+	}
+out:
+	clear_obj_dtree(t);
+	kfree(b.rules);
+	kfree(idx);
+	kfree(left);
+publish:
+	cmpxchg(&o->form, ADAPTIVE_NONE, form);
+}
+
+static __always_inline int __resolve_dtree(avp *user_attr, struct dtree *t, enum operation op,
+					   const int encoded) {
+	/* 1 if the path of the request through @t reaches a node granting @op */
+	int need = op == ABAC_MODIFY ? GRANT_MODIFY : GRANT_READ;
+	struct dbranch *b;
+	struct dtree *next;
+	avp *a;
+
+	while (t != NULL) {
+		if (t->grant >= need) {
+			return 1;
+		}
+		if (t->attr == NULL) {
+			return 0;
+		}
+		a = t->env ? env_attr : user_attr;
+		while (a != NULL && !avp_name_match(a, t->attr, encoded)) {
+			a = a->next;
+		}
+		next = t->other;
+		if (a != NULL) {
+			for (b = t->head; b != NULL; b = b->next) {
+				if (avp_value_match(a, b->value, encoded)) {
+					next = b->child;
+					break;
+				}
+			}
+		}
+		t = next;
+	}
+	return 0;
+}
+
+static __always_inline int __resolve(avp *user_attr, void *obj, enum operation op,
+				     const int encoded) {
+	struct rule_obj *o = obj;
+
+	if (o != NULL && smp_load_acquire(&o->form) == ADAPTIVE_TREE && !READ_ONCE(frozen)) {
+		/* Same checks as resolve_rules() before the rules */
+		if (user_attr == NULL) {
+			return 0;
+		}
+		if (op == ABAC_IGNORE) {
+			return 1;
+		}
+		return __resolve_dtree(user_attr, READ_ONCE(o->tree), op, encoded);
+	}
+	return resolve_rules(user_attr, o ? get_rule_obj_list(o) : NULL, op);
+}
+
+static int resolve_str(avp *user_attr, void *obj, enum operation op) {
+	return __resolve(user_attr, obj, op, 0);
+}
+
+static int resolve_enc(avp *user_attr, void *obj, enum operation op) {
+	return __resolve(user_attr, obj, op, 1);
+}
+
+static void *with_form(struct rule_obj *o) {
+	/* Choose the representation of @o on its first lookup */
+	if (o != NULL && smp_load_acquire(&o->form) == ADAPTIVE_NONE && !READ_ONCE(frozen)) {
+		choose_form(o);
+	}
+	return o;
+}
+
+static void *lookup(char *path) {
+	return with_form(get_rule_obj(path));
+}
+
+static void *lookup_dentry(struct dentry *dentry) {
+	return with_form(get_rule_obj_dentry(dentry));
+}
+
+static void reset_form(struct rule_obj *o, void *arg) {
+	clear_obj_dtree(o->tree);
+	o->tree = NULL;
+	o->form = ADAPTIVE_NONE;
+}
+
+static void drop_trees(void) {
+	/* Stop using trees, wait for the decisions that still do and free them */
+	WRITE_ONCE(frozen, 1);
+	engine_synchronize();
+	for_each_rule_obj(reset_form, NULL);
+}
+
+static void load_policy(char *data) {
+	drop_trees();
+	load_rule_policy(data);
+	WRITE_ONCE(frozen, 0);
+}
+
+static void clear_adaptive_policy(void) {
+	drop_trees();
+	clear_policy();
+}
+
+void obj_dtree_mem_stats(struct dtree *t, struct abac_mem_stats *s) {
+	struct dbranch *b;
+
+	if (t == NULL) {
+		return;
+	}
+	mem_account(s, ABAC_MEM_TREE_NODES, t);
+	obj_dtree_mem_stats(t->other, s);
+	for (b = t->head; b != NULL; b = b->next) {
+		mem_account(s, ABAC_MEM_BRANCHES, b);
+		obj_dtree_mem_stats(b->child, s);
+	}
+}
+
+static void mem_stats(struct abac_mem_stats *s) {
+	rule_obj_mem_stats(s);
+	policy_mem_stats(s);
+}
+
+static void form_shape(struct rule_obj *o, void *arg) {
+	struct shape_hist *h = arg;
+	obj_rule *r;
+	unsigned int n = 0;
+
+	switch (smp_load_acquire(&o->form)) {
+	case ADAPTIVE_LIST:
+		for (r = smp_load_acquire(&o->head); r != NULL; r = r->next) {
+			n++;
+		}
+		shape_add(&h[0], n);
+		break;
+	case ADAPTIVE_TREE:
+		shape_add(&h[1], dtree_nodes(o->tree));
+		break;
+	}
+}
+
+static void show_shape(struct seq_file *m) {
+	/* Rule list length of the objects evaluated as lists and node count of
+	 * the objects evaluated as trees, for the objects accessed so far */
+	struct shape_hist *h;
+
+	show_rule_obj_shape(m);
+	h = kcalloc(2, sizeof(struct shape_hist), GFP_KERNEL);
+	if (!h) {
+		return;
+	}
+	for_each_rule_obj(form_shape, h);
+	show_shape_hist(m, "adaptive_list", &h[0]);
+	show_shape_hist(m, "adaptive_tree", &h[1]);
+	kfree(h);
+}
+
+const struct abac_engine adaptive_engine = {
+	.name = "adaptive",
+	.encoded = 0,
+	.obj_file = "obj_rules",
+	.load_objects = load_rule_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_policy,
+	.clear_policy = clear_adaptive_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_str,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
+
+const struct abac_engine adaptive_enc_engine = {
+	.name = "adaptive_enc",
+	.encoded = 1,
+	.obj_file = "obj_rules",
+	.load_objects = load_rule_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_policy,
+	.clear_policy = clear_adaptive_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_enc,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
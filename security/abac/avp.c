@@ -0,0 +1,112 @@
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/jhash.h>
+#include "avp.h"
+
+int avp_encoded = 0;
+
+void clear_avp_list(avp *head)
+{
+	// Free the avp linked list given by head
+	avp* cursor = head;
+	avp* to_free = NULL;
+	while (cursor != NULL) {
+		to_free = cursor;
+		cursor = cursor->next;
+		kfree(to_free);
+	}
+}
+
+avp *new_avp(char *name, char *value) {
+	/* Allocate a single pair in the representation of the loaded datasets */
+	avp *a;
+
+	a = kzalloc(avp_encoded ? AVP_ENC_SIZE : sizeof(avp), GFP_KERNEL);
+	if (!a) {
+		return NULL;
+	}
+	if (avp_encoded) {
+		kstrtoint(name, 10, &(a->name_id));
+		kstrtoint(value, 10, &(a->value_id));
+	} else {
+		strcpy(a->name, name);
+		strcpy(a->value, value);
+	}
+	return a;
+}
+
+avp *parse_avp(char *avp_str) {
+	/* Parse a collection of name=value pairs separated by commas */
+	avp *head, *temp;
+	char *pair, *name;
+	head = NULL;
+	while((pair = strsep(&avp_str, ",")) != NULL) {
+		name = strsep(&pair, "=");
+		temp = new_avp(name, pair);
+		if (!temp) {
+			break;
+		}
+		if (head) {
+			temp->next = head;
+		}
+		head = temp;
+	}
+	return head;
+}
+
+void print_avp(avp *head) {
+	avp *cursor;
+	cursor = head;
+	while (cursor != NULL) {
+		if (avp_encoded) {
+			printk("%d=%d", cursor->name_id, cursor->value_id);
+		} else {
+			printk("%s=%s", cursor->name, cursor->value);
+		}
+		cursor = cursor->next;
+	}
+}
+
+u32 avp_hash(avp *a) {
+	/* Hash of a single name=value pair */
+	if (avp_encoded) {
+		return jhash_2words(a->name_id, a->value_id, 0);
+	}
+	return jhash(a->name, strlen(a->name), jhash(a->value, strlen(a->value), 0));
+}
+
+int avp_equal(avp *a, avp *b) {
+	return avp_encoded ? avp_match(a, b, 1) : avp_match(a, b, 0);
+}
+
+int avp_same_name(avp *a, avp *b) {
+	return avp_encoded ? avp_name_match(a, b, 1) : avp_name_match(a, b, 0);
+}
+
+int avp_list_contains(avp *head, avp *a) {
+	/* Check if the pair @a is present in the list given by head */
+	while (head != NULL) {
+		if (avp_equal(head, a)) {
+			return 1;
+		}
+		head = head->next;
+	}
+	return 0;
+}
+
+unsigned int avp_list_len(avp *head) {
+	unsigned int n = 0;
+	while (head != NULL) {
+		n++;
+		head = head->next;
+	}
+	return n;
+}
+
+void avp_list_mem_stats(avp *head, struct abac_mem_stats *s) {
+	while (head != NULL) {
+		mem_account(s, ABAC_MEM_AVPS, head);
+		head = head->next;
+	}
+}
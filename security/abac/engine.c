@@ -0,0 +1,104 @@
+#include <linux/kernel.h>
+#include <linux/srcu.h>
+#include <linux/string.h>
+#include "engine.h"
+#include "user.h"
+
+/*
+ * Engine selection
+ *
+ * Decisions run between engine_read_lock() and engine_read_unlock(). While
+ * the engine is switched the active engine is NULL and requests are denied,
+ * as when nothing is loaded. set_engine() returns once no decision uses the
+ * previous engine anymore, so its data can be freed afterwards.
+ */
+static const struct abac_engine *const engines[] = {
+	&rules_engine,
+	&rules_enc_engine,
+	&trees_engine,
+	&trees_enc_engine,
+	&adaptive_engine,
+	&adaptive_enc_engine,
+	&mdd_engine,
+	&mdd_enc_engine,
+	&index_engine,
+	&index_enc_engine,
+};
+
+DEFINE_STATIC_SRCU(engine_srcu);
+static const struct abac_engine *active_engine = &rules_engine;
+
+const struct abac_engine *find_engine(const char *name) {
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(engines); i++) {
+		if (strcmp(engines[i]->name, name) == 0) {
+			return engines[i];
+		}
+	}
+	return NULL;
+}
+
+const struct abac_engine *set_engine(const struct abac_engine *e) {
+	/* Make @e the active engine, or none if @e is NULL, and return the
+	 * previous one. Callers serialize switches */
+	const struct abac_engine *old = active_engine;
+
+	WRITE_ONCE(active_engine, NULL);
+	synchronize_srcu(&engine_srcu);
+	if (old && old->stop) {
+		old->stop();
+	}
+	if (e) {
+		avp_encoded = e->encoded;
+		if (e->start) {
+			e->start();
+		}
+	}
+	WRITE_ONCE(active_engine, e);
+	return old;
+}
+
+const struct abac_engine *get_engine(void) {
+	/* Stays valid until engine_read_unlock(), may be NULL while switching */
+	return READ_ONCE(active_engine);
+}
+
+int engine_read_lock(void) {
+	return srcu_read_lock(&engine_srcu);
+}
+
+void engine_read_unlock(int idx) {
+	srcu_read_unlock(&engine_srcu, idx);
+}
+
+void engine_synchronize(void) {
+	/* Wait for the decisions that started before the call */
+	synchronize_srcu(&engine_srcu);
+}
+
+int engine_decide(unsigned int uid, char *path, enum operation op) {
+	/* Decide a request with the active engine like abac_file_permission()
+	 * does once it has the path. Returns 1 if allowed */
+	const struct abac_engine *e;
+	int idx, decision = 0;
+
+	idx = engine_read_lock();
+	e = get_engine();
+	if (e != NULL) {
+		decision = e->resolve(get_user_attrs(uid), e->lookup(path), op);
+	}
+	engine_read_unlock(idx);
+	return decision;
+}
+
+void show_engines(struct seq_file *m) {
+	/* All engines on one line, the active one in brackets */
+	const struct abac_engine *e = get_engine();
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(engines); i++) {
+		seq_printf(m, engines[i] == e ? "%s[%s]" : "%s%s", i ? " " : "", engines[i]->name);
+	}
+	seq_printf(m, "\n");
+}
@@ -27,10 +27,10 @@ avp *parse_env_attr(char *data)
 			break;
 		}
 		name = strsep(&pair, "=");
-		temp = kcalloc(1, sizeof(avp), GFP_KERNEL);
-		temp->next = NULL;
-		strcpy(temp->name, name);
-		strcpy(temp->value, pair);
+		temp = new_avp(name, pair);
+		if (!temp) {
+			break;
+		}
 		if (head) {
 			temp->next = head;
 		}
@@ -41,14 +41,9 @@ avp *parse_env_attr(char *data)
 
 void print_env_attrs(avp *head)
 {
-	avp *cursor;
 	if (head == NULL) {
 		return;
 	}
-	cursor = head;
 	printk("Environment Attributes");
-	while (cursor != NULL) {
-		printk("%s=%s", cursor->name, cursor->value);
-		cursor = cursor->next;
-	}
+	print_avp(head);
 }
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM abac
+
+#if !defined(_ABAC_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _ABAC_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * One event per decision of the file_permission hook on a secured object.
+ * The stage timings are taken only while the event is enabled:
+ * path_ns	kmalloc and dentry_path_raw() of the accessed file
+ * user_ns	lookup of the user attributes
+ * obj_ns	lookup of the object rules or tree
+ * eval_ns	resolve() of the active engine
+ * The path is recorded as resolved, as in the access trace.
+ */
+TRACE_EVENT(abac_decision,
+
+	TP_PROTO(const char *engine, unsigned int uid, const char *path, int op,
+		 int allowed, u64 path_ns, u64 user_ns, u64 obj_ns, u64 eval_ns),
+
+	TP_ARGS(engine, uid, path, op, allowed, path_ns, user_ns, obj_ns, eval_ns),
+
+	TP_STRUCT__entry(
+		__string(engine, engine)
+		__field(unsigned int, uid)
+		__string(path, path)
+		__field(int, op)
+		__field(int, allowed)
+		__field(u64, path_ns)
+		__field(u64, user_ns)
+		__field(u64, obj_ns)
+		__field(u64, eval_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(engine, engine);
+		__entry->uid = uid;
+		__assign_str(path, path);
+		__entry->op = op;
+		__entry->allowed = allowed;
+		__entry->path_ns = path_ns;
+		__entry->user_ns = user_ns;
+		__entry->obj_ns = obj_ns;
+		__entry->eval_ns = eval_ns;
+	),
+
+	TP_printk("engine=%s uid=%u path=%s op=%s decision=%s path_ns=%llu user_ns=%llu obj_ns=%llu eval_ns=%llu",
+		  __get_str(engine), __entry->uid, __get_str(path),
+		  __print_symbolic(__entry->op, { 0, "MODIFY" }, { 1, "READ" }, { 2, "IGNORE" }),
+		  __entry->allowed ? "ALLOW" : "DENY",
+		  __entry->path_ns, __entry->user_ns, __entry->obj_ns, __entry->eval_ns)
+);
+
+#endif /* _ABAC_TRACE_H */
+
+/* The header is found through the ccflags-y include path of the LSM */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE abac_trace
+#include <trace/define_trace.h>
@@ -5,8 +5,10 @@
 #include "avp.h"
 #include "env.h"
 #include "user.h"
-#include "obj.h"
 #include "policy.h"
+#include "rules.h"
+#include "trees.h"
+#include "engine.h"
 
 /* Pointer to the environment attribute list. Initialized in abacfs */
 extern avp *env_attr;
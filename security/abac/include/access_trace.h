@@ -0,0 +1,18 @@
+#ifndef _ABAC_ACCESS_TRACE_H
+#define _ABAC_ACCESS_TRACE_H
+
+#include <linux/seq_file.h>
+#include "mem_stats.h"
+#include "avp.h"
+
+/* Maximum number of distinct (uid, path, op) entries kept while tracing */
+#define ABAC_TRACE_ENTRIES 65536
+
+extern int tracing;
+
+void record_access(unsigned int, const char *, enum operation);
+void show_access_trace(struct seq_file *);
+void clear_access_trace(void);
+void trace_mem_stats(struct abac_mem_stats *);
+
+#endif /* _ABAC_ACCESS_TRACE_H */
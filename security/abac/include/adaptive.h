@@ -0,0 +1,19 @@
+#ifndef _ABAC_ADAPTIVE_H
+#define _ABAC_ADAPTIVE_H
+
+#include "avp.h"
+#include "mem_stats.h"
+
+/* Representation of an object in the adaptive engines */
+enum adaptive_form {
+	ADAPTIVE_NONE,	/* not chosen yet */
+	ADAPTIVE_LIST,	/* covering rule list, as in the rule engines */
+	ADAPTIVE_TREE,	/* decision tree compiled from the covering rules */
+};
+
+struct dtree;
+
+void clear_obj_dtree(struct dtree *);
+void obj_dtree_mem_stats(struct dtree *, struct abac_mem_stats *);
+
+#endif /* _ABAC_ADAPTIVE_H */
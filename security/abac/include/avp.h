@@ -0,0 +1,71 @@
+#ifndef _ABAC_AVP_H
+#define _ABAC_AVP_H
+
+#include <linux/stddef.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include "mem_stats.h"
+
+#define MAX_STR 32
+
+enum operation {ABAC_MODIFY, ABAC_READ, ABAC_IGNORE};
+
+/*
+ * A name=value pair. The original datasets hold strings and the encoded
+ * datasets hold integers, avp_encoded tells which one is loaded. Encoded
+ * pairs are allocated without the strings, so the union comes last.
+ */
+typedef struct avp avp;
+struct avp {
+	avp *next;
+	union {
+		struct {
+			int name_id;
+			int value_id;
+		};
+		struct {
+			char name[MAX_STR];
+			char value[MAX_STR];
+		};
+	};
+};
+
+#define AVP_ENC_SIZE offsetofend(struct avp, value_id)
+
+/* Pairs are parsed as integers. Follows the active engine, see set_engine() */
+extern int avp_encoded;
+
+static __always_inline int avp_match(const avp *a, const avp *b, const int encoded) {
+	/* The resolvers pass a constant @encoded, so only one comparison is built */
+	if (encoded) {
+		return a->name_id == b->name_id && a->value_id == b->value_id;
+	}
+	return strcmp(a->name, b->name) == 0 && strcmp(a->value, b->value) == 0;
+}
+
+static __always_inline int avp_name_match(const avp *a, const avp *b, const int encoded) {
+	if (encoded) {
+		return a->name_id == b->name_id;
+	}
+	return strcmp(a->name, b->name) == 0;
+}
+
+static __always_inline int avp_value_match(const avp *a, const avp *b, const int encoded) {
+	if (encoded) {
+		return a->value_id == b->value_id;
+	}
+	return strcmp(a->value, b->value) == 0;
+}
+
+avp *new_avp(char *, char *);
+avp *parse_avp(char *);
+void print_avp(avp *);
+void clear_avp_list(avp *);
+u32 avp_hash(avp *);
+int avp_equal(avp *, avp *);
+int avp_same_name(avp *, avp *);
+int avp_list_contains(avp *, avp *);
+unsigned int avp_list_len(avp *);
+void avp_list_mem_stats(avp *, struct abac_mem_stats *);
+
+#endif /* _ABAC_AVP_H */
@@ -0,0 +1,72 @@
+#ifndef _ABAC_ENGINE_H
+#define _ABAC_ENGINE_H
+
+#include <linux/seq_file.h>
+#include "avp.h"
+#include "mem_stats.h"
+
+struct dentry;
+
+/*
+ * Policy evaluation engine
+ *
+ * Users and environment attributes are shared by all engines, each engine
+ * keeps its own object table and, for the rule engines, its own policy. The
+ * datasets of the engines differ, so selecting another engine through the
+ * securityfs 'engine' file unloads everything and the dataset of the new
+ * engine is loaded afterwards.
+ */
+struct abac_engine {
+	/* Name written to the 'engine' file */
+	const char *name;
+	/* Attribute names and values of the datasets are integers */
+	int encoded;
+	/* securityfs file the objects are loaded from */
+	const char *obj_file;
+	/* Load and clear the object file, @data is kept until the clear */
+	void (*load_objects)(char *data);
+	void (*clear_objects)(void);
+	/* Load and clear the policy file, NULL if the objects carry the policy */
+	void (*load_policy)(char *data);
+	void (*clear_policy)(void);
+	/* Optional, called when the engine becomes active and inactive */
+	void (*start)(void);
+	void (*stop)(void);
+	/* Object loaded for @path or its nearest ancestor, NULL if there is none */
+	void *(*lookup)(char *path);
+	/* Same as lookup() for the path dentry_path_raw() builds, used by the
+	 * LSM hook so that the path is not built */
+	void *(*lookup_dentry)(struct dentry *dentry);
+	/* Optional, object of the files whose security.abac xattr holds @value,
+	 * ERR_PTR(-EINVAL) if no object can be given to @value and NULL if
+	 * memory runs out. The objects are never freed, see abac_lsm.c */
+	void *(*lookup_xattr)(char *value);
+	/* 1 if @user_attr may perform @op on @obj in the current env_attr, 0 otherwise */
+	int (*resolve)(avp *user_attr, void *obj, enum operation op);
+	/* Paths of the loaded objects, see get_rule_obj_paths() */
+	char **(*get_obj_paths)(unsigned int *n);
+	void (*mem_stats)(struct abac_mem_stats *);
+	void (*show_shape)(struct seq_file *);
+};
+
+extern const struct abac_engine rules_engine;
+extern const struct abac_engine rules_enc_engine;
+extern const struct abac_engine trees_engine;
+extern const struct abac_engine trees_enc_engine;
+extern const struct abac_engine adaptive_engine;
+extern const struct abac_engine adaptive_enc_engine;
+extern const struct abac_engine mdd_engine;
+extern const struct abac_engine mdd_enc_engine;
+extern const struct abac_engine index_engine;
+extern const struct abac_engine index_enc_engine;
+
+const struct abac_engine *find_engine(const char *);
+const struct abac_engine *set_engine(const struct abac_engine *);
+const struct abac_engine *get_engine(void);
+int engine_read_lock(void);
+void engine_read_unlock(int);
+void engine_synchronize(void);
+int engine_decide(unsigned int, char *, enum operation);
+void show_engines(struct seq_file *);
+
+#endif /* _ABAC_ENGINE_H */
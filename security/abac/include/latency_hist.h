@@ -0,0 +1,15 @@
+#ifndef _ABAC_LATENCY_HIST_H
+#define _ABAC_LATENCY_HIST_H
+
+#include <linux/seq_file.h>
+#include "avp.h"
+
+/* Bucket b counts latencies in [2^(b-1), 2^b) ns, bucket 0 counts 0 ns */
+#define ABAC_HIST_BUCKETS 65
+#define ABAC_HIST_OPS (ABAC_IGNORE + 1)
+
+void record_latency(int allowed, enum operation, u64 ns);
+void show_latency_hist(struct seq_file *);
+void reset_latency_hist(void);
+
+#endif /* _ABAC_LATENCY_HIST_H */
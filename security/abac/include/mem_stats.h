@@ -0,0 +1,42 @@
+#ifndef _ABAC_MEM_STATS_H
+#define _ABAC_MEM_STATS_H
+
+#include <linux/slab.h>
+#include <linux/types.h>
+
+/*
+ * Kernel memory held by the loaded data, per structure type. Filled by walking
+ * the tables when the securityfs 'stats' file is read, so accounting costs
+ * nothing while the tables are used. Heap objects are counted with ksize(),
+ * which includes the rounding up to the kmalloc size class.
+ */
+enum abac_mem_type {
+	ABAC_MEM_USERS,		/* user table entries and user pair counts */
+	ABAC_MEM_AVPS,		/* attribute pairs of users, rules and env */
+	ABAC_MEM_OBJECTS,	/* object table entries */
+	ABAC_MEM_TRIE,		/* path component nodes of the object tables */
+	ABAC_MEM_RULE_REFS,	/* compiled covering rule lists of objects */
+	ABAC_MEM_RULES,		/* policy rules and per rule arrays */
+	ABAC_MEM_TREE_NODES,	/* compiled PolTree nodes */
+	ABAC_MEM_BRANCHES,	/* compiled PolTree branches */
+	ABAC_MEM_DIAGRAM,	/* nodes and variables of the policy decision diagram */
+	ABAC_MEM_INDEX,		/* inverted index from object pairs to rules */
+	ABAC_MEM_BUFFERS,	/* securityfs text buffers kept after parsing */
+	ABAC_MEM_TRACE,		/* access trace entries */
+	ABAC_MEM_TYPES,
+};
+
+struct abac_mem_stats {
+	u64 count[ABAC_MEM_TYPES];
+	u64 bytes[ABAC_MEM_TYPES];
+};
+
+static inline void mem_account(struct abac_mem_stats *s, enum abac_mem_type type, const void *p)
+{
+	if (p) {
+		s->count[type]++;
+		s->bytes[type] += ksize(p);
+	}
+}
+
+#endif /* _ABAC_MEM_STATS_H */
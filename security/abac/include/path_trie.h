@@ -0,0 +1,45 @@
+#ifndef _ABAC_PATH_TRIE_H
+#define _ABAC_PATH_TRIE_H
+
+#include <linux/list.h>
+#include <linux/types.h>
+#include "mem_stats.h"
+#include "shape.h"
+
+/*
+ * Trie over the components of object paths, see path_trie.c. Every node holds
+ * one component and the object loaded for the path that ends there, if any.
+ */
+#define PATH_TRIE_MIN_BITS 4
+#define PATH_TRIE_MAX_BITS 22
+#define PATH_TRIE_MAX_DEPTH 64
+
+struct path_trie_node {
+	struct path_trie_node *parent;
+	void *obj;
+	struct hlist_node edge;
+	unsigned int len;
+	char name[];
+};
+
+struct path_trie {
+	struct path_trie_node root;
+	/* Edges from a node to its children, keyed by the parent and the
+	 * component. 2 ^ bits buckets sized by path_trie_init() */
+	struct hlist_head *edges;
+	unsigned int bits;
+	unsigned int nodes;
+};
+
+struct dentry;
+
+int path_trie_init(struct path_trie *, unsigned int);
+struct path_trie_node *path_trie_insert(struct path_trie *, const char *);
+void *path_trie_lookup(struct path_trie *, const char *);
+void *path_trie_lookup_prefix(struct path_trie *, const char *);
+void *path_trie_lookup_dentry(struct path_trie *, struct dentry *, int);
+void path_trie_clear(struct path_trie *);
+void path_trie_mem_stats(struct path_trie *, struct abac_mem_stats *);
+void path_trie_chains(struct path_trie *, struct shape_hist *);
+
+#endif /* _ABAC_PATH_TRIE_H */
@@ -0,0 +1,63 @@
+#ifndef _ABAC_POLICY_H
+#define _ABAC_POLICY_H
+
+#include <linux/limits.h>
+#include <linux/types.h>
+#include "avp.h"
+
+typedef struct abac_rule abac_rule;
+struct abac_rule {
+	unsigned int id;
+	avp *user;
+	avp *env;
+	enum operation op;
+	/* Object predicates, only used to derive covering rules, see index.c */
+	avp *obj;
+	/* Test env predicates before user predicates. Set by compile_policy() */
+	int env_first;
+};
+
+/*
+ * Compiled policy of the rule engines, built by compile_policy(). The rules
+ * are stored by slot, in id order without the missing ids, with one array
+ * per field. The predicates of slot s are preds[pred_start[s]..env_start[s])
+ * for the user and preds[env_start[s]..pred_start[s + 1]) for the env, in the
+ * order chosen by compile_policy().
+ */
+#define RULE_NO_SLOT UINT_MAX
+
+struct rule_pred {
+	int name_id;
+	int value_id;
+	/* Pair of the abac_rule, compared as strings when not encoded */
+	const avp *pair;
+};
+
+struct rule_store {
+	unsigned int n;
+	/* Slot of every id below get_policy_size(), RULE_NO_SLOT if missing */
+	unsigned int *slot;
+	unsigned int *id;
+	u8 *op;
+	u8 *env_first;
+	unsigned int *pred_start;
+	unsigned int *env_start;
+	struct rule_pred *preds;
+};
+
+/* NULL until a policy is compiled */
+extern struct rule_store *rule_store;
+
+void parse_policy(char *, avp *);
+abac_rule *get_rule(unsigned int );
+unsigned int get_policy_size(void);
+int rule_dominates(unsigned int, unsigned int);
+void record_rule_hit(unsigned int);
+void pause_rule_hits(int);
+void update_rule_scores(void);
+u64 get_rule_score(unsigned int);
+void print_policy(void);
+void clear_policy(void);
+void policy_mem_stats(struct abac_mem_stats *);
+
+#endif /* _ABAC_POLICY_H */
@@ -0,0 +1,83 @@
+#ifndef _ABAC_RULES_H
+#define _ABAC_RULES_H
+
+#include <linux/seq_file.h>
+#include <linux/types.h>
+#include "avp.h"
+
+struct dentry;
+
+/* Covering rule list of an object, ids index the policy array */
+typedef struct obj_rule obj_rule;
+struct obj_rule {
+	unsigned int id;
+	obj_rule *next;
+};
+
+/*
+ * Covering rules of an object as slots of rule_store, the rules granting
+ * MODIFY first. MODIFY requests only test slot[0..n_modify)
+ */
+struct rule_range {
+	unsigned int n;
+	unsigned int n_modify;
+	unsigned int slot[];
+};
+
+/* Entry of the object table, see rule_obj.c */
+struct rule_obj {
+	char *path;
+	/* Rule ids of the obj_rules line, compiled into head on first access */
+	char *raw;
+	/* Attributes of the obj_attrs line, the index engines derive head from them */
+	avp *attrs;
+	obj_rule *head;
+	/* Rules dropped from head when it was pruned, see prune_list() */
+	unsigned int pruned;
+	/* Rule list of the rule engines, see get_rule_obj_range() */
+	struct rule_range *range;
+	/* Representation chosen by the adaptive engines, see adaptive.c */
+	int form;
+	struct dtree *tree;
+	/* Root in the decision diagram of the mdd engines, see mdd.c */
+	struct mdd_node *mdd;
+	struct hlist_node node;
+};
+
+void parse_obj_rule_map(char *);
+void parse_obj_attrs_map(char *);
+struct rule_obj *get_rule_obj(char *);
+struct rule_obj *get_rule_obj_dentry(struct dentry *);
+obj_rule *get_rule_obj_list(struct rule_obj *);
+obj_rule *get_obj_rule_list(char *);
+void for_each_rule_obj(void (*)(struct rule_obj *, void *), void *);
+char **get_rule_obj_paths(unsigned int *);
+void clear_obj_rule_map(void);
+void reorder_obj_rule_map(u64 (*)(unsigned int));
+void replace_obj_rule_lists(obj_rule *(*)(struct rule_obj *, void *), void *);
+unsigned int prune_obj_rule_map(void);
+struct rule_range *get_rule_obj_range(struct rule_obj *);
+void drop_obj_rule_ranges(void);
+void clear_rule_list(obj_rule *);
+void print_obj_rule_list(obj_rule *);
+void print_obj_rule_map(void);
+void rule_obj_mem_stats(struct abac_mem_stats *);
+void show_rule_obj_shape(struct seq_file *);
+
+/* Access decisions of the rule engines, 1 if allowed */
+int check_avps(avp *, avp *);
+int resolve_rules(avp *, obj_rule *, enum operation);
+
+/* Shared with the adaptive and index engines */
+void *rules_lookup(char *);
+void *rules_lookup_dentry(struct dentry *);
+int rules_resolve_str(avp *, void *, enum operation);
+int rules_resolve_enc(avp *, void *, enum operation);
+void load_rule_objects(char *);
+void load_rule_policy(char *);
+void prune_rule_lists(void);
+void clear_rule_policy(void);
+void start_rule_reorder(void);
+void stop_rule_reorder(void);
+
+#endif /* _ABAC_RULES_H */
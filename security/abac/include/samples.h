@@ -0,0 +1,22 @@
+#ifndef _ABAC_SAMPLES_H
+#define _ABAC_SAMPLES_H
+
+#include <linux/dcache.h>
+#include <linux/types.h>
+#include "avp.h"
+
+/* Binary record of the securityfs samples<cpu> files, in native byte order */
+struct abac_sample {
+	u64 timestamp;	/* ktime_get_ns() at the start of the check */
+	u64 ns;		/* latency of the check */
+	u32 uid;
+	u16 cpu;
+	u8 op;		/* enum operation */
+	u8 allowed;
+};
+
+int start_samples(struct dentry *dir);
+void stop_samples(void);
+void record_sample(u64 timestamp, unsigned int uid, enum operation op, int allowed, u64 ns);
+
+#endif /* _ABAC_SAMPLES_H */
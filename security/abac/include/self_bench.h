@@ -0,0 +1,9 @@
+#ifndef _ABAC_SELF_BENCH_H
+#define _ABAC_SELF_BENCH_H
+
+#include <linux/seq_file.h>
+
+int run_self_bench(const char *arg);
+void show_self_bench(struct seq_file *m);
+
+#endif /* _ABAC_SELF_BENCH_H */
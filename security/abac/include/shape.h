@@ -0,0 +1,35 @@
+#ifndef _ABAC_SHAPE_H
+#define _ABAC_SHAPE_H
+
+#include <linux/bitops.h>
+#include <linux/seq_file.h>
+#include <linux/types.h>
+
+/*
+ * Distribution of a shape metric (hash chain length, rule list length, tree
+ * depth, ...) for the securityfs 'shape' file. Values below 16 get a slot
+ * each, larger values share a slot per power of two.
+ */
+#define SHAPE_LINEAR 16
+#define SHAPE_SLOTS (SHAPE_LINEAR + 64 - 4)
+
+struct shape_hist {
+	u64 slot[SHAPE_SLOTS];
+	u64 n;
+	u64 sum;
+	u64 max;
+};
+
+static inline void shape_add(struct shape_hist *h, u64 v)
+{
+	h->slot[v < SHAPE_LINEAR ? v : SHAPE_LINEAR + fls64(v) - 5]++;
+	h->n++;
+	h->sum += v;
+	if (v > h->max) {
+		h->max = v;
+	}
+}
+
+void show_shape_hist(struct seq_file *, const char *, const struct shape_hist *);
+
+#endif /* _ABAC_SHAPE_H */
@@ -0,0 +1,66 @@
+#ifndef _ABAC_TREES_H
+#define _ABAC_TREES_H
+
+#include <linux/seq_file.h>
+#include "avp.h"
+
+struct dentry;
+
+/*
+ * Object-specific PolTrees. Like attribute pairs, attributes and values are
+ * strings for the original datasets and integers for the encoded ones, and
+ * encoded nodes and branches are allocated without the strings.
+ */
+
+// struct representing a branch in a node
+struct branch {
+	struct node *child;
+	struct branch *next;
+	union {
+		int value_id;
+		char value[MAX_STR];
+	};
+};
+typedef struct branch branch;
+
+// struct representing a node in the tree
+// Branches are stored as linked lists
+// Leaves have an empty attribute (-1 when encoded) and hold the operation
+struct node {
+	enum operation op;
+	struct branch *head;
+	union {
+		int attr_id;
+		char attr[MAX_STR];
+	};
+};
+
+#define BRANCH_ENC_SIZE offsetofend(struct branch, value_id)
+#define NODE_ENC_SIZE offsetofend(struct node, attr_id)
+
+// struct representing the contents of a parsed node
+struct node_cont {
+	int nid;
+	int pid;
+	enum operation op;
+	int attr_id;
+	int value_id;
+	char attr[MAX_STR];
+	char value[MAX_STR];
+};
+typedef struct node_cont node_cont;
+
+void parse_obj_attr(char *);
+struct node *get_obj_tree(char *);
+struct node *get_obj_tree_dentry(struct dentry *);
+char **get_tree_obj_paths(unsigned int *);
+void clear_obj_attrs(void);
+void print_obj_attrs(void);
+void print_attr_tree(struct node *);
+void tree_obj_mem_stats(struct abac_mem_stats *);
+void show_tree_obj_shape(struct seq_file *);
+
+/* Access decisions of the tree engines, 0 if allowed */
+int resolve_tree(avp *, struct node *, enum operation);
+
+#endif /* _ABAC_TREES_H */
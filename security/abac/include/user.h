@@ -0,0 +1,18 @@
+#ifndef _ABAC_USER_H
+#define _ABAC_USER_H
+
+#include <linux/seq_file.h>
+#include "avp.h"
+
+void parse_user_attr(char *);
+avp *get_user_attrs(unsigned int);
+unsigned int *get_uids(unsigned int *);
+unsigned int get_avp_user_count(avp *);
+unsigned int get_user_count(void);
+unsigned int get_avg_user_attrs(void);
+void print_user_attrs(void);
+void clear_user_attrs(void);
+void user_mem_stats(struct abac_mem_stats *);
+void show_user_shape(struct seq_file *);
+
+#endif /* _ABAC_USER_H */
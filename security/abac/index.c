@@ -0,0 +1,477 @@
+#include <linux/err.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "abacfs.h"
+#include "engine.h"
+#include "rules.h"
+#include "shape.h"
+
+/*
+ * Index engines. Objects are loaded from obj_attrs with their attributes
+ * instead of their covering rule ids, and the policy rules carry the object
+ * attributes they apply to. Once both are loaded, the covering rules of every
+ * object are derived in the kernel, so obj_rules does not have to be
+ * regenerated offline when objects are added.
+ *
+ * A rule covers an object when it has every attribute of the object with the
+ * same value, as get_covering_rules() of generate_rule_abacfs.py decides.
+ * The policy load builds an inverted index from each object pair of the
+ * rules to the ids of the rules that have it. The covering rules of an
+ * object are then found by counting, for every pair of the object, a hit on
+ * each rule of its posting list: the rules hit by all the pairs cover it.
+ * Decisions use the derived lists like the rule engines.
+ *
+ * Files can also carry their object attributes in a security.abac xattr,
+ * see abac_lsm.c. Every distinct xattr value becomes a class: an entry like
+ * the ones of obj_attrs, keyed by the value instead of a path, whose covering
+ * rules are derived through the same index when it is first used. Inode
+ * security blobs point at the classes, so classes are never freed. Their
+ * attributes are parsed again and their lists derived again on every policy
+ * load, in the encoding of the loading engine.
+ */
+#define INDEX_BUCKETS 10
+#define CLASS_BUCKETS 8
+#define MAX_CLASSES 4096
+
+/* Rules whose object predicates have one pair, ids ascending */
+struct posting {
+	avp *pair;
+	unsigned int n;
+	unsigned int *ids;
+	/* Last rule counted while the index is built */
+	unsigned int last;
+	struct hlist_node node;
+};
+
+static DECLARE_HASHTABLE(obj_index, INDEX_BUCKETS);
+
+/* Classes of the xattr values, class_lock also keeps obj_index stable while
+ * a new class is derived */
+static DEFINE_HASHTABLE(xattr_classes, CLASS_BUCKETS);
+static DEFINE_MUTEX(class_lock);
+static unsigned int class_count;
+
+/* Scratch space of derive_list(), indexed by rule id */
+struct derive_ctx {
+	unsigned int size;
+	unsigned int *hits;
+	unsigned int *touched;
+	unsigned int objects;
+	unsigned int covering;
+};
+
+static struct posting *find_posting(avp *pair) {
+	struct posting *p;
+
+	hash_for_each_possible(obj_index, p, node, avp_hash(pair)) {
+		if (avp_equal(p->pair, pair)) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static void clear_index(void) {
+	struct posting *p;
+	struct hlist_node *tmp;
+	unsigned bkt;
+
+	hash_for_each_safe(obj_index, bkt, tmp, p, node) {
+		hash_del(&p->node);
+		kfree(p->ids);
+		kfree(p);
+	}
+}
+
+static int build_index(void) {
+	/* Count the rules of every pair, then fill the posting lists. A rule
+	 * listing a pair twice is posted once */
+	unsigned int size = get_policy_size(), i;
+	struct posting *p;
+	abac_rule *r;
+	unsigned bkt;
+	avp *a;
+
+	for (i = 0; i < size; i++) {
+		r = get_rule(i);
+		if (r == NULL) {
+			continue;
+		}
+		for (a = r->obj; a != NULL; a = a->next) {
+			p = find_posting(a);
+			if (p == NULL) {
+				p = kzalloc(sizeof(struct posting), GFP_KERNEL);
+				if (!p) {
+					return -ENOMEM;
+				}
+				p->pair = a;
+				hash_add(obj_index, &p->node, avp_hash(a));
+			}
+			if (p->n == 0 || p->last != i) {
+				p->n++;
+				p->last = i;
+			}
+		}
+	}
+	hash_for_each(obj_index, bkt, p, node) {
+		p->ids = kmalloc_array(p->n, sizeof(unsigned int), GFP_KERNEL);
+		if (!p->ids) {
+			return -ENOMEM;
+		}
+		p->n = 0;
+	}
+	for (i = 0; i < size; i++) {
+		r = get_rule(i);
+		if (r == NULL) {
+			continue;
+		}
+		for (a = r->obj; a != NULL; a = a->next) {
+			p = find_posting(a);
+			if (p->n == 0 || p->ids[p->n - 1] != i) {
+				p->ids[p->n++] = i;
+			}
+		}
+	}
+	return 0;
+}
+
+static obj_rule *prepend_rule(obj_rule *head, unsigned int id) {
+	obj_rule *r = kzalloc(sizeof(obj_rule), GFP_KERNEL);
+
+	if (!r) {
+		return head;
+	}
+	r->id = id;
+	r->next = head;
+	return r;
+}
+
+static obj_rule *derive_list(struct rule_obj *o, void *arg) {
+	/* Covering rules of @o, counted through the postings of its pairs */
+	struct derive_ctx *c = arg;
+	unsigned int k = 0, n = 0, i, id;
+	struct posting *p;
+	obj_rule *head = NULL;
+	avp *a;
+
+	for (a = o->attrs; a != NULL; a = a->next) {
+		k++;
+		p = find_posting(a);
+		if (p == NULL) {
+			continue;
+		}
+		for (i = 0; i < p->n; i++) {
+			id = p->ids[i];
+			if (c->hits[id]++ == 0) {
+				c->touched[n++] = id;
+			}
+		}
+	}
+	if (k == 0) {
+		/* An object without attributes is covered by every rule */
+		for (i = c->size; i > 0; i--) {
+			if (get_rule(i - 1) != NULL) {
+				head = prepend_rule(head, i - 1);
+				c->covering++;
+			}
+		}
+	}
+	for (i = 0; i < n; i++) {
+		id = c->touched[i];
+		if (c->hits[id] == k) {
+			head = prepend_rule(head, id);
+			c->covering++;
+		}
+		c->hits[id] = 0;
+	}
+	c->objects++;
+	return head;
+}
+
+static obj_rule *no_list(struct rule_obj *o, void *arg) {
+	return NULL;
+}
+
+static int init_derive_ctx(struct derive_ctx *c) {
+	c->size = get_policy_size();
+	if (c->size == 0) {
+		return -ENOENT;
+	}
+	c->hits = kcalloc(c->size, sizeof(unsigned int), GFP_KERNEL);
+	c->touched = kmalloc_array(c->size, sizeof(unsigned int), GFP_KERNEL);
+	if (!c->hits || !c->touched) {
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static void free_derive_ctx(struct derive_ctx *c) {
+	kfree(c->hits);
+	kfree(c->touched);
+}
+
+static void parse_class_attrs(struct rule_obj *o) {
+	/* Attributes of a class in the encoding of the active engine */
+	char *raw;
+
+	clear_avp_list(o->attrs);
+	o->attrs = NULL;
+	if (*o->path == '\0') {
+		return;
+	}
+	raw = kstrdup(o->path, GFP_KERNEL);
+	if (raw) {
+		o->attrs = parse_avp(raw);
+	}
+	kfree(raw);
+}
+
+static void replace_class_lists(int derive) {
+	/* Give every class the covering rules of the loaded policy, or none,
+	 * and free the previous lists and ranges once no decision uses them.
+	 * The ranges are built again from the new lists on the next access.
+	 * class_lock is dropped before waiting, lookup_xattr() takes it inside
+	 * decisions */
+	struct derive_ctx c = {};
+	struct rule_obj *o;
+	obj_rule **retired;
+	struct rule_range **retired_ranges;
+	unsigned int n_retired = 0, n_retired_ranges = 0, i;
+	unsigned bkt;
+
+	mutex_lock(&class_lock);
+	retired = kcalloc(class_count ? class_count : 1, sizeof(obj_rule *), GFP_KERNEL);
+	retired_ranges = kcalloc(class_count ? class_count : 1, sizeof(struct rule_range *),
+				 GFP_KERNEL);
+	if (!retired || !retired_ranges) {
+		kfree(retired);
+		kfree(retired_ranges);
+		mutex_unlock(&class_lock);
+		return;
+	}
+	if (derive && init_derive_ctx(&c)) {
+		derive = 0;
+	}
+	hash_for_each(xattr_classes, bkt, o, node) {
+		if (derive) {
+			parse_class_attrs(o);
+		}
+		retired[n_retired] = xchg(&o->head, derive ? derive_list(o, &c) : NULL);
+		if (retired[n_retired] != NULL) {
+			n_retired++;
+		}
+		retired_ranges[n_retired_ranges] = xchg(&o->range, NULL);
+		if (retired_ranges[n_retired_ranges] != NULL) {
+			n_retired_ranges++;
+		}
+	}
+	free_derive_ctx(&c);
+	mutex_unlock(&class_lock);
+	engine_synchronize();
+	for (i = 0; i < n_retired; i++) {
+		clear_rule_list(retired[i]);
+	}
+	for (i = 0; i < n_retired_ranges; i++) {
+		kfree(retired_ranges[i]);
+	}
+	kfree(retired);
+	kfree(retired_ranges);
+}
+
+static void derive_all(void) {
+	struct derive_ctx c = {};
+
+	if (init_derive_ctx(&c) == 0) {
+		replace_obj_rule_lists(derive_list, &c);
+		printk("Derived %u covering rules for %u objects", c.covering, c.objects);
+	}
+	free_derive_ctx(&c);
+	prune_rule_lists();
+}
+
+static int valid_xattr(const char *value) {
+	/* Check that @value is empty or a list of name=value pairs that fit in
+	 * an avp */
+	const char *pair = value, *eq, *end;
+
+	if (*value == '\0') {
+		return 1;
+	}
+	while (pair != NULL) {
+		end = strchrnul(pair, ',');
+		eq = memchr(pair, '=', end - pair);
+		if (eq == NULL || eq - pair >= MAX_STR || end - eq - 1 >= MAX_STR) {
+			return 0;
+		}
+		pair = *end ? end + 1 : NULL;
+	}
+	return 1;
+}
+
+static void *lookup_xattr(char *value) {
+	/* Class of the files whose xattr holds @value, created on first use.
+	 * ERR_PTR(-EINVAL) if @value is not a list of pairs or there are too
+	 * many classes, which does not change until the value does, and NULL
+	 * if memory runs out */
+	struct derive_ctx c = {};
+	struct rule_obj *o;
+	u32 key;
+
+	if (!valid_xattr(value)) {
+		return ERR_PTR(-EINVAL);
+	}
+	key = jhash(value, strlen(value), 0);
+	mutex_lock(&class_lock);
+	hash_for_each_possible(xattr_classes, o, node, key) {
+		if (strcmp(o->path, value) == 0) {
+			goto out;
+		}
+	}
+	o = NULL;
+	if (class_count == MAX_CLASSES) {
+		printk_ratelimited(KERN_ERR "ABAC LSM: More than %d object classes in xattrs",
+				   MAX_CLASSES);
+		o = ERR_PTR(-EINVAL);
+		goto out;
+	}
+	o = kzalloc(sizeof(struct rule_obj), GFP_KERNEL);
+	if (!o) {
+		goto out;
+	}
+	o->path = kstrdup(value, GFP_KERNEL);
+	if (!o->path) {
+		kfree(o);
+		o = NULL;
+		goto out;
+	}
+	parse_class_attrs(o);
+	if (init_derive_ctx(&c) == 0) {
+		o->head = derive_list(o, &c);
+	}
+	free_derive_ctx(&c);
+	hash_add(xattr_classes, &o->node, key);
+	class_count++;
+out:
+	mutex_unlock(&class_lock);
+	return o;
+}
+
+static void load_objects(char *data) {
+	parse_obj_attrs_map(data);
+	derive_all();
+}
+
+static void load_policy(char *data) {
+	int err;
+
+	load_rule_policy(data);
+	mutex_lock(&class_lock);
+	err = build_index();
+	if (err) {
+		clear_index();
+	}
+	mutex_unlock(&class_lock);
+	if (err) {
+		printk(KERN_ERR "ABAC LSM: Failed to index the object attributes of the policy");
+		return;
+	}
+	derive_all();
+	replace_class_lists(1);
+}
+
+static void clear_index_policy(void) {
+	/* The derived lists hold ids of the policy */
+	drop_obj_rule_ranges();
+	replace_obj_rule_lists(no_list, NULL);
+	replace_class_lists(0);
+	mutex_lock(&class_lock);
+	clear_index();
+	mutex_unlock(&class_lock);
+	clear_policy();
+}
+
+static void mem_stats(struct abac_mem_stats *s) {
+	struct posting *p;
+	struct rule_obj *o;
+	obj_rule *r;
+	unsigned bkt;
+
+	rule_obj_mem_stats(s);
+	policy_mem_stats(s);
+	hash_for_each(obj_index, bkt, p, node) {
+		mem_account(s, ABAC_MEM_INDEX, p);
+		mem_account(s, ABAC_MEM_INDEX, p->ids);
+	}
+	/* class_lock keeps replace_class_lists() from freeing the lists */
+	mutex_lock(&class_lock);
+	hash_for_each(xattr_classes, bkt, o, node) {
+		mem_account(s, ABAC_MEM_OBJECTS, o);
+		mem_account(s, ABAC_MEM_OBJECTS, o->path);
+		avp_list_mem_stats(o->attrs, s);
+		for (r = smp_load_acquire(&o->head); r != NULL; r = r->next) {
+			mem_account(s, ABAC_MEM_RULE_REFS, r);
+		}
+		mem_account(s, ABAC_MEM_RULE_REFS, smp_load_acquire(&o->range));
+	}
+	mutex_unlock(&class_lock);
+}
+
+static void show_shape(struct seq_file *m) {
+	/* Rules per object pair of the policy */
+	struct shape_hist *h;
+	struct posting *p;
+	unsigned bkt;
+
+	show_rule_obj_shape(m);
+	h = kzalloc(sizeof(struct shape_hist), GFP_KERNEL);
+	if (!h) {
+		return;
+	}
+	hash_for_each(obj_index, bkt, p, node) {
+		shape_add(h, p->n);
+	}
+	show_shape_hist(m, "index_postings", h);
+	kfree(h);
+}
+
+const struct abac_engine index_engine = {
+	.name = "index",
+	.encoded = 0,
+	.obj_file = "obj_attrs",
+	.load_objects = load_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_policy,
+	.clear_policy = clear_index_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = rules_lookup,
+	.lookup_dentry = rules_lookup_dentry,
+	.lookup_xattr = lookup_xattr,
+	.resolve = rules_resolve_str,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
+
+const struct abac_engine index_enc_engine = {
+	.name = "index_enc",
+	.encoded = 1,
+	.obj_file = "obj_attrs",
+	.load_objects = load_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_policy,
+	.clear_policy = clear_index_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = rules_lookup,
+	.lookup_dentry = rules_lookup_dentry,
+	.lookup_xattr = lookup_xattr,
+	.resolve = rules_resolve_enc,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
@@ -0,0 +1,61 @@
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/percpu.h>
+#include <linux/string.h>
+#include "latency_hist.h"
+
+/*
+ * Latency histograms of the file_permission hook.
+ * Every decision on a secured object adds its latency to a log2 histogram of
+ * the current CPU, split by decision and operation, so concurrent accesses
+ * neither share cache lines nor overwrite each other like perf_buf does. The
+ * per-CPU histograms are summed when the securityfs 'hist' file is read, one
+ * line per non-empty bucket:
+ * <ALLOW|DENY>:<op>:<bucket lower bound in ns>:<count>
+ * Writing HIST_RESET to the 'action' file clears them.
+ */
+struct latency_hist {
+	u64 buckets[2][ABAC_HIST_OPS][ABAC_HIST_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct latency_hist, latency_hist);
+
+static const char *const op_names[ABAC_HIST_OPS] = {
+	[ABAC_MODIFY] = "MODIFY",
+	[ABAC_READ] = "READ",
+	[ABAC_IGNORE] = "IGNORE",
+};
+
+void record_latency(int allowed, enum operation op, u64 ns) {
+	/* Called from the file_permission hook, fls64() maps ns to its bucket */
+	this_cpu_inc(latency_hist.buckets[!allowed][op][fls64(ns)]);
+}
+
+void show_latency_hist(struct seq_file *m) {
+	u64 count;
+	int cpu, deny, op, b;
+
+	for (deny = 0; deny < 2; deny++) {
+		for (op = 0; op < ABAC_HIST_OPS; op++) {
+			for (b = 0; b < ABAC_HIST_BUCKETS; b++) {
+				count = 0;
+				for_each_possible_cpu(cpu) {
+					count += READ_ONCE(per_cpu(latency_hist, cpu).buckets[deny][op][b]);
+				}
+				if (count) {
+					seq_printf(m, "%s:%s:%llu:%llu\n", deny ? "DENY" : "ALLOW",
+						   op_names[op], b ? 1ULL << (b - 1) : 0, count);
+				}
+			}
+		}
+	}
+}
+
+void reset_latency_hist(void) {
+	/* Decisions racing with the reset may be kept or lost */
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		memset(per_cpu_ptr(&latency_hist, cpu), 0, sizeof(struct latency_hist));
+	}
+}
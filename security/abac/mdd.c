@@ -0,0 +1,688 @@
+#include <linux/bitops.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "abacfs.h"
+#include "engine.h"
+#include "rules.h"
+#include "shape.h"
+
+/*
+ * Policy decision diagram engines. Once the objects and the policy are both
+ * loaded, the covering rules of every object are compiled into one reduced
+ * multi-valued decision diagram shared by all objects. Its variables are the
+ * user and env attributes of the policy, tested in a fixed order, the ones
+ * used by most rules first. A node follows the branch of the value the
+ * request has for its variable, or 'other' if no branch matches or the
+ * attribute is missing. Nodes are unique, so equal sub-diagrams reached from
+ * different objects or paths are stored once, and a node whose branches all
+ * lead to 'other' is left out. The object is the first variable: its table
+ * entry holds its root, and objects with the same covering rules share it.
+ *
+ * Like the adaptive trees, a node grants READ or MODIFY once a covering rule
+ * has all its predicates on the path, so the diagram decides like the rule
+ * list as long as users and env hold one value per attribute. Objects whose
+ * rules do not fit the limits below are decided with their rule list. The
+ * diagram points to the attribute pairs of the policy and is dropped before
+ * the objects or the policy are replaced.
+ */
+#define MDD_BUCKETS 12
+#define MDD_SET_BUCKETS 10
+#define MDD_MAX_PREDS 32	/* predicates per rule */
+#define MDD_MAX_NODES (1 << 16)	/* nodes in the whole diagram */
+#define MDD_MAX_STEPS 4096	/* build steps per object */
+
+/* Operation granted at a node, MODIFY includes READ */
+enum {
+	GRANT_NONE,
+	GRANT_READ,
+	GRANT_MODIFY,
+};
+
+struct mdd_var {
+	/* First pair of the policy with the attribute */
+	avp *name;
+	/* Look the attribute up in env_attr instead of the user attributes */
+	int env;
+	/* Predicates testing the attribute, sets the order */
+	unsigned int preds;
+};
+
+struct mdd_branch {
+	avp *value;
+	struct mdd_node *child;
+};
+
+struct mdd_node {
+	/* Variable tested by the node, NULL for a terminal */
+	struct mdd_var *var;
+	int grant;
+	struct mdd_node *other;
+	/* Objects that have the node as their root */
+	unsigned int roots;
+	u32 hash;
+	struct hlist_node hnode;
+	unsigned int nbranches;
+	struct mdd_branch branch[];
+};
+
+/* Rule being compiled, pred[] holds its user then its env predicates */
+struct mdd_rule {
+	int valid;
+	unsigned int npreds;
+	int grant;
+	avp *pred[MDD_MAX_PREDS];
+	unsigned int var[MDD_MAX_PREDS];
+};
+
+/* Covering rules shared by objects, only kept while compiling */
+struct mdd_set {
+	u32 hash;
+	unsigned int n;
+	unsigned int *ids;
+	struct mdd_node *root;
+	struct hlist_node hnode;
+};
+
+struct mdd_build {
+	/* Indexed by rule id */
+	struct mdd_rule *rules;
+	unsigned int steps;
+	int failed;
+	unsigned int objects;
+};
+
+/* Unique table of the nodes, also used to free them */
+static DECLARE_HASHTABLE(mdd_nodes, MDD_BUCKETS);
+static DECLARE_HASHTABLE(mdd_sets, MDD_SET_BUCKETS);
+static unsigned int node_count;
+static struct mdd_var *vars;
+static unsigned int nvars;
+/* Set once the roots of the objects are in place */
+static int compiled;
+
+static unsigned int find_var(avp *p, int env) {
+	unsigned int i;
+
+	for (i = 0; i < nvars; i++) {
+		if (vars[i].env == env && avp_same_name(vars[i].name, p)) {
+			break;
+		}
+	}
+	return i;
+}
+
+static void add_vars(avp *p, int env) {
+	unsigned int i;
+
+	for (; p != NULL; p = p->next) {
+		i = find_var(p, env);
+		if (i == nvars) {
+			vars[nvars].name = p;
+			vars[nvars].env = env;
+			nvars++;
+		}
+		vars[i].preds++;
+	}
+}
+
+static int load_vars(void) {
+	/* Collect the attributes of the policy, most tested first */
+	unsigned int size = get_policy_size(), max = 0, i, j;
+	struct mdd_var v;
+	abac_rule *r;
+
+	for (i = 0; i < size; i++) {
+		r = get_rule(i);
+		if (r != NULL) {
+			max += avp_list_len(r->user) + avp_list_len(r->env);
+		}
+	}
+	vars = kcalloc(max ? max : 1, sizeof(struct mdd_var), GFP_KERNEL);
+	if (!vars) {
+		return -ENOMEM;
+	}
+	nvars = 0;
+	for (i = 0; i < size; i++) {
+		r = get_rule(i);
+		if (r != NULL) {
+			add_vars(r->user, 0);
+			add_vars(r->env, 1);
+		}
+	}
+	for (i = 1; i < nvars; i++) {
+		v = vars[i];
+		for (j = i; j > 0 && vars[j - 1].preds < v.preds; j--) {
+			vars[j] = vars[j - 1];
+		}
+		vars[j] = v;
+	}
+	return 0;
+}
+
+static int load_rule(struct mdd_rule *d, abac_rule *r) {
+	/* Flatten the predicates of @r, fails if there are too many */
+	avp *a;
+	int env;
+
+	d->npreds = 0;
+	d->grant = r->op == ABAC_MODIFY ? GRANT_MODIFY : GRANT_READ;
+	for (env = 0; env < 2; env++) {
+		for (a = env ? r->env : r->user; a != NULL; a = a->next) {
+			if (d->npreds == MDD_MAX_PREDS) {
+				return -E2BIG;
+			}
+			d->var[d->npreds] = find_var(a, env);
+			d->pred[d->npreds++] = a;
+		}
+	}
+	return 0;
+}
+
+static u32 var_mask(struct mdd_rule *d, u32 left, unsigned int var) {
+	/* Predicates among @left that test @var */
+	u32 mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < d->npreds; i++) {
+		if ((left & (1U << i)) && d->var[i] == var) {
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+}
+
+static int all_equal(struct mdd_rule *d, u32 mask, avp *value) {
+	/* Every predicate in @mask has the value of @value */
+	unsigned int i;
+
+	for (i = 0; i < d->npreds; i++) {
+		if ((mask & (1U << i)) && !avp_equal(d->pred[i], value)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int node_equal(struct mdd_node *n, struct mdd_var *var, int grant, struct mdd_node *other,
+		      struct mdd_branch *br, unsigned int nb) {
+	/* Branches of a node have distinct values, so compare them as sets */
+	unsigned int i, j;
+
+	if (n->var != var || n->grant != grant || n->other != other || n->nbranches != nb) {
+		return 0;
+	}
+	for (i = 0; i < nb; i++) {
+		for (j = 0; j < nb; j++) {
+			if (n->branch[j].child == br[i].child && avp_equal(n->branch[j].value, br[i].value)) {
+				break;
+			}
+		}
+		if (j == nb) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static struct mdd_node *get_node(struct mdd_build *b, struct mdd_var *var, int grant,
+				 struct mdd_node *other, struct mdd_branch *br, unsigned int nb) {
+	/* Find the node in the unique table or add it */
+	struct mdd_node *n;
+	unsigned int i;
+	u32 hash;
+
+	hash = jhash_3words(var ? var - vars : ~0U, grant, (u32)(unsigned long)other, 0);
+	for (i = 0; i < nb; i++) {
+		hash += jhash_2words(avp_hash(br[i].value), (u32)(unsigned long)br[i].child, 0);
+	}
+	hash_for_each_possible(mdd_nodes, n, hnode, hash) {
+		if (n->hash == hash && node_equal(n, var, grant, other, br, nb)) {
+			return n;
+		}
+	}
+	if (node_count == MDD_MAX_NODES) {
+		b->failed = 1;
+		return NULL;
+	}
+	n = kzalloc(sizeof(struct mdd_node) + nb * sizeof(struct mdd_branch), GFP_KERNEL);
+	if (!n) {
+		b->failed = 1;
+		return NULL;
+	}
+	n->var = var;
+	n->grant = grant;
+	n->other = other;
+	n->hash = hash;
+	n->nbranches = nb;
+	if (nb) {
+		memcpy(n->branch, br, nb * sizeof(struct mdd_branch));
+	}
+	hash_add(mdd_nodes, &n->hnode, hash);
+	node_count++;
+	return n;
+}
+
+static struct mdd_node *build(struct mdd_build *b, unsigned int *idx, u32 *left, unsigned int n,
+			      int grant) {
+	/* Node reached by the rules idx[0..n), left[] holding the predicates of
+	 * each rule not tested on the path yet. idx and left are reused */
+	struct mdd_node *node = NULL, *other, *child;
+	struct mdd_branch *br = NULL;
+	struct mdd_rule *d;
+	unsigned int i, j, k, m, p, v, nb, *cidx = NULL;
+	u32 mask, *cleft = NULL;
+	avp *value;
+
+	if (++b->steps > MDD_MAX_STEPS) {
+		b->failed = 1;
+		return NULL;
+	}
+	// rules whose predicates were all tested are satisfied
+	for (i = 0; i < n; i++) {
+		d = &b->rules[idx[i]];
+		if (left[i] == 0 && d->grant > grant) {
+			grant = d->grant;
+		}
+	}
+	// keep the rules that could still grant more
+	m = 0;
+	for (i = 0; i < n; i++) {
+		if (left[i] == 0 || b->rules[idx[i]].grant <= grant) {
+			continue;
+		}
+		idx[m] = idx[i];
+		left[m] = left[i];
+		m++;
+	}
+	if (m == 0) {
+		return get_node(b, NULL, grant, NULL, NULL, 0);
+	}
+
+	// the first variable in the order that is still tested
+	v = nvars;
+	for (i = 0; i < m; i++) {
+		d = &b->rules[idx[i]];
+		for (p = 0; p < d->npreds; p++) {
+			if ((left[i] & (1U << p)) && d->var[p] < v) {
+				v = d->var[p];
+			}
+		}
+	}
+
+	cidx = kmalloc_array(m, sizeof(unsigned int), GFP_KERNEL);
+	cleft = kmalloc_array(m, sizeof(u32), GFP_KERNEL);
+	br = kmalloc_array(m, sizeof(struct mdd_branch), GFP_KERNEL);
+	if (!cidx || !cleft || !br) {
+		b->failed = 1;
+		goto out;
+	}
+	// rules that do not test the variable
+	k = 0;
+	for (j = 0; j < m; j++) {
+		if (!var_mask(&b->rules[idx[j]], left[j], v)) {
+			cidx[k] = idx[j];
+			cleft[k] = left[j];
+			k++;
+		}
+	}
+	other = build(b, cidx, cleft, k, grant);
+	if (!other) {
+		goto out;
+	}
+	// one branch per value, also holding the rules that do not test the variable
+	nb = 0;
+	for (i = 0; i < m; i++) {
+		mask = var_mask(&b->rules[idx[i]], left[i], v);
+		if (!mask) {
+			continue;
+		}
+		value = b->rules[idx[i]].pred[__ffs(mask)];
+		for (j = 0; j < i; j++) {
+			mask = var_mask(&b->rules[idx[j]], left[j], v);
+			if (mask && avp_equal(b->rules[idx[j]].pred[__ffs(mask)], value)) {
+				break;
+			}
+		}
+		if (j < i) {
+			/* value seen already */
+			continue;
+		}
+		k = 0;
+		for (j = 0; j < m; j++) {
+			d = &b->rules[idx[j]];
+			mask = var_mask(d, left[j], v);
+			if (mask && !all_equal(d, mask, value)) {
+				continue;
+			}
+			cidx[k] = idx[j];
+			cleft[k] = left[j] & ~mask;
+			k++;
+		}
+		child = build(b, cidx, cleft, k, grant);
+		if (!child) {
+			goto out;
+		}
+		if (child != other) {
+			br[nb].value = value;
+			br[nb].child = child;
+			nb++;
+		}
+	}
+	node = nb ? get_node(b, &vars[v], grant, other, br, nb) : other;
+out:
+	kfree(cidx);
+	kfree(cleft);
+	kfree(br);
+	return node;
+}
+
+static struct mdd_node *build_set(struct mdd_build *b, unsigned int *ids, unsigned int n) {
+	/* Root for the covering rules @ids, NULL if it does not fit the limits */
+	struct mdd_node *root;
+	unsigned int i;
+	u32 *left;
+
+	left = kmalloc_array(n ? n : 1, sizeof(u32), GFP_KERNEL);
+	if (!left) {
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		left[i] = (u32)((1ULL << b->rules[ids[i]].npreds) - 1);
+	}
+	b->steps = 0;
+	b->failed = 0;
+	/* build() compacts ids in place, the set keeps its own copy */
+	root = build(b, ids, left, n, GRANT_NONE);
+	kfree(left);
+	return b->failed ? NULL : root;
+}
+
+static void compile_obj(struct rule_obj *o, void *arg) {
+	/* Give @o the root of its covering rules, built once per distinct set */
+	struct mdd_build *b = arg;
+	struct mdd_set *set;
+	struct mdd_node *root;
+	obj_rule *r, *head;
+	unsigned int n, i, j, id, *ids, *work;
+	u32 hash;
+
+	head = get_rule_obj_list(o);
+	if (head == NULL) {
+		return;
+	}
+	n = 0;
+	for (r = head; r != NULL; r = r->next) {
+		n++;
+	}
+	ids = kmalloc_array(n, sizeof(unsigned int), GFP_KERNEL);
+	if (!ids) {
+		return;
+	}
+	// sorted ids of the rules in the policy, without duplicates
+	n = 0;
+	for (r = head; r != NULL; r = r->next) {
+		if (get_rule(r->id) == NULL) {
+			continue;
+		}
+		if (!b->rules[r->id].valid) {
+			/* too many predicates, keep the rule list */
+			kfree(ids);
+			return;
+		}
+		id = r->id;
+		for (j = n; j > 0 && ids[j - 1] > id; j--) {
+			ids[j] = ids[j - 1];
+		}
+		if (j > 0 && ids[j - 1] == id) {
+			memmove(&ids[j], &ids[j + 1], (n - j) * sizeof(unsigned int));
+			continue;
+		}
+		ids[j] = id;
+		n++;
+	}
+	hash = jhash(ids, n * sizeof(unsigned int), 0);
+	hash_for_each_possible(mdd_sets, set, hnode, hash) {
+		if (set->hash == hash && set->n == n && memcmp(set->ids, ids, n * sizeof(unsigned int)) == 0) {
+			kfree(ids);
+			root = set->root;
+			goto found;
+		}
+	}
+	root = NULL;
+	work = kmalloc_array(n ? n : 1, sizeof(unsigned int), GFP_KERNEL);
+	if (work) {
+		for (i = 0; i < n; i++) {
+			work[i] = ids[i];
+		}
+		root = build_set(b, work, n);
+		kfree(work);
+	}
+	set = kzalloc(sizeof(struct mdd_set), GFP_KERNEL);
+	if (!set) {
+		kfree(ids);
+		goto found;
+	}
+	set->hash = hash;
+	set->n = n;
+	set->ids = ids;
+	set->root = root;
+	hash_add(mdd_sets, &set->hnode, hash);
+found:
+	if (root != NULL) {
+		root->roots++;
+		WRITE_ONCE(o->mdd, root);
+		b->objects++;
+	}
+}
+
+static void compile_diagram(void) {
+	struct mdd_build b = {};
+	struct mdd_set *set;
+	struct hlist_node *tmp;
+	unsigned int size = get_policy_size(), i;
+	unsigned bkt;
+	abac_rule *r;
+
+	if (size == 0 || load_vars()) {
+		return;
+	}
+	b.rules = kvmalloc_array(size, sizeof(struct mdd_rule), GFP_KERNEL);
+	if (!b.rules) {
+		return;
+	}
+	for (i = 0; i < size; i++) {
+		r = get_rule(i);
+		b.rules[i].valid = r != NULL && load_rule(&b.rules[i], r) == 0;
+	}
+	hash_init(mdd_sets);
+	for_each_rule_obj(compile_obj, &b);
+	hash_for_each_safe(mdd_sets, bkt, tmp, set, hnode) {
+		hash_del(&set->hnode);
+		kfree(set->ids);
+		kfree(set);
+	}
+	kvfree(b.rules);
+	printk("Compiled %u objects into %u diagram nodes over %u attributes", b.objects, node_count,
+	       nvars);
+	smp_store_release(&compiled, 1);
+}
+
+static void reset_root(struct rule_obj *o, void *arg) {
+	o->mdd = NULL;
+}
+
+static void drop_diagram(void) {
+	/* Stop using the diagram, wait for the decisions that still do and free it */
+	struct mdd_node *n;
+	struct hlist_node *tmp;
+	unsigned bkt;
+
+	WRITE_ONCE(compiled, 0);
+	engine_synchronize();
+	for_each_rule_obj(reset_root, NULL);
+	hash_for_each_safe(mdd_nodes, bkt, tmp, n, hnode) {
+		hash_del(&n->hnode);
+		kfree(n);
+	}
+	node_count = 0;
+	kfree(vars);
+	vars = NULL;
+	nvars = 0;
+}
+
+static __always_inline int __resolve_mdd(avp *user_attr, struct mdd_node *n, enum operation op,
+					 const int encoded) {
+	/* 1 if the path of the request reaches a node granting @op */
+	int need = op == ABAC_MODIFY ? GRANT_MODIFY : GRANT_READ;
+	struct mdd_node *next;
+	unsigned int i;
+	avp *a;
+
+	while (n->grant < need) {
+		if (n->var == NULL) {
+			return 0;
+		}
+		a = n->var->env ? env_attr : user_attr;
+		while (a != NULL && !avp_name_match(a, n->var->name, encoded)) {
+			a = a->next;
+		}
+		next = n->other;
+		if (a != NULL) {
+			for (i = 0; i < n->nbranches; i++) {
+				if (avp_value_match(a, n->branch[i].value, encoded)) {
+					next = n->branch[i].child;
+					break;
+				}
+			}
+		}
+		n = next;
+	}
+	return 1;
+}
+
+static __always_inline int __resolve(avp *user_attr, void *obj, enum operation op,
+				     const int encoded) {
+	struct rule_obj *o = obj;
+	struct mdd_node *root;
+
+	if (o != NULL && smp_load_acquire(&compiled) && (root = READ_ONCE(o->mdd)) != NULL) {
+		/* Same checks as resolve_rules() before the rules */
+		if (user_attr == NULL) {
+			return 0;
+		}
+		if (op == ABAC_IGNORE) {
+			return 1;
+		}
+		return __resolve_mdd(user_attr, root, op, encoded);
+	}
+	return resolve_rules(user_attr, o ? get_rule_obj_list(o) : NULL, op);
+}
+
+static int resolve_str(avp *user_attr, void *obj, enum operation op) {
+	return __resolve(user_attr, obj, op, 0);
+}
+
+static int resolve_enc(avp *user_attr, void *obj, enum operation op) {
+	return __resolve(user_attr, obj, op, 1);
+}
+
+static void *lookup(char *path) {
+	return get_rule_obj(path);
+}
+
+static void *lookup_dentry(struct dentry *dentry) {
+	return get_rule_obj_dentry(dentry);
+}
+
+static void load_objects(char *data) {
+	drop_diagram();
+	load_rule_objects(data);
+	compile_diagram();
+}
+
+static void clear_objects(void) {
+	drop_diagram();
+	clear_obj_rule_map();
+}
+
+static void load_policy(char *data) {
+	drop_diagram();
+	load_rule_policy(data);
+	compile_diagram();
+}
+
+static void clear_mdd_policy(void) {
+	drop_diagram();
+	clear_policy();
+}
+
+static void mem_stats(struct abac_mem_stats *s) {
+	struct mdd_node *n;
+	unsigned bkt;
+
+	rule_obj_mem_stats(s);
+	policy_mem_stats(s);
+	mem_account(s, ABAC_MEM_DIAGRAM, vars);
+	hash_for_each(mdd_nodes, bkt, n, hnode) {
+		mem_account(s, ABAC_MEM_DIAGRAM, n);
+	}
+}
+
+static void show_shape(struct seq_file *m) {
+	/* Branch count of the inner nodes, and objects sharing each root */
+	struct shape_hist *h;
+	struct mdd_node *n;
+	unsigned bkt;
+
+	show_rule_obj_shape(m);
+	h = kcalloc(2, sizeof(struct shape_hist), GFP_KERNEL);
+	if (!h) {
+		return;
+	}
+	hash_for_each(mdd_nodes, bkt, n, hnode) {
+		if (n->var != NULL) {
+			shape_add(&h[0], n->nbranches);
+		}
+		if (n->roots) {
+			shape_add(&h[1], n->roots);
+		}
+	}
+	show_shape_hist(m, "mdd_fanout", &h[0]);
+	show_shape_hist(m, "mdd_root_objects", &h[1]);
+	kfree(h);
+}
+
+const struct abac_engine mdd_engine = {
+	.name = "mdd",
+	.encoded = 0,
+	.obj_file = "obj_rules",
+	.load_objects = load_objects,
+	.clear_objects = clear_objects,
+	.load_policy = load_policy,
+	.clear_policy = clear_mdd_policy,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_str,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
+
+const struct abac_engine mdd_enc_engine = {
+	.name = "mdd_enc",
+	.encoded = 1,
+	.obj_file = "obj_rules",
+	.load_objects = load_objects,
+	.clear_objects = clear_objects,
+	.load_policy = load_policy,
+	.clear_policy = clear_mdd_policy,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_enc,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_shape,
+};
@@ -0,0 +1,243 @@
+#include <linux/dcache.h>
+#include <linux/hash.h>
+#include <linux/jhash.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/rcupdate.h>
+#include <linux/seqlock.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "path_trie.h"
+
+/*
+ * Path component trie of the object tables. Paths are split on '/' and each
+ * component is stored once in the node of its prefix, so objects sharing
+ * directories share their nodes. Instead of a child array per node, all the
+ * edges of a trie live in one hash table keyed by the parent node and the
+ * component, which keeps wide directories at one bucket lookup per level.
+ * The table has about one bucket per object of the file it indexes, so
+ * chains stay short from a few objects to millions.
+ *
+ * Lookups walk one component at a time: from a path string, from the root to
+ * the longest prefix that holds an object, or from a dentry chain, which
+ * avoids building the path. Tries are built while loading the object files
+ * and cleared with them, like the hash tables they replace.
+ */
+
+static u32 edge_hash(const struct path_trie_node *parent, const char *name, unsigned int len) {
+	return jhash(name, len, (u32)(unsigned long)parent);
+}
+
+static struct hlist_head *edge_bucket(struct path_trie *t, const struct path_trie_node *parent,
+				     const char *name, unsigned int len) {
+	return &t->edges[hash_32(edge_hash(parent, name, len), t->bits)];
+}
+
+static struct path_trie_node *find_child(struct path_trie *t, struct path_trie_node *parent,
+					 const char *name, unsigned int len) {
+	struct path_trie_node *n;
+
+	if (t->edges == NULL) {
+		return NULL;
+	}
+	hlist_for_each_entry(n, edge_bucket(t, parent, name, len), edge) {
+		if (n->parent == parent && n->len == len && memcmp(n->name, name, len) == 0) {
+			return n;
+		}
+	}
+	return NULL;
+}
+
+static const char *next_component(const char *path, unsigned int *len) {
+	/* Skip the slashes before the next component and measure it, NULL at the end */
+	while (*path == '/') {
+		path++;
+	}
+	if (*path == '\0') {
+		return NULL;
+	}
+	*len = strchrnul(path, '/') - path;
+	return path;
+}
+
+int path_trie_init(struct path_trie *t, unsigned int objects) {
+	/* Empty trie with a bucket per expected object, -ENOMEM if the table
+	 * cannot be allocated */
+	unsigned int bits = PATH_TRIE_MIN_BITS;
+
+	while (bits < PATH_TRIE_MAX_BITS && (1U << bits) < objects) {
+		bits++;
+	}
+	memset(&t->root, 0, sizeof(t->root));
+	t->nodes = 0;
+	t->bits = bits;
+	t->edges = kvcalloc(1U << bits, sizeof(struct hlist_head), GFP_KERNEL);
+	return t->edges ? 0 : -ENOMEM;
+}
+
+struct path_trie_node *path_trie_insert(struct path_trie *t, const char *path) {
+	/* Node of @path, created with its missing ancestors. NULL if out of
+	 * memory or if @path is too deep for path_trie_lookup_dentry() */
+	struct path_trie_node *n = &t->root, *child;
+	const char *c = path;
+	unsigned int len, depth = 0;
+
+	if (t->edges == NULL) {
+		return NULL;
+	}
+	while ((c = next_component(c, &len)) != NULL) {
+		if (++depth > PATH_TRIE_MAX_DEPTH) {
+			printk(KERN_ERR "ABAC LSM: %s has more than %d components", path,
+			       PATH_TRIE_MAX_DEPTH);
+			return NULL;
+		}
+		child = find_child(t, n, c, len);
+		if (child == NULL) {
+			child = kzalloc(sizeof(struct path_trie_node) + len, GFP_KERNEL);
+			if (!child) {
+				return NULL;
+			}
+			child->parent = n;
+			child->len = len;
+			memcpy(child->name, c, len);
+			hlist_add_head(&child->edge, edge_bucket(t, n, c, len));
+			t->nodes++;
+		}
+		n = child;
+		c += len;
+	}
+	return n;
+}
+
+void *path_trie_lookup(struct path_trie *t, const char *path) {
+	/* Object of @path, NULL if there is none */
+	struct path_trie_node *n = &t->root;
+	const char *c = path;
+	unsigned int len;
+
+	while ((c = next_component(c, &len)) != NULL) {
+		n = find_child(t, n, c, len);
+		if (n == NULL) {
+			return NULL;
+		}
+		c += len;
+	}
+	return n->obj;
+}
+
+void *path_trie_lookup_prefix(struct path_trie *t, const char *path) {
+	/* Object of the longest prefix of @path that has one, @path included */
+	struct path_trie_node *n = &t->root;
+	const char *c = path;
+	unsigned int len;
+	void *obj = n->obj;
+
+	while ((c = next_component(c, &len)) != NULL) {
+		n = find_child(t, n, c, len);
+		if (n == NULL) {
+			break;
+		}
+		if (n->obj != NULL) {
+			obj = n->obj;
+		}
+		c += len;
+	}
+	return obj;
+}
+
+static void *walk_dentry(struct path_trie *t, struct dentry *dentry, int prefix) {
+	struct dentry *chain[PATH_TRIE_MAX_DEPTH];
+	struct path_trie_node *n = &t->root;
+	unsigned int depth = 0, top, len;
+	const char *name;
+	struct dentry *d;
+	void *obj = prefix ? n->obj : NULL;
+
+	/* No object is deeper than PATH_TRIE_MAX_DEPTH, see path_trie_insert(),
+	 * so only the ancestors nearest the root are kept. They are the last
+	 * ones written to the ring */
+	for (d = dentry; !IS_ROOT(d); d = READ_ONCE(d->d_parent)) {
+		chain[depth++ % PATH_TRIE_MAX_DEPTH] = d;
+	}
+	top = min_t(unsigned int, depth, PATH_TRIE_MAX_DEPTH);
+	while (top-- > 0) {
+		d = chain[--depth % PATH_TRIE_MAX_DEPTH];
+		/* A concurrent rename may pair a name with the length of the
+		 * other one, the names are NUL terminated and the caller retries */
+		name = smp_load_acquire(&d->d_name.name);
+		len = strnlen(name, READ_ONCE(d->d_name.len));
+		n = find_child(t, n, name, len);
+		if (n == NULL) {
+			return obj;
+		}
+		if (prefix && n->obj != NULL) {
+			obj = n->obj;
+		}
+	}
+	/* Components left below the kept ones have no node */
+	return prefix ? obj : (depth ? NULL : n->obj);
+}
+
+void *path_trie_lookup_dentry(struct path_trie *t, struct dentry *dentry, int prefix) {
+	/* Same as path_trie_lookup(), or path_trie_lookup_prefix() if @prefix,
+	 * for the path dentry_path_raw() would build for @dentry */
+	unsigned int seq;
+	void *obj;
+
+	rcu_read_lock();
+	do {
+		seq = read_seqbegin(&rename_lock);
+		obj = walk_dentry(t, dentry, prefix);
+	} while (read_seqretry(&rename_lock, seq));
+	rcu_read_unlock();
+	return obj;
+}
+
+void path_trie_clear(struct path_trie *t) {
+	/* Free the nodes, the objects belong to the table using the trie */
+	struct path_trie_node *n;
+	struct hlist_node *tmp;
+	unsigned int bkt;
+
+	for (bkt = 0; t->edges != NULL && bkt < (1U << t->bits); bkt++) {
+		hlist_for_each_entry_safe(n, tmp, &t->edges[bkt], edge) {
+			kfree(n);
+		}
+	}
+	kvfree(t->edges);
+	t->edges = NULL;
+	t->bits = 0;
+	t->root.obj = NULL;
+	t->nodes = 0;
+}
+
+void path_trie_mem_stats(struct path_trie *t, struct abac_mem_stats *s) {
+	struct path_trie_node *n;
+	unsigned int bkt;
+
+	if (t->edges == NULL) {
+		return;
+	}
+	/* The bucket array may be vmalloc'd, which ksize() does not handle */
+	s->count[ABAC_MEM_TRIE]++;
+	s->bytes[ABAC_MEM_TRIE] += sizeof(struct hlist_head) << t->bits;
+	for (bkt = 0; bkt < (1U << t->bits); bkt++) {
+		hlist_for_each_entry(n, &t->edges[bkt], edge) {
+			mem_account(s, ABAC_MEM_TRIE, n);
+		}
+	}
+}
+
+void path_trie_chains(struct path_trie *t, struct shape_hist *h) {
+	/* Chain length of every bucket of the edge table */
+	struct path_trie_node *n;
+	unsigned int bkt, len;
+
+	for (bkt = 0; t->edges != NULL && bkt < (1U << t->bits); bkt++) {
+		len = 0;
+		hlist_for_each_entry(n, &t->edges[bkt], edge) {
+			len++;
+		}
+		shape_add(h, len);
+	}
+}
@@ -0,0 +1,528 @@
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/smp.h>
+#include <linux/cache.h>
+#include "policy.h"
+#include "user.h"
+
+/* Array of rules and its size*/
+static struct abac_rule **policy = NULL;
+static unsigned int count;
+
+struct rule_store *rule_store = NULL;
+
+/*
+ * Rule profile used to reorder covering rule lists.
+ * rule_hits counts how often each rule granted access, one row of
+ * rule_hits_stride counters per CPU id. Rows are padded to a cache line so
+ * the access hook never shares a line with other CPUs. The rows are
+ * kvcalloc'd rather than taken from the per-CPU allocator, which refuses
+ * areas above PCPU_MIN_UNIT_SIZE (4096 rules). rule_score is a decaying
+ * sum of the hits seen between two calls of update_rule_scores(),
+ * rule_last holds the totals seen by the previous call.
+ */
+static u64 *rule_hits = NULL;
+static unsigned int rule_hits_stride;
+/* Set while BENCH runs, its synthetic requests are not a workload */
+static int rule_hits_paused;
+
+/*
+ * Dominance relation of the policy, bit a * count + b is set when rule a
+ * dominates rule b, see rule_dominates(). Computed once per policy load so
+ * pruning a covering rule list only tests bits. Larger policies have no
+ * bitmap and compare the rules on every test.
+ */
+#define DOMINANCE_MAX_RULES 4096
+
+static u64 *dominance = NULL;
+static u64 *rule_score = NULL;
+static u64 *rule_last = NULL;
+
+static struct abac_rule *parse_line(char *line) {
+	/* Parse a single line in the file */
+	struct abac_rule *r;
+	char *id_str;
+	char *section;
+
+	r = kcalloc(1, sizeof(struct abac_rule), GFP_KERNEL);
+	if (!r) {
+		return NULL;
+	}
+	r->op = ABAC_IGNORE;
+	id_str = strsep(&line, ":");
+	kstrtoint(id_str, 10, &(r->id));
+	// User attributes
+	section = strsep(&line, "|");
+	r->user = parse_avp(section);
+	// Environmental attributes
+	section = strsep(&line, "|");
+	r->env = parse_avp(section);
+	// Operation
+	section = strsep(&line, "|");
+	if (strcmp(section, "MODIFY") == 0) {
+		r->op = ABAC_MODIFY;
+	} else if (strcmp(section, "READ") == 0){
+		r->op = ABAC_READ;
+	}
+	// Optional object attributes
+	if (line != NULL && *line != '\0') {
+		r->obj = parse_avp(line);
+	}
+	return r;
+}
+
+abac_rule *get_rule(unsigned int id) {
+	/* Get rule to a ID */
+	if (policy == NULL || id >= count) {
+		return NULL;
+	}
+	return policy[id];
+}
+
+unsigned int get_policy_size(void) {
+	/* Rule ids of the loaded policy are below this */
+	return policy ? count : 0;
+}
+
+void record_rule_hit(unsigned int id) {
+	/* Count a rule that granted access on the current CPU */
+	int cpu;
+
+	if (rule_hits == NULL || id >= count || READ_ONCE(rule_hits_paused)) {
+		return;
+	}
+	cpu = get_cpu();
+	rule_hits[(size_t)cpu * rule_hits_stride + id]++;
+	put_cpu();
+}
+
+static int rule_grants(const abac_rule *r, enum operation op) {
+	/* MODIFY rules also allow reads */
+	return r->op == op || (op == ABAC_READ && r->op == ABAC_MODIFY);
+}
+
+static int avps_subset(avp *a, avp *b) {
+	/* Check if every pair of @a is also in @b */
+	for (; a != NULL; a = a->next) {
+		if (!avp_list_contains(b, a)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int compare_rules(const abac_rule *a, const abac_rule *b) {
+	/* Rule a dominates rule b when it allows every request b allows: it
+	 * allows the operations of b and its user and env predicates are a
+	 * subset of those of b. A list holding both never needs b, since a
+	 * holds whenever b does, whatever the current environment */
+	if (rule_grants(b, ABAC_READ) && !rule_grants(a, ABAC_READ)) {
+		return 0;
+	}
+	if (rule_grants(b, ABAC_MODIFY) && !rule_grants(a, ABAC_MODIFY)) {
+		return 0;
+	}
+	return avps_subset(a->user, b->user) && avps_subset(a->env, b->env);
+}
+
+static u64 *build_dominance(struct abac_rule **rules, unsigned int n) {
+	/* Bitmap of the relation, NULL if the policy is too large for one */
+	unsigned int a, b;
+	size_t bit;
+	u64 *bits;
+
+	if (n == 0 || n > DOMINANCE_MAX_RULES) {
+		return NULL;
+	}
+	bits = kvcalloc(DIV_ROUND_UP((size_t)n * n, 64), sizeof(u64), GFP_KERNEL);
+	if (!bits) {
+		return NULL;
+	}
+	for (a = 0; a < n; a++) {
+		if (rules[a] == NULL) {
+			continue;
+		}
+		for (b = 0; b < n; b++) {
+			if (a != b && rules[b] != NULL && compare_rules(rules[a], rules[b])) {
+				bit = (size_t)a * n + b;
+				bits[bit / 64] |= 1ULL << (bit % 64);
+			}
+		}
+	}
+	return bits;
+}
+
+int rule_dominates(unsigned int a, unsigned int b) {
+	/* 1 if rule a allows every request rule b allows. Rules missing from
+	 * the policy dominate nothing and are dominated by nothing */
+	size_t bit;
+
+	if (policy == NULL || a >= count || b >= count || policy[a] == NULL ||
+	    policy[b] == NULL) {
+		return 0;
+	}
+	if (dominance == NULL) {
+		return compare_rules(policy[a], policy[b]);
+	}
+	bit = (size_t)a * count + b;
+	return (dominance[bit / 64] >> (bit % 64)) & 1;
+}
+
+void pause_rule_hits(int pause) {
+	/* Stop or restart counting rule hits */
+	WRITE_ONCE(rule_hits_paused, pause);
+}
+
+void update_rule_scores(void) {
+	/* Fold the hits seen since the last call into the rule scores.
+	 * Older hits are halved on every call so the ranking follows shifts
+	 * in the workload */
+	unsigned int i;
+	int cpu;
+	u64 total;
+
+	if (rule_hits == NULL || rule_score == NULL || rule_last == NULL) {
+		return;
+	}
+	for (i = 0; i < count; i++) {
+		total = 0;
+		for_each_possible_cpu(cpu) {
+			total += rule_hits[(size_t)cpu * rule_hits_stride + i];
+		}
+		rule_score[i] = rule_score[i] / 2 + (total - rule_last[i]);
+		rule_last[i] = total;
+	}
+}
+
+u64 get_rule_score(unsigned int id) {
+	/* Get the score computed by the last update_rule_scores() */
+	if (rule_score == NULL || id >= count) {
+		return 0;
+	}
+	return rule_score[id];
+}
+
+#define MAX_PREDS 32
+
+/* Environment used while ranking env predicates in compile_policy() */
+static avp *compile_env = NULL;
+
+static unsigned int user_pred_rank(avp *p) {
+	/* Predicates held by fewer users are more likely to fail */
+	return get_avp_user_count(p);
+}
+
+static unsigned int env_pred_rank(avp *p) {
+	/* Predicates that do not hold in the current environment fail first */
+	return avp_list_contains(compile_env, p);
+}
+
+static avp *order_preds(avp *head, unsigned int (*rank)(avp *)) {
+	/* Relink a predicate list by ascending rank. Equal ranks keep their order */
+	avp *preds[MAX_PREDS];
+	unsigned int ranks[MAX_PREDS];
+	unsigned int n, i, j, rk;
+	avp *p;
+
+	n = 0;
+	for (p = head; p != NULL; p = p->next) {
+		if (n == MAX_PREDS) {
+			return head;
+		}
+		preds[n] = p;
+		ranks[n] = rank(p);
+		n++;
+	}
+	for (i = 1; i < n; i++) {
+		p = preds[i];
+		rk = ranks[i];
+		for (j = i; j > 0 && ranks[j - 1] > rk; j--) {
+			preds[j] = preds[j - 1];
+			ranks[j] = ranks[j - 1];
+		}
+		preds[j] = p;
+		ranks[j] = rk;
+	}
+	for (i = 0; i < n; i++) {
+		preds[i]->next = (i + 1 < n) ? preds[i + 1] : NULL;
+	}
+	return n ? preds[0] : NULL;
+}
+
+static void free_rule(struct abac_rule *r) {
+	clear_avp_list(r->user);
+	clear_avp_list(r->env);
+	clear_avp_list(r->obj);
+	kfree(r);
+}
+
+static void free_rules(struct abac_rule **rules, unsigned int n) {
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		if (rules[i] != NULL) {
+			free_rule(rules[i]);
+		}
+	}
+	kfree(rules);
+}
+
+static void free_rule_store(struct rule_store *st) {
+	if (st == NULL) {
+		return;
+	}
+	kfree(st->slot);
+	kfree(st->id);
+	kfree(st->op);
+	kfree(st->env_first);
+	kfree(st->pred_start);
+	kfree(st->env_start);
+	kfree(st->preds);
+	kfree(st);
+}
+
+static void store_preds(struct rule_pred *p, avp *a) {
+	for (; a != NULL; a = a->next, p++) {
+		p->name_id = a->name_id;
+		p->value_id = a->value_id;
+		p->pair = a;
+	}
+}
+
+static struct rule_store *build_rule_store(struct abac_rule **rules, unsigned int n) {
+	/* Copy the compiled rules into the arrays of a rule_store */
+	struct rule_store *st;
+	struct abac_rule *r;
+	unsigned int i, s, n_preds, p;
+
+	st = kzalloc(sizeof(struct rule_store), GFP_KERNEL);
+	if (!st) {
+		return NULL;
+	}
+	n_preds = 0;
+	for (i = 0; i < n; i++) {
+		r = rules[i];
+		if (r != NULL) {
+			st->n++;
+			n_preds += avp_list_len(r->user) + avp_list_len(r->env);
+		}
+	}
+	st->slot = kmalloc_array(n, sizeof(unsigned int), GFP_KERNEL);
+	st->id = kmalloc_array(st->n, sizeof(unsigned int), GFP_KERNEL);
+	st->op = kmalloc_array(st->n, sizeof(u8), GFP_KERNEL);
+	st->env_first = kmalloc_array(st->n, sizeof(u8), GFP_KERNEL);
+	st->pred_start = kmalloc_array(st->n + 1, sizeof(unsigned int), GFP_KERNEL);
+	st->env_start = kmalloc_array(st->n, sizeof(unsigned int), GFP_KERNEL);
+	st->preds = kmalloc_array(n_preds, sizeof(struct rule_pred), GFP_KERNEL);
+	if ((n && !st->slot) || (st->n && (!st->id || !st->op || !st->env_first ||
+	    !st->env_start)) || !st->pred_start || (n_preds && !st->preds)) {
+		free_rule_store(st);
+		return NULL;
+	}
+	s = 0;
+	p = 0;
+	for (i = 0; i < n; i++) {
+		r = rules[i];
+		if (r == NULL) {
+			st->slot[i] = RULE_NO_SLOT;
+			continue;
+		}
+		st->slot[i] = s;
+		st->id[s] = i;
+		st->op[s] = r->op;
+		st->env_first[s] = r->env_first;
+		st->pred_start[s] = p;
+		store_preds(st->preds + p, r->user);
+		p += avp_list_len(r->user);
+		st->env_start[s] = p;
+		store_preds(st->preds + p, r->env);
+		p += avp_list_len(r->env);
+		s++;
+	}
+	st->pred_start[s] = p;
+	return st;
+}
+
+static void compile_policy(struct abac_rule **rules, unsigned int n, avp *env) {
+	/*
+	 * Order the predicates of every rule so that rejects are cheap.
+	 * User predicates are sorted by the number of loaded users that hold
+	 * them, rarest first. Env predicates that fail in @env come first.
+	 * The env list is tested before the user list when it is expected to
+	 * be cheaper: it already fails, or it needs fewer comparisons than
+	 * the user list of an average user.
+	 * Ranking uses the user and env tables loaded at this point, so the
+	 * policy should be written after them. @rules is not published yet.
+	 */
+	struct abac_rule *r;
+	unsigned int i, env_len, avg_user, env_cost, user_cost, compiled;
+
+	compile_env = env;
+	env_len = avp_list_len(env);
+	avg_user = get_avg_user_attrs();
+	compiled = 0;
+	for (i = 0; i < n; i++) {
+		r = rules[i];
+		if (r == NULL) {
+			continue;
+		}
+		r->user = order_preds(r->user, user_pred_rank);
+		r->env = order_preds(r->env, env_pred_rank);
+		env_cost = avp_list_len(r->env) * env_len;
+		user_cost = avp_list_len(r->user) * avg_user;
+		/* Failing env predicates are sorted first, so testing the head
+		 * of the list tells whether the env part fails */
+		r->env_first = (r->env != NULL && !avp_list_contains(env, r->env)) || env_cost <= user_cost;
+		compiled++;
+	}
+	compile_env = NULL;
+	printk("Compiled %u rules using %u users", compiled, get_user_count());
+}
+
+void parse_policy(char *data, avp *env) {
+	/*
+	 * Parses ABAC policy written to 'policy' file in securityfs
+	 * Rules are parsed and stored in an array
+	 * File Format:
+	 * <rule_count>
+	 * <rule_id>:u_attr1=u_val1,u_attr2=u_val2|e_attr=e_val|op=MODIFY
+	 * <rule_id>:u_attr2=u_val2|e_attr=e_val|op=READ|o_attr=o_val
+	 * ...
+	 * The object attributes are optional
+	 * The rules are compiled for @env before the array is published, so
+	 * decisions never see predicate lists that are being relinked.
+	 * If memory runs out the rules parsed so far are freed and no
+	 * policy is loaded, so every request is denied.
+	 */
+	struct abac_rule **rules;
+	struct abac_rule *r;
+	char *line, *count_str;
+	unsigned int n = 0;
+
+	count_str = strsep(&data, "\n");
+	kstrtouint(count_str, 10, &n);
+	//policy = kmalloc(sizeof(struct abac_rule *), GFP_KERNEL);
+	rules = kcalloc(n, sizeof(struct abac_rule *), GFP_KERNEL);
+	if (!rules) {
+		printk(KERN_ERR "ABAC LSM: Out of memory for the %u rules of the policy", n);
+		return;
+	}
+	printk("Policy has %d rules", n);
+
+	while((line = strsep(&data, "\n")) != NULL) {
+		/* Ignore empty lines */
+		if (strlen(line) < 2) {
+			break;
+		}
+		r = parse_line(line);
+		if (!r) {
+			printk(KERN_ERR "ABAC LSM: Out of memory while parsing the policy, no policy loaded");
+			free_rules(rules, n);
+			return;
+		}
+		if (r->id >= n) {
+			printk(KERN_ERR "ABAC LSM: Rule %u is out of the %u rules of the policy", r->id, n);
+			free_rule(r);
+			continue;
+		}
+		rules[r->id] = r;
+		printk("Added rule %u to array", r->id);
+	}
+	compile_policy(rules, n, env);
+	rule_hits_stride = ALIGN(n, SMP_CACHE_BYTES / sizeof(u64));
+	rule_hits = kvcalloc((size_t)nr_cpu_ids * rule_hits_stride, sizeof(u64), GFP_KERNEL);
+	if (!rule_hits) {
+		printk(KERN_ERR "ABAC LSM: Out of memory for the rule hit counters, rules are not reordered");
+	}
+	rule_score = kcalloc(n, sizeof(u64), GFP_KERNEL);
+	rule_last = kcalloc(n, sizeof(u64), GFP_KERNEL);
+	dominance = build_dominance(rules, n);
+	count = n;
+	smp_store_release(&policy, rules);
+	smp_store_release(&rule_store, build_rule_store(rules, n));
+	if (rule_store == NULL) {
+		printk(KERN_ERR "ABAC LSM: Failed to store the compiled policy, rules are read from the rule lists");
+	}
+}
+
+void clear_policy() {
+	// Clear the rules in policy array
+	// Runs while the engine is offline, so no decision or reorder pass
+	// reads the rules or the hit counters freed here
+	printk("clearing policy array...");
+	/* The rule engines drop the ranges that use the store before this */
+	free_rule_store(rule_store);
+	rule_store = NULL;
+	if (policy != NULL) {
+		free_rules(policy, count);
+	}
+	count = 0;
+	policy = NULL;
+	kvfree(rule_hits);
+	rule_hits = NULL;
+	kfree(rule_score);
+	rule_score = NULL;
+	kfree(rule_last);
+	rule_last = NULL;
+	kvfree(dominance);
+	dominance = NULL;
+}
+
+void print_policy() {
+	int i;
+	printk("Printing policy array...");
+	printk("Contains %d rules", count);
+	for (i = 0; i < count; i++) {
+		printk("ID = %u", policy[i]->id);
+		printk("User attributes");
+		print_avp(policy[i]->user);
+		printk("Environmental attributes");
+		print_avp(policy[i]->env);
+		printk("Object attributes");
+		print_avp(policy[i]->obj);
+		printk("Operation");
+		if (policy[i]->op == ABAC_MODIFY) printk("MODIFY");
+		else if (policy[i]->op == ABAC_READ) printk("READ");
+		else printk("IGNORE");
+	}
+}
+
+void policy_mem_stats(struct abac_mem_stats *s) {
+	unsigned int i;
+
+	if (policy == NULL) {
+		return;
+	}
+	mem_account(s, ABAC_MEM_RULES, policy);
+	mem_account(s, ABAC_MEM_RULES, rule_score);
+	mem_account(s, ABAC_MEM_RULES, rule_last);
+	if (rule_store != NULL) {
+		mem_account(s, ABAC_MEM_RULES, rule_store);
+		mem_account(s, ABAC_MEM_RULES, rule_store->slot);
+		mem_account(s, ABAC_MEM_RULES, rule_store->id);
+		mem_account(s, ABAC_MEM_RULES, rule_store->op);
+		mem_account(s, ABAC_MEM_RULES, rule_store->env_first);
+		mem_account(s, ABAC_MEM_RULES, rule_store->pred_start);
+		mem_account(s, ABAC_MEM_RULES, rule_store->env_start);
+		mem_account(s, ABAC_MEM_RULES, rule_store->preds);
+	}
+	if (dominance != NULL) {
+		s->count[ABAC_MEM_RULES]++;
+		s->bytes[ABAC_MEM_RULES] += DIV_ROUND_UP((u64)count * count, 64) * sizeof(u64);
+	}
+	if (rule_hits != NULL) {
+		s->count[ABAC_MEM_RULES]++;
+		s->bytes[ABAC_MEM_RULES] += (u64)nr_cpu_ids * rule_hits_stride * sizeof(u64);
+	}
+	for (i = 0; i < count; i++) {
+		if (policy[i] == NULL) {
+			continue;
+		}
+		mem_account(s, ABAC_MEM_RULES, policy[i]);
+		avp_list_mem_stats(policy[i]->user, s);
+		avp_list_mem_stats(policy[i]->env, s);
+		avp_list_mem_stats(policy[i]->obj, s);
+	}
+}
@@ -0,0 +1,766 @@
+#include <linux/limits.h>
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include "adaptive.h"
+#include "engine.h"
+#include "path_trie.h"
+#include "policy.h"
+#include "rules.h"
+#include "shape.h"
+
+/*
+ * Objects are compiled lazily. Loading the obj_rules file only splits each
+ * line into its path and its raw rule id list; both stay inside the securityfs
+ * buffer that holds the file. The rule list of an object is built the first
+ * time the object is looked up and published with cmpxchg(), so concurrent
+ * first accesses agree on a single list.
+ *
+ * Compiled lists are replaced by reorder_obj_rule_map(). Lists are only used
+ * inside engine_read_lock(), so a replaced list can be freed once
+ * engine_synchronize() returns. obj_map_lock serializes loading, clearing
+ * and reordering.
+ *
+ * The adaptive engines share the table and keep the representation they
+ * chose for an object in the same entry. The index engines load the table
+ * from obj_attrs, whose lines hold the attributes of the object instead of
+ * its rule ids, and set the lists with replace_obj_rule_lists().
+ *
+ * Lists are pruned when they are compiled: the rules that another rule of the
+ * same list dominates are dropped, see prune_list(). Loading a policy drops
+ * the lists compiled for the previous one, so they are compiled and pruned
+ * again on their next access, and prunes the derived lists of the index
+ * engines, which have no raw record.
+ *
+ * The rule engines decide with ranges instead of lists: arrays of the slots
+ * of the covering rules in rule_store, split by the operation they grant.
+ * Like lists, a range is built on the first access to its object once the
+ * policy is compiled, from the raw record when the list is not compiled, and
+ * published with cmpxchg(). Reordering sorts the ranges that exist, replacing
+ * a list drops the range of the object, and the ranges are dropped before the
+ * store is freed.
+ *
+ * Objects are found through a trie of their path components, see
+ * path_trie.c, and kept in obj_list for the walks over every object. An
+ * entry also covers every path below its own that has no entry, so a
+ * directory line gives all the files under the directory the rules of the
+ * line. Lookups return the entry of the nearest ancestor, the path itself
+ * included.
+ */
+static struct path_trie obj_trie;
+static HLIST_HEAD(obj_list);
+static DEFINE_MUTEX(obj_map_lock);
+static unsigned int obj_count = 0;
+
+static int parse_rule_list(char *line, obj_rule **list) {
+	/* Parse the comma separated rule ids of a single object into @list.
+	 * Ids that do not parse are skipped. Returns -ENOMEM with @list set to
+	 * NULL if memory runs out */
+	char *id_str;
+	obj_rule *head, *r;
+
+	head = NULL;
+	while ((id_str = strsep(&line, ",")) != NULL) {
+		r = kcalloc(1, sizeof(obj_rule), GFP_KERNEL);
+		if (!r) {
+			clear_rule_list(head);
+			*list = NULL;
+			return -ENOMEM;
+		}
+		if (kstrtouint(id_str, 10, &(r->id))) {
+			kfree(r);
+			continue;
+		}
+		if (head != NULL) {
+			r->next = head;
+		}
+		head = r;
+	}
+	*list = head;
+	return 0;
+}
+
+void clear_rule_list(obj_rule *head) {
+	obj_rule *to_free;
+	while (head != NULL) {
+		to_free = head;
+		head = head->next;
+		kfree(to_free);
+	}
+}
+
+#define PRUNE_MAX_RULES 64
+
+static unsigned int rule_list_len(obj_rule *r) {
+	unsigned int n = 0;
+
+	for (; r != NULL; r = r->next) {
+		n++;
+	}
+	return n;
+}
+
+static obj_rule *prune_list(obj_rule *src, unsigned int *dropped) {
+	/* Return @src without its dominated rules, or @src itself if no rule is
+	 * dominated, the list is too long or memory runs out. The caller frees
+	 * @src when a new list is returned.
+	 * A rule is dropped when another rule of the list dominates it and is
+	 * either before it or not dominated by it, so of equivalent rules only
+	 * the first one is kept. rule_dominates() reads the relation computed
+	 * when the policy was loaded */
+	unsigned int ids[PRUNE_MAX_RULES];
+	unsigned int n, i, j;
+	u64 pruned;
+	obj_rule *r, *list;
+
+	*dropped = 0;
+	if (get_policy_size() == 0 || rule_list_len(src) > PRUNE_MAX_RULES) {
+		return src;
+	}
+	n = 0;
+	for (r = src; r != NULL; r = r->next) {
+		ids[n++] = r->id;
+	}
+	pruned = 0;
+	for (j = 0; j < n; j++) {
+		for (i = 0; i < n; i++) {
+			if (i != j && rule_dominates(ids[i], ids[j]) &&
+			    (i < j || !rule_dominates(ids[j], ids[i]))) {
+				pruned |= 1ULL << j;
+				break;
+			}
+		}
+	}
+	if (pruned == 0) {
+		return src;
+	}
+	/* Build the new list back to front */
+	list = NULL;
+	for (j = n; j > 0; j--) {
+		if (pruned & (1ULL << (j - 1))) {
+			continue;
+		}
+		r = kcalloc(1, sizeof(obj_rule), GFP_KERNEL);
+		if (!r) {
+			clear_rule_list(list);
+			return src;
+		}
+		r->id = ids[j - 1];
+		r->next = list;
+		list = r;
+	}
+	for (j = 0; j < n; j++) {
+		*dropped += (pruned >> j) & 1;
+	}
+	return list;
+}
+
+static int compile_rule_list(struct rule_obj *o, obj_rule **list) {
+	/* Parse the raw record of @o into @list and prune it. Returns -ENOMEM
+	 * with @list set to NULL if memory runs out */
+	obj_rule *parsed, *pruned;
+	unsigned int dropped;
+	char *raw;
+
+	/* strsep() writes into its input and other CPUs may be compiling the
+	 * same record, so parse a private copy */
+	raw = kstrdup(o->raw, GFP_KERNEL);
+	if (!raw) {
+		*list = NULL;
+		return -ENOMEM;
+	}
+	if (parse_rule_list(raw, &parsed)) {
+		kfree(raw);
+		*list = NULL;
+		return -ENOMEM;
+	}
+	kfree(raw);
+	pruned = prune_list(parsed, &dropped);
+	if (pruned != parsed) {
+		clear_rule_list(parsed);
+	}
+	WRITE_ONCE(o->pruned, dropped);
+	*list = pruned;
+	return 0;
+}
+
+obj_rule *get_rule_obj_list(struct rule_obj *o) {
+	/* Build the rule list of an object from its raw record on first access */
+	obj_rule *head, *cur;
+
+	head = smp_load_acquire(&o->head);
+	if (head != NULL || o->raw == NULL) {
+		return head;
+	}
+	if (compile_rule_list(o, &head)) {
+		/* The object is denied and compiled again next time */
+		return NULL;
+	}
+	cur = cmpxchg(&o->head, NULL, head);
+	if (cur != NULL) {
+		/* Another CPU published first, use its list */
+		clear_rule_list(head);
+		head = cur;
+	}
+	return head;
+}
+
+static void parse_obj_lines(char *data, int attrs) {
+	/* Index the objects of an obj_rules or obj_attrs file */
+	struct path_trie_node *t;
+	struct rule_obj *o;
+	char *line, *c;
+	unsigned int n = 0, lines = 0;
+
+	/* The trie gets a bucket per line */
+	for (c = data; (c = strchr(c, '\n')) != NULL; c++) {
+		lines++;
+	}
+	mutex_lock(&obj_map_lock);
+	INIT_HLIST_HEAD(&obj_list);
+	obj_count = 0;
+	if (path_trie_init(&obj_trie, lines)) {
+		printk(KERN_ERR "ABAC LSM: Out of memory for the trie of %u objects", lines);
+		mutex_unlock(&obj_map_lock);
+		return;
+	}
+
+	while((line = strsep(&data, "\n")) != NULL) {
+		/* Ignore empty lines */
+		if (strlen(line) < 2) {
+			break;
+		}
+		/* add new object to the trie */
+		o = kcalloc(1, sizeof(struct rule_obj), GFP_KERNEL);
+		if (!o) {
+			printk(KERN_ERR "ABAC LSM: Out of memory while indexing objects");
+			break;
+		}
+		o->path = strsep(&line, ":");
+		if (!attrs) {
+			o->raw = line;
+		} else if (line != NULL && *line != '\0') {
+			o->attrs = parse_avp(line);
+		}
+		t = path_trie_insert(&obj_trie, o->path);
+		if (t != NULL) {
+			t->obj = o;
+		}
+		hlist_add_head(&(o->node), &obj_list);
+		n++;
+	}
+	obj_count = n;
+	mutex_unlock(&obj_map_lock);
+	printk("Indexed %u objects", n);
+}
+
+/* Used by abac securityfs for parsing the obj_rules file
+ * Iterate over the entire file and index the raw rule list of each object.
+ * @data must stay allocated until clear_obj_rule_map() is called */
+void parse_obj_rule_map(char *data) {
+	parse_obj_lines(data, 0);
+}
+
+/* Used by abac securityfs for parsing the obj_attrs file
+ * <path>:<o_attr1>=<o_val1>,<o_attr2>=<o_val2>
+ * Objects have no rule list until one is set with replace_obj_rule_lists() */
+void parse_obj_attrs_map(char *data) {
+	parse_obj_lines(data, 1);
+}
+
+struct rule_obj *get_rule_obj(char *path) {
+	/* Get the entry of the object at a given path or of its nearest
+	 * ancestor that has one */
+	return path_trie_lookup_prefix(&obj_trie, path);
+}
+
+struct rule_obj *get_rule_obj_dentry(struct dentry *dentry) {
+	/* Same as get_rule_obj() without building the path of @dentry */
+	return path_trie_lookup_dentry(&obj_trie, dentry, 1);
+}
+
+obj_rule *get_obj_rule_list(char *path) {
+	/* Get rules mapped to object at a given path */
+	struct rule_obj *o = get_rule_obj(path);
+	return o ? get_rule_obj_list(o) : NULL;
+}
+
+void for_each_rule_obj(void (*fn)(struct rule_obj *, void *), void *arg) {
+	/* Call @fn on every loaded object with obj_map_lock held */
+	struct rule_obj *cur;
+
+	mutex_lock(&obj_map_lock);
+	hlist_for_each_entry(cur, &obj_list, node) {
+		fn(cur, arg);
+	}
+	mutex_unlock(&obj_map_lock);
+}
+
+char **get_rule_obj_paths(unsigned int *n) {
+	/* Copy the paths of the loaded objects into an array that the caller
+	 * frees with kvfree(). The paths point into the securityfs buffer of the
+	 * obj_rules file, so they are only valid until it is written again.
+	 * Returns NULL with *n set to 0 if no object is loaded */
+	struct rule_obj *cur;
+	char **paths;
+	unsigned int i;
+
+	mutex_lock(&obj_map_lock);
+	*n = 0;
+	hlist_for_each_entry(cur, &obj_list, node) {
+		(*n)++;
+	}
+	paths = NULL;
+	if (*n != 0) {
+		paths = kvmalloc_array(*n, sizeof(char *), GFP_KERNEL);
+	}
+	if (paths) {
+		i = 0;
+		hlist_for_each_entry(cur, &obj_list, node) {
+			paths[i++] = cur->path;
+		}
+	}
+	mutex_unlock(&obj_map_lock);
+	return paths;
+}
+
+void clear_obj_rule_map(void) {
+	struct rule_obj *cur;
+	struct hlist_node *tmp;
+	printk("clearing object table...");
+	mutex_lock(&obj_map_lock);
+	hlist_for_each_entry_safe(cur, tmp, &obj_list, node) {
+		clear_rule_list(cur->head);
+		kfree(cur->range);
+		clear_avp_list(cur->attrs);
+		clear_obj_dtree(cur->tree);
+		hlist_del_init(&(cur->node));
+		kfree(cur);
+	}
+	path_trie_clear(&obj_trie);
+	obj_count = 0;
+	mutex_unlock(&obj_map_lock);
+}
+
+#define REORDER_MAX_RULES 64
+
+static int sort_ranked(unsigned int *ids, u64 *ranks, unsigned int n) {
+	/* Insertion sort by descending rank, equal ranks keep their order.
+	 * Returns 1 if anything moved */
+	unsigned int i, j, id;
+	u64 rk;
+	int moved = 0;
+
+	for (i = 1; i < n; i++) {
+		id = ids[i];
+		rk = ranks[i];
+		for (j = i; j > 0 && ranks[j - 1] < rk; j--) {
+			ids[j] = ids[j - 1];
+			ranks[j] = ranks[j - 1];
+			moved = 1;
+		}
+		ids[j] = id;
+		ranks[j] = rk;
+	}
+	return moved;
+}
+
+static obj_rule *sort_rule_list(obj_rule *head, u64 (*rank)(unsigned int)) {
+	/* Return a copy of the list ordered by descending rank, or NULL if the
+	 * list is already in that order. Equal ranks keep their current order */
+	unsigned int ids[REORDER_MAX_RULES];
+	u64 ranks[REORDER_MAX_RULES];
+	unsigned int n, i;
+	obj_rule *r, *sorted;
+
+	n = 0;
+	for (r = head; r != NULL; r = r->next) {
+		if (n == REORDER_MAX_RULES) {
+			/* Longer lists are left in file order */
+			return NULL;
+		}
+		ids[n] = r->id;
+		ranks[n] = rank(r->id);
+		n++;
+	}
+	if (!sort_ranked(ids, ranks, n)) {
+		return NULL;
+	}
+	/* Build the new list back to front */
+	sorted = NULL;
+	for (i = n; i > 0; i--) {
+		r = kcalloc(1, sizeof(obj_rule), GFP_KERNEL);
+		if (!r) {
+			clear_rule_list(sorted);
+			return NULL;
+		}
+		r->id = ids[i - 1];
+		r->next = sorted;
+		sorted = r;
+	}
+	return sorted;
+}
+
+static struct rule_range *sort_rule_range(struct rule_range *range, u64 (*rank)(unsigned int)) {
+	/* Same as sort_rule_list() within each operation of a range */
+	u64 ranks[REORDER_MAX_RULES];
+	struct rule_range *sorted;
+	unsigned int i;
+	int moved;
+
+	if (range->n > REORDER_MAX_RULES) {
+		return NULL;
+	}
+	sorted = kmalloc(sizeof(struct rule_range) + range->n * sizeof(unsigned int), GFP_KERNEL);
+	if (!sorted) {
+		return NULL;
+	}
+	memcpy(sorted, range, sizeof(struct rule_range) + range->n * sizeof(unsigned int));
+	for (i = 0; i < range->n; i++) {
+		ranks[i] = rank(rule_store->id[range->slot[i]]);
+	}
+	moved = sort_ranked(sorted->slot, ranks, range->n_modify);
+	moved |= sort_ranked(sorted->slot + range->n_modify, ranks + range->n_modify,
+			     range->n - range->n_modify);
+	if (!moved) {
+		kfree(sorted);
+		return NULL;
+	}
+	return sorted;
+}
+
+static struct rule_range *compile_rule_range(obj_rule *head) {
+	/* Slots of the rules of @head, the ones granting MODIFY first and each
+	 * operation in list order. Rules missing from the policy or granting
+	 * nothing are left out. Returns NULL for an empty list, which denies
+	 * even the irrelevant operations */
+	struct rule_store *st = rule_store;
+	struct rule_range *range;
+	unsigned int n, s;
+	obj_rule *r;
+	int pass;
+
+	n = 0;
+	for (r = head; r != NULL; r = r->next) {
+		n++;
+	}
+	if (n == 0) {
+		return NULL;
+	}
+	range = kmalloc(sizeof(struct rule_range) + n * sizeof(unsigned int), GFP_KERNEL);
+	if (!range) {
+		return NULL;
+	}
+	range->n = 0;
+	for (pass = ABAC_MODIFY; pass <= ABAC_READ; pass++) {
+		if (pass == ABAC_READ) {
+			range->n_modify = range->n;
+		}
+		for (r = head; r != NULL; r = r->next) {
+			s = r->id < get_policy_size() ? st->slot[r->id] : RULE_NO_SLOT;
+			if (s != RULE_NO_SLOT && st->op[s] == pass) {
+				range->slot[range->n++] = s;
+			}
+		}
+	}
+	return range;
+}
+
+static struct rule_range *obj_rule_range(struct rule_obj *o) {
+	/* Range of @o, compiled from the raw record if the list is not */
+	obj_rule *head = smp_load_acquire(&o->head), *parsed = NULL;
+	struct rule_range *range;
+
+	if (head == NULL && o->raw != NULL) {
+		if (compile_rule_list(o, &parsed)) {
+			return NULL;
+		}
+		head = parsed;
+	}
+	range = compile_rule_range(head);
+	clear_rule_list(parsed);
+	return range;
+}
+
+struct rule_range *get_rule_obj_range(struct rule_obj *o) {
+	/* Build the range of an object on first access. NULL without a compiled
+	 * policy, for an empty list or if memory runs out, the object is then
+	 * decided with its list */
+	struct rule_range *range, *cur;
+
+	range = smp_load_acquire(&o->range);
+	if (range != NULL || smp_load_acquire(&rule_store) == NULL) {
+		return range;
+	}
+	range = obj_rule_range(o);
+	if (range == NULL) {
+		return NULL;
+	}
+	cur = cmpxchg(&o->range, NULL, range);
+	if (cur != NULL) {
+		/* Another CPU published first, use its range */
+		kfree(range);
+		range = cur;
+	}
+	return range;
+}
+
+void drop_obj_rule_ranges(void) {
+	/* Used by the rule engines before the policy is cleared. Free the range
+	 * of every object once no decision uses it */
+	struct rule_obj *cur;
+	struct rule_range **retired;
+	unsigned int n_retired, i;
+
+	mutex_lock(&obj_map_lock);
+	retired = kcalloc(obj_count ? obj_count : 1, sizeof(struct rule_range *), GFP_KERNEL);
+	if (!retired) {
+		mutex_unlock(&obj_map_lock);
+		return;
+	}
+	n_retired = 0;
+	hlist_for_each_entry(cur, &obj_list, node) {
+		retired[n_retired] = xchg(&cur->range, NULL);
+		if (retired[n_retired] != NULL) {
+			n_retired++;
+		}
+	}
+	engine_synchronize();
+	for (i = 0; i < n_retired; i++) {
+		kfree(retired[i]);
+	}
+	kfree(retired);
+	mutex_unlock(&obj_map_lock);
+}
+
+void reorder_obj_rule_map(u64 (*rank)(unsigned int)) {
+	/* Reorder the compiled rule list and the range of every object by
+	 * descending rank. Objects that were never accessed have neither and
+	 * keep file order until they are */
+	struct rule_obj *cur;
+	obj_rule *sorted, *old, **retired;
+	struct rule_range *sorted_range, *old_range, **retired_ranges;
+	unsigned int n_retired, n_retired_ranges, i;
+
+	mutex_lock(&obj_map_lock);
+	if (obj_count == 0) {
+		mutex_unlock(&obj_map_lock);
+		return;
+	}
+	retired = kcalloc(obj_count, sizeof(obj_rule *), GFP_KERNEL);
+	retired_ranges = kcalloc(obj_count, sizeof(struct rule_range *), GFP_KERNEL);
+	if (!retired || !retired_ranges) {
+		kfree(retired);
+		kfree(retired_ranges);
+		mutex_unlock(&obj_map_lock);
+		return;
+	}
+	n_retired = 0;
+	n_retired_ranges = 0;
+	hlist_for_each_entry(cur, &obj_list, node) {
+		/* Ranges are only replaced under obj_map_lock */
+		old_range = cur->range;
+		if (old_range != NULL && rule_store != NULL) {
+			sorted_range = sort_rule_range(old_range, rank);
+			if (sorted_range != NULL) {
+				smp_store_release(&cur->range, sorted_range);
+				retired_ranges[n_retired_ranges++] = old_range;
+			}
+		}
+		old = smp_load_acquire(&cur->head);
+		if (old == NULL) {
+			continue;
+		}
+		sorted = sort_rule_list(old, rank);
+		if (sorted == NULL) {
+			continue;
+		}
+		/* Only get_rule_obj_list() publishes into an empty slot, so the head
+		 * cannot change under us while obj_map_lock is held */
+		cmpxchg(&cur->head, old, sorted);
+		retired[n_retired++] = old;
+	}
+	/* Wait for readers still walking the old lists before freeing them */
+	engine_synchronize();
+	for (i = 0; i < n_retired; i++) {
+		clear_rule_list(retired[i]);
+	}
+	for (i = 0; i < n_retired_ranges; i++) {
+		kfree(retired_ranges[i]);
+	}
+	kfree(retired);
+	kfree(retired_ranges);
+	mutex_unlock(&obj_map_lock);
+	if (n_retired || n_retired_ranges) {
+		printk("Reordered %u object rule lists and %u ranges", n_retired, n_retired_ranges);
+	}
+}
+
+void replace_obj_rule_lists(obj_rule *(*fn)(struct rule_obj *, void *), void *arg) {
+	/* Give every object the list returned by @fn, which may be NULL, and
+	 * free the previous lists once no decision uses them. Objects for which
+	 * @fn returns the current list keep it, the others lose their range,
+	 * which is built again from the new list on the next access */
+	struct rule_obj *cur;
+	obj_rule *old, *new, **retired;
+	struct rule_range **retired_ranges;
+	unsigned int n_retired, n_retired_ranges, i;
+
+	mutex_lock(&obj_map_lock);
+	retired = kcalloc(obj_count ? obj_count : 1, sizeof(obj_rule *), GFP_KERNEL);
+	retired_ranges = kcalloc(obj_count ? obj_count : 1, sizeof(struct rule_range *), GFP_KERNEL);
+	if (!retired || !retired_ranges) {
+		kfree(retired);
+		kfree(retired_ranges);
+		mutex_unlock(&obj_map_lock);
+		return;
+	}
+	n_retired = 0;
+	n_retired_ranges = 0;
+	hlist_for_each_entry(cur, &obj_list, node) {
+		old = smp_load_acquire(&cur->head);
+		new = fn(cur, arg);
+		if (new == old) {
+			continue;
+		}
+		retired[n_retired] = xchg(&cur->head, new);
+		if (retired[n_retired] != NULL) {
+			n_retired++;
+		}
+		retired_ranges[n_retired_ranges] = xchg(&cur->range, NULL);
+		if (retired_ranges[n_retired_ranges] != NULL) {
+			n_retired_ranges++;
+		}
+	}
+	engine_synchronize();
+	for (i = 0; i < n_retired; i++) {
+		clear_rule_list(retired[i]);
+	}
+	for (i = 0; i < n_retired_ranges; i++) {
+		kfree(retired_ranges[i]);
+	}
+	kfree(retired);
+	kfree(retired_ranges);
+	mutex_unlock(&obj_map_lock);
+}
+
+struct prune_ctx {
+	unsigned int pruned;
+	unsigned int lists;
+};
+
+static obj_rule *prune_rule_list(struct rule_obj *o, void *arg) {
+	/* Lists compiled from a raw record are dropped and compiled again,
+	 * pruned for the new policy, on their next access. Derived lists have
+	 * no record and are pruned here */
+	struct prune_ctx *c = arg;
+	obj_rule *head, *list;
+	unsigned int dropped;
+
+	head = smp_load_acquire(&o->head);
+	if (o->raw != NULL) {
+		o->pruned = 0;
+		return NULL;
+	}
+	list = prune_list(head, &dropped);
+	o->pruned = dropped;
+	if (list != head) {
+		c->pruned += dropped;
+		c->lists++;
+	}
+	return list;
+}
+
+unsigned int prune_obj_rule_map(void) {
+	/* Prune every list for the loaded policy, see prune_list(). Returns the
+	 * number of rules dropped from derived lists */
+	struct prune_ctx c = {};
+
+	replace_obj_rule_lists(prune_rule_list, &c);
+	if (c.pruned) {
+		printk("Pruned %u dominated rules from %u object rule lists", c.pruned, c.lists);
+	}
+	return c.pruned;
+}
+
+void print_obj_rule_list(obj_rule *r) {
+	while (r != NULL) {
+		printk("%u-", r->id);
+		r = r->next;
+	}
+}
+
+void print_obj_rule_map() {
+	struct rule_obj *cur;
+	printk("Printing object table...");
+	hlist_for_each_entry(cur, &obj_list, node) {
+		printk("Path : %s", cur->path);
+		if (cur->head == NULL) {
+			printk("(not compiled) %s", cur->raw);
+			continue;
+		}
+		print_obj_rule_list(cur->head);
+	}
+}
+
+void rule_obj_mem_stats(struct abac_mem_stats *s) {
+	/* obj_map_lock keeps reorder_obj_rule_map() from freeing the lists */
+	struct rule_obj *cur;
+	obj_rule *r;
+
+	mutex_lock(&obj_map_lock);
+	hlist_for_each_entry(cur, &obj_list, node) {
+		mem_account(s, ABAC_MEM_OBJECTS, cur);
+		avp_list_mem_stats(cur->attrs, s);
+		for (r = smp_load_acquire(&cur->head); r != NULL; r = r->next) {
+			mem_account(s, ABAC_MEM_RULE_REFS, r);
+		}
+		mem_account(s, ABAC_MEM_RULE_REFS, cur->range);
+		obj_dtree_mem_stats(smp_load_acquire(&cur->tree), s);
+	}
+	path_trie_mem_stats(&obj_trie, s);
+	mutex_unlock(&obj_map_lock);
+}
+
+void show_rule_obj_shape(struct seq_file *m) {
+	/* Chain length of every bucket of the trie edges and length of the
+	 * covering rule list of every object. Lengths are counted in the raw
+	 * records, so objects that were never accessed are included. Objects
+	 * loaded from obj_attrs are counted in their derived lists. Then the
+	 * number of rules pruned from every list, 0 until the list is compiled */
+	struct shape_hist *h;
+	struct rule_obj *cur;
+	obj_rule *r;
+	unsigned len;
+	const char *c;
+
+	h = kcalloc(3, sizeof(struct shape_hist), GFP_KERNEL);
+	if (!h) {
+		return;
+	}
+	mutex_lock(&obj_map_lock);
+	path_trie_chains(&obj_trie, &h[0]);
+	hlist_for_each_entry(cur, &obj_list, node) {
+		len = 0;
+		if (cur->raw != NULL) {
+			len = 1;
+			for (c = cur->raw; *c; c++) {
+				len += *c == ',';
+			}
+		} else {
+			for (r = smp_load_acquire(&cur->head); r != NULL; r = r->next) {
+				len++;
+			}
+		}
+		shape_add(&h[1], len);
+		shape_add(&h[2], cur->pruned);
+	}
+	mutex_unlock(&obj_map_lock);
+	show_shape_hist(m, "obj_chain", &h[0]);
+	show_shape_hist(m, "rule_list", &h[1]);
+	show_shape_hist(m, "rule_pruned", &h[2]);
+	kfree(h);
+}
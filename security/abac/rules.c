@@ -0,0 +1,317 @@
+#include <linux/string.h>
+#include <linux/workqueue.h>
+#include "abacfs.h"
+#include "engine.h"
+#include "rules.h"
+
+/*
+ * Rule engines. Each object has the list of rules that cover it and the
+ * request is allowed by the first rule of the list it satisfies. rules and
+ * rules_enc share the object table and the policy and only differ in how
+ * attribute pairs are compared.
+ *
+ * Once the policy is loaded the lists are compiled into ranges of rule_store
+ * slots on first access, see rule_obj.c, and requests read the rules from the
+ * arrays of the store. The rules granting MODIFY come first in a range, so a MODIFY request
+ * stops before the rules that only grant READ. Objects without a range are
+ * decided with their list.
+ */
+
+static int check_op(enum operation req_op, enum operation rule_op) {
+	/* Check if operation is matching
+	 * @req_op = access request operation
+	 * @rule_op = abac rule operation
+	 * If rule says modify, we also allow reads
+	 */
+	if (req_op == rule_op) return 1;
+	if (req_op == ABAC_READ && rule_op == ABAC_MODIFY) return 1;
+	return 0;
+}
+
+static __always_inline int __check_avps(avp *a, avp *r, const int encoded) {
+	/* Check if avps are matching
+	 * Here avps can be user or env
+	 * @c = access request avp (user or current env avps)
+	 * @r = rule avp (user or current env avps)
+	 * If every avp in the r is also in the a, then allow
+	 * Predicates are ordered by compile_policy() so the ones most likely
+	 * to fail are tested first, and the check stops at the first miss
+	 */
+	avp *cursor;
+	while (r != NULL) {
+		cursor = a;
+		while (cursor != NULL){
+			if (avp_match(cursor, r, encoded)) {
+				// found a matching avp, got to the next avp in rule
+				break;
+			}
+			cursor = cursor->next;
+		}
+		if (cursor == NULL) {
+			// no matching avp, the rule is not satisfied
+			return 0;
+		}
+		r = r->next;
+	}
+	return 1;
+}
+
+int check_avps(avp *a, avp *r) {
+	return avp_encoded ? __check_avps(a, r, 1) : __check_avps(a, r, 0);
+}
+
+static __always_inline int __resolve_rules(avp *user_attr, obj_rule *head, enum operation op,
+					   const int encoded) {
+	/* Resolve access request using
+	 * 1. User attributes (*user_attr)
+	 * 2. Covering rules of the object (abac_rule *head)
+	 * 3. Current environmental attributes (avp *env_attr -> from abacfs)
+	 * 4. Access operation (READ or MODIFY)
+	 */
+	abac_rule *r;
+	if (user_attr == NULL) {
+		/* If the user doesn't have any attributes, access is DENIED */
+		return 0;
+	}
+	if (head == NULL) {
+		/* If the object doesn't have any covering rules, access is DENIED */
+		return 0;
+	}
+	if (op == ABAC_IGNORE) {
+		/* If not a relevant operation, allow it */
+		return 1;
+	}
+	// Iterate over covering rules
+	while (head != NULL) {
+		// Get rule from policy hash table
+		r = get_rule(head->id);
+		if (r == NULL) {
+			/* Rule id is not in the loaded policy */
+			head = head->next;
+			continue;
+		}
+		// compare operation
+		if (check_op(op, r->op) == 0) {
+			head = head->next;
+			continue;
+		}
+
+		// compare env attrs first if compile_policy() found it cheaper
+		if (r->env_first && __check_avps(env_attr, r->env, encoded) == 0) {
+			head = head->next;
+			continue;
+		}
+
+		// compare user attrs
+		if (__check_avps(user_attr, r->user, encoded) == 0) {
+			head = head->next;
+			continue;
+		}
+
+		// compare env attrs
+		if (!r->env_first && __check_avps(env_attr, r->env, encoded) == 0){
+			head = head->next;
+			continue;
+		}
+
+		// If we reached here, the current rule is satisfied
+		record_rule_hit(head->id);
+		return 1;
+	}
+	return 0;
+}
+
+static __always_inline int __check_preds(avp *a, const struct rule_pred *p,
+					 const struct rule_pred *end, const int encoded) {
+	/* Same as __check_avps() for the predicates of a rule_store slot */
+	avp *cursor;
+
+	for (; p < end; p++) {
+		for (cursor = a; cursor != NULL; cursor = cursor->next) {
+			if (encoded ? cursor->name_id == p->name_id && cursor->value_id == p->value_id
+				    : avp_match(cursor, p->pair, 0)) {
+				break;
+			}
+		}
+		if (cursor == NULL) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static __always_inline int __resolve_range(avp *user_attr, const struct rule_range *range,
+					   enum operation op, const int encoded) {
+	/* __resolve_rules() over the slots of a range. Ranges only exist while
+	 * rule_store does, see drop_obj_rule_ranges() */
+	const struct rule_store *st = smp_load_acquire(&rule_store);
+	const struct rule_pred *user, *env, *end;
+	unsigned int i, n, s;
+
+	if (user_attr == NULL) {
+		return 0;
+	}
+	if (op == ABAC_IGNORE) {
+		return 1;
+	}
+	/* Every rule of the range grants READ, only the first n_modify grant MODIFY */
+	n = op == ABAC_MODIFY ? range->n_modify : range->n;
+	for (i = 0; i < n; i++) {
+		s = range->slot[i];
+		user = st->preds + st->pred_start[s];
+		env = st->preds + st->env_start[s];
+		end = st->preds + st->pred_start[s + 1];
+		if (st->env_first[s] && __check_preds(env_attr, env, end, encoded) == 0) {
+			continue;
+		}
+		if (__check_preds(user_attr, user, env, encoded) == 0) {
+			continue;
+		}
+		if (!st->env_first[s] && __check_preds(env_attr, env, end, encoded) == 0) {
+			continue;
+		}
+		record_rule_hit(st->id[s]);
+		return 1;
+	}
+	return 0;
+}
+
+static __always_inline int __resolve_obj(avp *user_attr, struct rule_obj *o, enum operation op,
+					 const int encoded) {
+	struct rule_range *range;
+
+	if (o == NULL) {
+		return 0;
+	}
+	range = get_rule_obj_range(o);
+	if (range != NULL) {
+		return __resolve_range(user_attr, range, op, encoded);
+	}
+	return __resolve_rules(user_attr, get_rule_obj_list(o), op, encoded);
+}
+
+int resolve_rules(avp *user_attr, obj_rule *head, enum operation op) {
+	if (avp_encoded) {
+		return __resolve_rules(user_attr, head, op, 1);
+	}
+	return __resolve_rules(user_attr, head, op, 0);
+}
+
+int rules_resolve_str(avp *user_attr, void *obj, enum operation op) {
+	return __resolve_obj(user_attr, obj, op, 0);
+}
+
+int rules_resolve_enc(avp *user_attr, void *obj, enum operation op) {
+	return __resolve_obj(user_attr, obj, op, 1);
+}
+
+void *rules_lookup(char *path) {
+	return get_rule_obj(path);
+}
+
+void *rules_lookup_dentry(struct dentry *dentry) {
+	return get_rule_obj_dentry(dentry);
+}
+
+void prune_rule_lists(void) {
+	/* Dominated rules never change a decision, dropping them shortens the
+	 * scans that end in a deny, see rule_dominates() */
+	if (get_policy_size() == 0) {
+		return;
+	}
+	prune_obj_rule_map();
+}
+
+void load_rule_objects(char *data) {
+	/* The lists are pruned when they are compiled */
+	parse_obj_rule_map(data);
+}
+
+void load_rule_policy(char *data) {
+	/* Predicates are ranked with the users and env loaded before the policy */
+	parse_policy(data, env_attr);
+	prune_rule_lists();
+}
+
+void clear_rule_policy(void) {
+	/* The ranges hold slots of the policy */
+	drop_obj_rule_ranges();
+	clear_policy();
+}
+
+
+static void mem_stats(struct abac_mem_stats *s) {
+	rule_obj_mem_stats(s);
+	policy_mem_stats(s);
+}
+
+/*
+ * Profile-guided ordering of covering rules.
+ * resolve_rules() stops at the first satisfied rule, so every
+ * REORDER_INTERVAL the compiled rule lists are sorted to try the rules that
+ * granted access most often first. Rules whose environment attributes do not
+ * match the current environment can never be satisfied and are moved to the
+ * end.
+ */
+#define REORDER_INTERVAL (10 * HZ)
+
+static void reorder_rules_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(reorder_work, reorder_rules_fn);
+
+static u64 rule_rank(unsigned int id) {
+	abac_rule *r = get_rule(id);
+	if (r == NULL || check_avps(env_attr, r->env) == 0) {
+		return 0;
+	}
+	return get_rule_score(id) + 1;
+}
+
+static void reorder_rules_fn(struct work_struct *work) {
+	update_rule_scores();
+	reorder_obj_rule_map(rule_rank);
+	schedule_delayed_work(&reorder_work, REORDER_INTERVAL);
+}
+
+void start_rule_reorder(void) {
+	schedule_delayed_work(&reorder_work, REORDER_INTERVAL);
+}
+
+void stop_rule_reorder(void) {
+	cancel_delayed_work_sync(&reorder_work);
+}
+
+const struct abac_engine rules_engine = {
+	.name = "rules",
+	.encoded = 0,
+	.obj_file = "obj_rules",
+	.load_objects = load_rule_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_rule_policy,
+	.clear_policy = clear_rule_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = rules_lookup,
+	.lookup_dentry = rules_lookup_dentry,
+	.resolve = rules_resolve_str,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_rule_obj_shape,
+};
+
+const struct abac_engine rules_enc_engine = {
+	.name = "rules_enc",
+	.encoded = 1,
+	.obj_file = "obj_rules",
+	.load_objects = load_rule_objects,
+	.clear_objects = clear_obj_rule_map,
+	.load_policy = load_rule_policy,
+	.clear_policy = clear_rule_policy,
+	.start = start_rule_reorder,
+	.stop = stop_rule_reorder,
+	.lookup = rules_lookup,
+	.lookup_dentry = rules_lookup_dentry,
+	.resolve = rules_resolve_enc,
+	.get_obj_paths = get_rule_obj_paths,
+	.mem_stats = mem_stats,
+	.show_shape = show_rule_obj_shape,
+};
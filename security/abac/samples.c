@@ -0,0 +1,124 @@
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#include <linux/relay.h>
+#include <linux/security.h>
+#include <linux/smp.h>
+#include "samples.h"
+
+/*
+ * Stream of per-access latency samples.
+ * While recording, every decision on a secured object writes one struct
+ * abac_sample to a relay buffer of the current CPU. The buffers are exposed as
+ * the securityfs files samples<cpu> and read in bulk after STOP, which flushes
+ * the partially filled sub-buffers. A full buffer drops new samples instead of
+ * overwriting unread ones, the number of dropped samples is logged on STOP.
+ *
+ * __relay_write() must not race with a reset or a flush of the channel.
+ * Writers test sampling with preemption disabled, so after clearing it
+ * synchronize_rcu() returns once no writer is left in the buffers.
+ */
+#define SAMPLE_SUBBUF_SIZE (256 * 1024)
+#define SAMPLE_N_SUBBUFS 16 // 4MB per CPU, about 170k samples
+
+static struct rchan *sample_chan = NULL;
+static DEFINE_PER_CPU(u64, samples_dropped);
+static bool sampling;
+/* Serializes RECORD and STOP */
+static DEFINE_MUTEX(sample_lock);
+
+static void stop_writers(void) {
+	WRITE_ONCE(sampling, false);
+	synchronize_rcu();
+}
+
+static int sample_subbuf_start(struct rchan_buf *buf, void *subbuf, void *prev_subbuf,
+			       size_t prev_padding) {
+	/* Called for every write that does not fit, returning 0 drops it */
+	if (relay_buf_full(buf)) {
+		this_cpu_inc(samples_dropped);
+		return 0;
+	}
+	return 1;
+}
+
+static struct dentry *create_sample_file(const char *filename, struct dentry *parent,
+					 umode_t mode, struct rchan_buf *buf, int *is_global) {
+	/* The samples hold the uid of every access, only root reads them */
+	return securityfs_create_file(filename, mode, parent, buf, &relay_file_operations);
+}
+
+static int remove_sample_file(struct dentry *dentry) {
+	securityfs_remove(dentry);
+	return 0;
+}
+
+static struct rchan_callbacks sample_callbacks = {
+	.subbuf_start = sample_subbuf_start,
+	.create_buf_file = create_sample_file,
+	.remove_buf_file = remove_sample_file,
+};
+
+int start_samples(struct dentry *dir) {
+	/* The channel is created by the first RECORD and reused afterwards */
+	int cpu;
+
+	mutex_lock(&sample_lock);
+	if (sample_chan) {
+		/* A RECORD without STOP may still have writers */
+		stop_writers();
+		relay_reset(sample_chan);
+	} else {
+		sample_chan = relay_open("samples", dir, SAMPLE_SUBBUF_SIZE, SAMPLE_N_SUBBUFS,
+					 &sample_callbacks, NULL);
+		if (!sample_chan) {
+			mutex_unlock(&sample_lock);
+			return -ENOMEM;
+		}
+	}
+	for_each_possible_cpu(cpu) {
+		per_cpu(samples_dropped, cpu) = 0;
+	}
+	smp_store_release(&sampling, true);
+	mutex_unlock(&sample_lock);
+	return 0;
+}
+
+void stop_samples(void) {
+	u64 dropped = 0;
+	int cpu;
+
+	mutex_lock(&sample_lock);
+	if (!sample_chan) {
+		mutex_unlock(&sample_lock);
+		return;
+	}
+	stop_writers();
+	relay_flush(sample_chan);
+	for_each_possible_cpu(cpu) {
+		dropped += per_cpu(samples_dropped, cpu);
+	}
+	mutex_unlock(&sample_lock);
+	if (dropped) {
+		printk("ABAC LSM: %llu samples were dropped, sample buffers are full", dropped);
+	}
+}
+
+void record_sample(u64 timestamp, unsigned int uid, enum operation op, int allowed, u64 ns) {
+	/* Called from the file_permission hook while recording */
+	struct abac_sample s = {
+		.timestamp = timestamp,
+		.ns = ns,
+		.uid = uid,
+		.op = op,
+		.allowed = allowed,
+	};
+
+	preempt_disable();
+	if (smp_load_acquire(&sampling)) {
+		s.cpu = smp_processor_id();
+		__relay_write(sample_chan, &s, sizeof(s));
+	}
+	preempt_enable();
+}
@@ -0,0 +1,163 @@
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/prandom.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "abacfs.h"
+#include "self_bench.h"
+
+/*
+ * In-kernel benchmark of the loaded policy, run by writing BENCH to the
+ * action file. Requests are built from the loaded user and object tables and
+ * decided with the same calls as abac_file_permission(), so the result
+ * excludes the syscall, the VFS and the path lookup. Requests are generated a
+ * chunk at a time and only deciding a chunk is timed.
+ *
+ * BENCH decides every (user, object, operation) combination once, users
+ * varying fastest. BENCH <n> decides n requests drawn uniformly at random.
+ */
+#define BENCH_CHUNK 1024
+
+struct bench_req {
+	unsigned int uid;
+	char *path;
+	enum operation op;
+};
+
+struct bench_result {
+	const char *engine;
+	int sampled;
+	u64 decisions;
+	u64 allowed;
+	u64 ns;
+};
+
+/* Serializes runs and guards the result of the last completed run */
+static DEFINE_MUTEX(bench_lock);
+static struct bench_result last_result;
+
+static int bench_decide(struct bench_req *r) {
+	/* Decide like abac_file_permission(), returns 1 if allowed. Rule hits
+	 * are not counted while the benchmark runs so its requests do not
+	 * reorder the rule lists */
+	return engine_decide(r->uid, r->path, r->op);
+}
+
+int run_self_bench(const char *arg) {
+	/* Run a benchmark, @arg is the text following BENCH in the action.
+	 * Called with the loads serialized, so the engine and the paths stay */
+	struct bench_req *reqs;
+	unsigned int *uids, n_uids, n_objs, u, o, op, i, n;
+	char **paths;
+	u64 total, done, allowed, ns, start;
+	int sampled, ret;
+
+	arg = skip_spaces(arg);
+	sampled = *arg != '\0';
+	if (sampled && (kstrtou64(arg, 10, &total) || total == 0)) {
+		return -EINVAL;
+	}
+
+	mutex_lock(&bench_lock);
+	uids = get_uids(&n_uids);
+	paths = get_engine()->get_obj_paths(&n_objs);
+	reqs = kmalloc_array(BENCH_CHUNK, sizeof(struct bench_req), GFP_KERNEL);
+	ret = 0;
+	if (n_uids == 0 || n_objs == 0) {
+		ret = -ENODATA;
+	} else if (!uids || !paths || !reqs) {
+		ret = -ENOMEM;
+	}
+	if (ret) {
+		goto out;
+	}
+	if (!sampled) {
+		total = (u64)n_uids * n_objs * 2;
+	}
+
+	u = o = op = 0;
+	done = allowed = ns = 0;
+	pause_rule_hits(1);
+	while (done < total) {
+		n = min_t(u64, total - done, BENCH_CHUNK);
+		for (i = 0; i < n; i++) {
+			if (sampled) {
+				reqs[i].uid = uids[prandom_u32_max(n_uids)];
+				reqs[i].path = paths[prandom_u32_max(n_objs)];
+				reqs[i].op = prandom_u32_max(2) ? ABAC_MODIFY : ABAC_READ;
+				continue;
+			}
+			reqs[i].uid = uids[u];
+			reqs[i].path = paths[o];
+			reqs[i].op = op ? ABAC_MODIFY : ABAC_READ;
+			if (++u == n_uids) {
+				u = 0;
+				if (++o == n_objs) {
+					o = 0;
+					op++;
+				}
+			}
+		}
+		start = ktime_get_ns();
+		for (i = 0; i < n; i++) {
+			allowed += bench_decide(&reqs[i]);
+		}
+		ns += ktime_get_ns() - start;
+		done += n;
+		/* A full sweep of a large policy takes a while, let it be killed */
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			goto out;
+		}
+		cond_resched();
+	}
+
+	last_result.engine = get_engine()->name;
+	last_result.sampled = sampled;
+	last_result.decisions = done;
+	last_result.allowed = allowed;
+	last_result.ns = ns;
+	printk("ABAC LSM: Benchmark decided %llu requests (%llu allowed) in %llu ns",
+	       done, allowed, ns);
+out:
+	pause_rule_hits(0);
+	kfree(reqs);
+	kvfree(paths);
+	kvfree(uids);
+	mutex_unlock(&bench_lock);
+	return ret;
+}
+
+void show_self_bench(struct seq_file *m) {
+	/*
+	 * Result of the last completed run, empty before the first one
+	 * engine:<name>, mode:<sweep|sample>
+	 * decisions:<n>, allowed:<n>, denied:<n>, total_ns:<ns>
+	 * ns_per_decision:<ns with two decimals>
+	 * decisions_per_sec:<n>
+	 */
+	struct bench_result r;
+	u64 centi_ns;
+
+	mutex_lock(&bench_lock);
+	r = last_result;
+	mutex_unlock(&bench_lock);
+	if (r.decisions == 0) {
+		return;
+	}
+	centi_ns = div64_u64(r.ns * 100, r.decisions);
+	seq_printf(m, "engine:%s\n", r.engine);
+	seq_printf(m, "mode:%s\n", r.sampled ? "sample" : "sweep");
+	seq_printf(m, "decisions:%llu\n", r.decisions);
+	seq_printf(m, "allowed:%llu\n", r.allowed);
+	seq_printf(m, "denied:%llu\n", r.decisions - r.allowed);
+	seq_printf(m, "total_ns:%llu\n", r.ns);
+	seq_printf(m, "ns_per_decision:%llu.%02llu\n", centi_ns / 100, centi_ns % 100);
+	seq_printf(m, "decisions_per_sec:%llu\n",
+		   r.ns ? mul_u64_u64_div_u64(r.decisions, NSEC_PER_SEC, r.ns) : 0);
+}
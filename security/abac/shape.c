@@ -0,0 +1,25 @@
+#include <linux/kernel.h>
+#include "shape.h"
+
+/*
+ * Print one metric of the shape report:
+ * <metric>:total:<values>
+ * <metric>:sum:<sum of the values>
+ * <metric>:max:<largest value>
+ * <metric>:<slot lower bound>:<count>, one line per non-empty slot
+ */
+void show_shape_hist(struct seq_file *m, const char *name, const struct shape_hist *h) {
+	u64 lower;
+	int i;
+
+	seq_printf(m, "%s:total:%llu\n", name, h->n);
+	seq_printf(m, "%s:sum:%llu\n", name, h->sum);
+	seq_printf(m, "%s:max:%llu\n", name, h->max);
+	for (i = 0; i < SHAPE_SLOTS; i++) {
+		if (!h->slot[i]) {
+			continue;
+		}
+		lower = i < SHAPE_LINEAR ? i : 1ULL << (i - SHAPE_LINEAR + 4);
+		seq_printf(m, "%s:%llu:%llu\n", name, lower, h->slot[i]);
+	}
+}
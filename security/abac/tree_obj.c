@@ -0,0 +1,489 @@
+#include "trees.h"
+#include "path_trie.h"
+#include "shape.h"
+#include <linux/limits.h>
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/list.h>
+
+/*
+ * Objects are compiled lazily. Loading the obj_attr file only splits each
+ * line into its path and its serialized tree; both stay inside the securityfs
+ * buffer that holds the file. The tree of an object is built the first time
+ * the object is looked up and published with cmpxchg(), so concurrent first
+ * accesses agree on a single tree.
+ *
+ * Objects are found through a trie of their path components, see
+ * path_trie.c, and kept in obj_attr_list for the walks over every object.
+ * Like in rule_obj.c, the tree of an entry also decides the paths below it
+ * that have no entry of their own.
+ */
+struct obj_hnode {
+	char *path;
+	char *raw;
+	struct node *root;
+	struct hlist_node node;
+};
+
+static struct path_trie obj_attr_trie;
+static HLIST_HEAD(obj_attr_list);
+
+static int copy_field(char *dst, const char *src) {
+	/* The strings of a node must fit its MAX_STR buffers */
+	if (src == NULL || strlen(src) >= MAX_STR) {
+		return -EINVAL;
+	}
+	strcpy(dst, src);
+	return 0;
+}
+
+static int parse_int_field(const char *token, int *res) {
+	return token == NULL ? -EINVAL : kstrtoint(token, 10, res);
+}
+
+static int parse_node(char *str, int is_root, node_cont *n) {
+	/* Parse a single node into @n. Returns -EINVAL if a field is missing
+	 * or malformed */
+	char *token;
+
+	memset(n, 0, sizeof(*n));
+	token = strsep(&str, " ");
+	if (parse_int_field(token, &(n->nid))) {
+		return -EINVAL;
+	}
+	if (is_root == 1) {
+		// if the node is root, only the first and last fields have data
+		n->pid = -1;
+		n->value_id = -1;
+		strcpy(n->value, "-");
+		token = strsep(&str, " ");
+		token = strsep(&str, " ");
+	} else {
+		// pid
+		token = strsep(&str, " ");
+		if (parse_int_field(token, &(n->pid))) {
+			return -EINVAL;
+		}
+		// value
+		token = strsep(&str, " ");
+		if (avp_encoded ? parse_int_field(token, &(n->value_id)) : copy_field(n->value, token)) {
+			return -EINVAL;
+		}
+	}
+	// attribute, or the operation of a leaf
+	if (str == NULL) {
+		return -EINVAL;
+	}
+	if (strcmp(str, "MODIFY") == 0) {
+		n->attr_id = -1;
+		n->op = ABAC_MODIFY;
+	} else if (strcmp(str, "READ") == 0) {
+		n->attr_id = -1;
+		n->op = ABAC_READ;
+	} else if (avp_encoded ? parse_int_field(str, &(n->attr_id)) : copy_field(n->attr, str)) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int parse_node_count(char **line, int *n) {
+	/* Number of nodes at the head of a tree record */
+	if (parse_int_field(strsep(line, "|"), n) || *n <= 0) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int node_in_range(node_cont *nc, int n) {
+	/* Node 0 is the root, every other node hangs below a node of the tree */
+	return nc->nid > 0 && nc->nid < n && nc->pid >= 0 && nc->pid < n;
+}
+
+static struct node *new_node(node_cont *nc) {
+	/* Encoded nodes are allocated without the attribute string */
+	struct node *n = kzalloc(avp_encoded ? NODE_ENC_SIZE : sizeof(struct node), GFP_KERNEL);
+	if (!n) {
+		return NULL;
+	}
+	n->op = nc->op;
+	if (avp_encoded) {
+		n->attr_id = nc->attr_id;
+	} else {
+		strcpy(n->attr, nc->attr);
+	}
+	return n;
+}
+
+static branch *new_branch(node_cont *nc) {
+	branch *b = kzalloc(avp_encoded ? BRANCH_ENC_SIZE : sizeof(branch), GFP_KERNEL);
+	if (!b) {
+		return NULL;
+	}
+	if (avp_encoded) {
+		b->value_id = nc->value_id;
+	} else {
+		strcpy(b->value, nc->value);
+	}
+	return b;
+}
+
+static int check_tree(const char *raw) {
+	/*
+	 * Validate the serialized tree of an object when it is loaded: the node
+	 * count, a root with id 0, and for every other node an id in range that
+	 * was not used before and a parent created before it. parse_tree() can
+	 * then only fail to allocate.
+	 */
+	node_cont nc;
+	char *copy, *line, *node_str;
+	u8 *seen = NULL;
+	int n, err = -EINVAL;
+
+	copy = kstrdup(raw, GFP_KERNEL);
+	if (!copy) {
+		return -ENOMEM;
+	}
+	line = copy;
+	if (parse_node_count(&line, &n)) {
+		goto out;
+	}
+	seen = kcalloc(n, sizeof(u8), GFP_KERNEL);
+	if (!seen) {
+		err = -ENOMEM;
+		goto out;
+	}
+	if (parse_node(strsep(&line, "|"), 1, &nc) || nc.nid != 0) {
+		goto out;
+	}
+	seen[0] = 1;
+	while((node_str = strsep(&line, "|")) != NULL) {
+		if (parse_node(node_str, 0, &nc) || !node_in_range(&nc, n) ||
+		    seen[nc.nid] || !seen[nc.pid]) {
+			goto out;
+		}
+		seen[nc.nid] = 1;
+	}
+	err = 0;
+out:
+	kfree(seen);
+	kfree(copy);
+	return err;
+}
+
+static void clear_attr_tree(struct node *root) {
+	branch *b, *to_free;
+	if (root == NULL) {
+		return ;
+	}
+	b = root->head;
+	while (b != NULL) {
+		clear_attr_tree(b->child);
+		to_free = b;
+		b = b->next;
+		kfree(to_free);
+	}
+	kfree(root);
+}
+
+static struct node *parse_tree(char *line) {
+	/* Parse the serialized tree of a single object. Returns NULL if the
+	 * record is malformed or memory runs out */
+	node_cont nc;
+	struct node *root = NULL, *child, **nodes;
+	branch *b;
+	char *node_str;
+	int n;
+
+	// extract number of nodes and create nodes array
+	if (parse_node_count(&line, &n)) {
+		return NULL;
+	}
+	nodes = kcalloc(n, sizeof(struct node*), GFP_KERNEL);
+	if (!nodes) {
+		return NULL;
+	}
+
+	// extract the root node
+	if (parse_node(strsep(&line, "|"), 1, &nc) || nc.nid != 0) {
+		goto out;
+	}
+	root = new_node(&nc);
+	if (!root) {
+		goto out;
+	}
+	nodes[0] = root;
+
+	// iterate over the remaining nodes and build the complete tree
+	while((node_str = strsep(&line, "|")) != NULL) {
+		if (parse_node(node_str, 0, &nc) || !node_in_range(&nc, n) ||
+		    nodes[nc.nid] || !nodes[nc.pid]) {
+			goto fail;
+		}
+		// create new child node
+		child = new_node(&nc);
+		// Add this node as a new branch to the parent node
+		b = new_branch(&nc);
+		if (!child || !b) {
+			kfree(child);
+			kfree(b);
+			goto fail;
+		}
+		nodes[nc.nid] = child;
+		b->child = child;
+		b->next = nodes[nc.pid]->head;
+		nodes[nc.pid]->head = b;
+	}
+	goto out;
+fail:
+	/* Every node created so far hangs below the root */
+	clear_attr_tree(root);
+	root = NULL;
+out:
+	kfree(nodes);
+	return root;
+}
+
+static struct node *compile_obj(struct obj_hnode *o) {
+	/* Build the tree of an object from its raw record on first access */
+	struct node *root, *cur;
+	char *raw;
+
+	root = smp_load_acquire(&o->root);
+	if (root != NULL || o->raw == NULL) {
+		return root;
+	}
+	/* strsep() writes into its input and other CPUs may be compiling the
+	 * same record, so parse a private copy */
+	raw = kstrdup(o->raw, GFP_KERNEL);
+	if (!raw) {
+		return NULL;
+	}
+	root = parse_tree(raw);
+	kfree(raw);
+	if (root == NULL) {
+		/* Records are checked when loaded, so this is an allocation
+		 * failure. The object is denied and compiled again next time */
+		return NULL;
+	}
+	cur = cmpxchg(&o->root, NULL, root);
+	if (cur != NULL) {
+		/* Another CPU published first, use its tree */
+		clear_attr_tree(root);
+		root = cur;
+	}
+	return root;
+}
+
+/* Used by abac securityfs for parsing the obj_attr file
+ * Iterate over the entire file and index the serialized tree of each object.
+ * @data must stay allocated until clear_obj_attrs() is called */
+void parse_obj_attr(char *data) {
+	struct path_trie_node *t;
+	struct obj_hnode *o;
+	char *line, *path, *c;
+	unsigned int n = 0, lines = 0;
+
+	/* The trie gets a bucket per line */
+	for (c = data; (c = strchr(c, '\n')) != NULL; c++) {
+		lines++;
+	}
+	INIT_HLIST_HEAD(&obj_attr_list);
+	if (path_trie_init(&obj_attr_trie, lines)) {
+		printk(KERN_ERR "ABAC LSM: Out of memory for the trie of %u objects", lines);
+		return;
+	}
+
+	while((line = strsep(&data, "\n")) != NULL) {
+		/* Ignore empty lines */
+		if (strlen(line) < 2) {
+			break;
+		}
+		path = strsep(&line, ":");
+		if (line == NULL || check_tree(line)) {
+			printk(KERN_ERR "ABAC LSM: Skipping the invalid tree of %s", path);
+			continue;
+		}
+		/* add new object to the trie */
+		o = kcalloc(1, sizeof(struct obj_hnode), GFP_KERNEL);
+		if (!o) {
+			printk(KERN_ERR "ABAC LSM: Out of memory while indexing objects");
+			break;
+		}
+		o->path = path;
+		o->raw = line;
+		t = path_trie_insert(&obj_attr_trie, o->path);
+		if (t != NULL) {
+			t->obj = o;
+		}
+		hlist_add_head(&(o->node), &obj_attr_list);
+		n++;
+	}
+	printk("Indexed %u objects", n);
+}
+
+struct node *get_obj_tree(char *path) {
+	/* Get object attributes tree mapped to a path or to its nearest ancestor */
+	struct obj_hnode *o = path_trie_lookup_prefix(&obj_attr_trie, path);
+	return o ? compile_obj(o) : NULL;
+}
+
+struct node *get_obj_tree_dentry(struct dentry *dentry) {
+	/* Same as get_obj_tree() without building the path of @dentry */
+	struct obj_hnode *o = path_trie_lookup_dentry(&obj_attr_trie, dentry, 1);
+	return o ? compile_obj(o) : NULL;
+}
+
+char **get_tree_obj_paths(unsigned int *n) {
+	/* Copy the paths of the loaded objects into an array that the caller
+	 * frees with kvfree(). The paths point into the securityfs buffer of the
+	 * obj_attr file, so they are only valid until it is written again.
+	 * Returns NULL with *n set to 0 if no object is loaded */
+	struct obj_hnode *cur;
+	char **paths;
+	unsigned int i;
+
+	*n = 0;
+	hlist_for_each_entry(cur, &obj_attr_list, node) {
+		(*n)++;
+	}
+	paths = NULL;
+	if (*n != 0) {
+		paths = kvmalloc_array(*n, sizeof(char *), GFP_KERNEL);
+	}
+	if (paths) {
+		i = 0;
+		hlist_for_each_entry(cur, &obj_attr_list, node) {
+			paths[i++] = cur->path;
+		}
+	}
+	return paths;
+}
+
+void clear_obj_attrs(void) {
+	struct obj_hnode *cur;
+	struct hlist_node *tmp;
+	printk("clearing object table...");
+	hlist_for_each_entry_safe(cur, tmp, &obj_attr_list, node) {
+		clear_attr_tree(cur->root);
+		hlist_del_init(&(cur->node));
+		kfree(cur);
+	}
+	path_trie_clear(&obj_attr_trie);
+}
+
+
+void print_attr_tree(struct node *root) {
+	branch *cursor;
+
+	if (root == NULL) {
+		return ;
+	}
+	cursor = NULL;
+	if (avp_encoded ? root->attr_id == -1 : root->attr[0] == '\0') {
+		/* If leaf node, print operation */
+		if (root->op == ABAC_MODIFY) {
+			printk("MODIFY\n");
+		} else {
+			printk("READ\n");
+		}
+	} else if (avp_encoded) {
+		printk("[%d]", root->attr_id);
+	} else {
+		printk("[%s]", root->attr);
+	}
+	cursor = root->head;
+	while (cursor != NULL) {
+		if (avp_encoded) {
+			printk("%d", cursor->value_id);
+		} else {
+			printk("%s", cursor->value);
+		}
+		print_attr_tree(cursor->child);
+		cursor = cursor->next;
+	}
+}
+
+void print_obj_attrs() {
+	struct obj_hnode *cur;
+	printk("Printing object table...");
+	hlist_for_each_entry(cur, &obj_attr_list, node) {
+		printk("Path : %s", cur->path);
+		if (cur->root == NULL) {
+			printk("(not compiled) %s", cur->raw);
+			continue;
+		}
+		print_attr_tree(cur->root);
+	}
+}
+
+static void tree_mem_stats(struct node *root, struct abac_mem_stats *s) {
+	branch *b;
+	if (root == NULL) {
+		return ;
+	}
+	mem_account(s, ABAC_MEM_TREE_NODES, root);
+	for (b = root->head; b != NULL; b = b->next) {
+		mem_account(s, ABAC_MEM_BRANCHES, b);
+		tree_mem_stats(b->child, s);
+	}
+}
+
+void tree_obj_mem_stats(struct abac_mem_stats *s) {
+	struct obj_hnode *cur;
+	hlist_for_each_entry(cur, &obj_attr_list, node) {
+		mem_account(s, ABAC_MEM_OBJECTS, cur);
+		tree_mem_stats(smp_load_acquire(&cur->root), s);
+	}
+	path_trie_mem_stats(&obj_attr_trie, s);
+}
+
+static unsigned int tree_shape(struct node *root, struct shape_hist *fanout) {
+	/* Add the fanout of every inner node to @fanout and return the depth */
+	branch *b;
+	unsigned int n = 0, d, depth = 0;
+	if (root == NULL) {
+		return 0;
+	}
+	for (b = root->head; b != NULL; b = b->next) {
+		n++;
+		d = tree_shape(b->child, fanout) + 1;
+		if (d > depth) {
+			depth = d;
+		}
+	}
+	if (n) {
+		shape_add(fanout, n);
+	}
+	return depth;
+}
+
+void show_tree_obj_shape(struct seq_file *m) {
+	/* Chain length of every bucket of the trie edges and the size of every
+	 * tree. Node counts are read from the raw records, so they include objects
+	 * that were never accessed. Depth (branches from the root to the deepest
+	 * leaf) and fanout are only known for compiled trees */
+	struct shape_hist *h;
+	struct obj_hnode *cur;
+	unsigned nodes;
+
+	h = kcalloc(4, sizeof(struct shape_hist), GFP_KERNEL);
+	if (!h) {
+		return;
+	}
+	path_trie_chains(&obj_attr_trie, &h[0]);
+	hlist_for_each_entry(cur, &obj_attr_list, node) {
+		if (cur->raw != NULL && sscanf(cur->raw, "%u|", &nodes) == 1) {
+			shape_add(&h[1], nodes);
+		}
+		if (smp_load_acquire(&cur->root) != NULL) {
+			shape_add(&h[2], tree_shape(cur->root, &h[3]));
+		}
+	}
+	show_shape_hist(m, "obj_chain", &h[0]);
+	show_shape_hist(m, "tree_nodes", &h[1]);
+	show_shape_hist(m, "tree_depth", &h[2]);
+	show_shape_hist(m, "tree_fanout", &h[3]);
+	kfree(h);
+}
@@ -0,0 +1,155 @@
+#include <linux/string.h>
+#include "abacfs.h"
+#include "engine.h"
+#include "trees.h"
+
+/*
+ * Tree engines. Each object has a PolTree compiled from the policy, a request
+ * is allowed if following the branches of the user and environment attribute
+ * values leads to a leaf with a matching operation. trees and trees_enc share
+ * the object table and only differ in how attributes and values are compared.
+ */
+
+static __always_inline int attr_match(avp *a, struct node *n, const int encoded) {
+	if (encoded) {
+		return a->name_id == n->attr_id;
+	}
+	return strcmp(a->name, n->attr) == 0;
+}
+
+static __always_inline int value_match(avp *a, branch *b, const int encoded) {
+	if (encoded) {
+		return a->value_id == b->value_id;
+	}
+	return strcmp(a->value, b->value) == 0;
+}
+
+static __always_inline struct node *__get_child(avp *user_attrs, struct node *n, const int encoded) {
+	/*
+	 * Find the child node corresponding to the value of user or environmental attribute
+	 */
+	struct avp *u, *e;
+	branch *b; 
+	u = user_attrs;
+	e = env_attr;
+	while (u != NULL) {
+		if (attr_match(u, n, encoded)) {
+			/* If the node's attribute is found in user attributes,
+			 * look for corresponding branch in the node */
+			b = n->head;
+			while (b != NULL) {
+				if (value_match(u, b, encoded)) {
+					return b->child;
+				}
+				b = b->next;
+			}
+		}
+		u = u->next;
+	}
+	/* Check environmental attributes (similar to checking user attributes) */
+	while (e != NULL) {
+		if (attr_match(e, n, encoded)) {
+			b = n->head;
+			while (b != NULL) {
+				if (value_match(e, b, encoded)) {
+					return b->child;
+				}
+				b = b->next;
+			}
+		}
+		e = e->next;
+	}
+	// branch not found
+	return NULL;
+}
+
+static __always_inline int __resolve_tree(avp *user_attr, struct node *n, enum operation op,
+					  const int encoded) {
+	/* Resolve access request using 
+	 * 1. User attributes (*user_attr)
+	 * 2. Root of the object attribute tree (struct node *n)
+	 * 3. Current environmental attributes (avp *env_attr -> from abacfs)
+	 * 4. Access operation (READ or MODIFY)
+	 *
+	 * Returns 0 if decision is allowed, 1 otherwise
+	 */
+	if (user_attr == NULL) {
+		/* If the user doesn't have any attributes, access is DENIED */
+		return 1;
+	}
+	if (n == NULL) {
+		/* If the object doesn't have any attribute, access is DENIED */
+		return 1;
+	}
+	if (op == ABAC_IGNORE) {
+		/* If not a relevant operation, allow it */
+		return 0;
+	}
+	// Walk down the tree until a leaf or a missing branch
+	while (encoded ? n->attr_id != -1 : n->attr[0] != '\0') {
+		n = __get_child(user_attr, n, encoded);
+		if (!n) {
+			/* Corresponding child not found */
+			return 1;
+		}
+	}
+	/* n is a leaf, so check only operation */
+	if (n->op == op) {
+		return 0;
+	} else if (n->op == ABAC_MODIFY && op == ABAC_READ) {
+		/* If the rule says MODIFY, then the user also has READ rights */
+		return 0;
+	}
+	return 1;
+}
+
+int resolve_tree(avp *user_attr, struct node *obj_root, enum operation op) {
+	if (avp_encoded) {
+		return __resolve_tree(user_attr, obj_root, op, 1);
+	}
+	return __resolve_tree(user_attr, obj_root, op, 0);
+}
+
+static int resolve_str(avp *user_attr, void *obj, enum operation op) {
+	return __resolve_tree(user_attr, obj, op, 0) == 0;
+}
+
+static int resolve_enc(avp *user_attr, void *obj, enum operation op) {
+	return __resolve_tree(user_attr, obj, op, 1) == 0;
+}
+
+static void *lookup(char *path) {
+	return get_obj_tree(path);
+}
+
+static void *lookup_dentry(struct dentry *dentry) {
+	return get_obj_tree_dentry(dentry);
+}
+
+const struct abac_engine trees_engine = {
+	.name = "trees",
+	.encoded = 0,
+	.obj_file = "obj_attr",
+	.load_objects = parse_obj_attr,
+	.clear_objects = clear_obj_attrs,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_str,
+	.get_obj_paths = get_tree_obj_paths,
+	.mem_stats = tree_obj_mem_stats,
+	.show_shape = show_tree_obj_shape,
+};
+
+const struct abac_engine trees_enc_engine = {
+	.name = "trees_enc",
+	.encoded = 1,
+	.obj_file = "obj_attr",
+	.load_objects = parse_obj_attr,
+	.clear_objects = clear_obj_attrs,
+	.lookup = lookup,
+	.lookup_dentry = lookup_dentry,
+	.resolve = resolve_enc,
+	.get_obj_paths = get_tree_obj_paths,
+	.mem_stats = tree_obj_mem_stats,
+	.show_shape = show_tree_obj_shape,
+};
@@ -0,0 +1,235 @@
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/hashtable.h>
+#include "shape.h"
+#include "user.h"
+
+struct user_hnode {
+	unsigned int uid;
+	struct avp *attrs;
+	struct hlist_node node;
+};
+
+struct abac_user {
+	unsigned int uid;
+	struct avp *attrs;
+};
+
+#define USER_BUCKETS 8 // (2 ^ 8 = 256 buckets)
+
+DECLARE_HASHTABLE(user_attr_map, USER_BUCKETS);
+
+/*
+ * Number of users holding each name=value pair. Used by the policy compiler
+ * to estimate how selective a user predicate is.
+ */
+struct avp_freq_hnode {
+	avp *pair;
+	unsigned int users;
+	struct hlist_node node;
+};
+
+#define AVP_FREQ_BUCKETS 8
+
+DECLARE_HASHTABLE(avp_freq_map, AVP_FREQ_BUCKETS);
+static unsigned int user_count = 0;
+static unsigned int user_avp_count = 0;
+
+static void count_user_avps(avp *attrs) {
+	/* Add the pairs of one user to the frequency table */
+	struct avp_freq_hnode *cur;
+	u32 key;
+	int found;
+
+	while (attrs != NULL) {
+		key = avp_hash(attrs);
+		found = 0;
+		hash_for_each_possible(avp_freq_map, cur, node, key) {
+			if (avp_equal(cur->pair, attrs)) {
+				cur->users++;
+				found = 1;
+				break;
+			}
+		}
+		if (!found) {
+			cur = kcalloc(1, sizeof(struct avp_freq_hnode), GFP_KERNEL);
+			cur->pair = attrs;
+			cur->users = 1;
+			hash_add(avp_freq_map, &(cur->node), key);
+		}
+		user_avp_count++;
+		attrs = attrs->next;
+	}
+}
+
+static struct abac_user *parse_line(char *line) {
+	/* Parse a single line in the file */
+	struct abac_user *usr;
+	char *uid_str;
+
+	usr = kcalloc(1, sizeof(struct abac_user), GFP_KERNEL);
+	uid_str = strsep(&line, ":");
+	kstrtoint(uid_str, 10, &(usr->uid));
+	usr->attrs = parse_avp(line);
+	return usr;
+}
+
+void parse_user_attr(char *data) {
+	/*
+	 * Parse user attributes file
+	 * Buffer format 
+	 * <user-id1>:<attr-name1>=<attr-value1>,<attr-name2>=<attr-value2> 
+	 * <user-id2>:<attr-name3>=<attr-value3>,<attr-name4>=<attr-value4> 
+	 */
+
+	struct abac_user *temp;
+	struct user_hnode *u;
+	char *line;
+
+	hash_init(user_attr_map);
+	hash_init(avp_freq_map);
+	user_count = 0;
+	user_avp_count = 0;
+
+	while((line = strsep(&data, "\n")) != NULL) {
+		/* Ignore empty lines */
+		if (strlen(line) < 2) {
+			break;
+		}
+		temp = parse_line(line);
+		/* add new user to hash table */
+		u = kcalloc(1, sizeof(struct user_hnode), GFP_KERNEL);
+		u->uid = temp->uid;
+		u->attrs = temp->attrs;
+		hash_add(user_attr_map, &(u->node), u->uid);
+		count_user_avps(u->attrs);
+		user_count++;
+		printk("Added %u to hashtable", u->uid);
+	}
+}
+
+unsigned int get_avp_user_count(avp *a) {
+	/* Number of users that hold the pair @a */
+	struct avp_freq_hnode *cur;
+	hash_for_each_possible(avp_freq_map, cur, node, avp_hash(a)) {
+		if (avp_equal(cur->pair, a)) {
+			return cur->users;
+		}
+	}
+	return 0;
+}
+
+unsigned int get_user_count(void) {
+	return user_count;
+}
+
+unsigned int get_avg_user_attrs(void) {
+	/* Average number of attributes per user, rounded up */
+	if (user_count == 0) {
+		return 0;
+	}
+	return (user_avp_count + user_count - 1) / user_count;
+}
+
+avp *get_user_attrs(unsigned int uid) {
+	/* Get user attributes mapped to a UID */
+	struct user_hnode *cur;
+	avp *attrs = NULL;
+	hash_for_each_possible(user_attr_map, cur, node, uid) {
+		if (cur->uid == uid) {
+			attrs = cur->attrs;
+			break;
+		}
+	}
+	return attrs;
+}
+
+unsigned int *get_uids(unsigned int *n) {
+	/* Copy the uids of the loaded users into an array that the caller frees
+	 * with kvfree(). Returns NULL with *n set to 0 if no user is loaded */
+	struct user_hnode *cur;
+	unsigned int *uids, i;
+	unsigned bkt;
+
+	*n = 0;
+	hash_for_each(user_attr_map, bkt, cur, node) {
+		(*n)++;
+	}
+	if (*n == 0) {
+		return NULL;
+	}
+	uids = kvmalloc_array(*n, sizeof(unsigned int), GFP_KERNEL);
+	if (!uids) {
+		return NULL;
+	}
+	i = 0;
+	hash_for_each(user_attr_map, bkt, cur, node) {
+		uids[i++] = cur->uid;
+	}
+	return uids;
+}
+
+void clear_user_attrs() {
+	// Clear the user attributes in hash table
+	struct user_hnode *cur;
+	struct avp_freq_hnode *freq;
+	struct hlist_node *tmp;
+	unsigned bkt;
+	printk("clearing user hashtable...");
+	hash_for_each_safe(avp_freq_map, bkt, tmp, freq, node) {
+		hash_del(&(freq->node));
+		kfree(freq);
+	}
+	user_count = 0;
+	user_avp_count = 0;
+    hash_for_each(user_attr_map, bkt, cur, node) {
+		clear_avp_list(cur->attrs);
+		hash_del(&(cur->node));
+    }
+}
+
+void print_user_attrs() {
+	struct user_hnode *cur;
+	unsigned bkt;
+	printk("Printing user hashtable...");
+    hash_for_each(user_attr_map, bkt, cur, node) {
+		printk("UID = %u", cur->uid);
+		print_avp(cur->attrs);
+    }
+}
+
+void user_mem_stats(struct abac_mem_stats *s) {
+	struct user_hnode *cur;
+	struct avp_freq_hnode *freq;
+	unsigned bkt;
+    hash_for_each(user_attr_map, bkt, cur, node) {
+		mem_account(s, ABAC_MEM_USERS, cur);
+		avp_list_mem_stats(cur->attrs, s);
+    }
+	hash_for_each(avp_freq_map, bkt, freq, node) {
+		mem_account(s, ABAC_MEM_USERS, freq);
+	}
+}
+
+void show_user_shape(struct seq_file *m) {
+	/* Chain length of every bucket of the user table */
+	struct shape_hist *chains;
+	struct user_hnode *cur;
+	unsigned bkt, n;
+
+	chains = kzalloc(sizeof(struct shape_hist), GFP_KERNEL);
+	if (!chains) {
+		return;
+	}
+	for (bkt = 0; bkt < HASH_SIZE(user_attr_map); bkt++) {
+		n = 0;
+		hlist_for_each_entry(cur, &user_attr_map[bkt], node) {
+			n++;
+		}
+		shape_add(chains, n);
+	}
+	show_shape_hist(m, "user_chain", chains);
+	kfree(chains);
+}
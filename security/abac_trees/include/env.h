@@ -1,8 +0,0 @@
-#ifndef _ABAC_ENV_H
-#define _ABAC_ENV_H
-#include "avp.h"
-
-avp *parse_env_attr(char *);
-void print_env_attrs(avp *);
-
-#endif /* _ABAC_ENV_H */
@@ -0,0 +1,257 @@
+/*
+ * Decision microbenchmark of the engines
+ *
+ * For each selected engine and each perf_eval/data/<config> directory given, loads
+ * the dataset of the engine and times a fixed sequence of random requests. Users are
+ * drawn from user_attr and objects from the object file of the engine, so every
+ * request reaches the policy. The sequence only depends on the seed and the dataset,
+ * which lets the engines be compared on the same requests.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "abac_engine.h"
+
+/* Engines benchmarked without -e */
+static char all_engines[] = "rules,rules_enc,trees,trees_enc,adaptive,adaptive_enc,mdd,mdd_enc,index,index_enc";
+
+/* Print the shape report of each dataset after the timed rounds */
+static int show_shape;
+
+struct request {
+	unsigned int uid;
+	const char *path;
+	enum abac_engine_op op;
+};
+
+struct dataset {
+	char *user_buf;
+	char *obj_buf;
+	unsigned int *uids;
+	char **paths;
+	size_t nusers;
+	size_t nobjs;
+};
+
+static void die(const char *msg)
+{
+	fprintf(stderr, "%s\n", msg);
+	exit(1);
+}
+
+static void *xmalloc(size_t size)
+{
+	void *p = malloc(size ? size : 1);
+
+	if (!p)
+		die("out of memory");
+	return p;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+static char *read_file(const char *dir, const char *name)
+{
+	char fname[4096];
+	FILE *f;
+	char *buf;
+	long len;
+
+	snprintf(fname, sizeof(fname), "%s/%s", dir, name);
+	f = fopen(fname, "r");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", fname, strerror(errno));
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = xmalloc(len + 1);
+	if (fread(buf, 1, len, f) != (size_t)len)
+		die("short read");
+	buf[len] = '\0';
+	fclose(f);
+	return buf;
+}
+
+/* Split <key>:<value> lines in place and return the keys */
+static char **line_keys(char *buf, size_t *n)
+{
+	size_t cap = 1024;
+	char **keys = xmalloc(cap * sizeof(*keys));
+	char *line, *sep;
+
+	*n = 0;
+	while ((line = strsep(&buf, "\n")) != NULL) {
+		sep = strchr(line, ':');
+		if (!sep)
+			continue;
+		*sep = '\0';
+		if (*n == cap) {
+			cap *= 2;
+			keys = realloc(keys, cap * sizeof(*keys));
+			if (!keys)
+				die("out of memory");
+		}
+		keys[(*n)++] = line;
+	}
+	return keys;
+}
+
+static void dataset_load(struct dataset *d, const char *dir)
+{
+	char **keys;
+	size_t i;
+
+	d->user_buf = read_file(dir, "user_attr");
+	keys = line_keys(d->user_buf, &d->nusers);
+	d->uids = xmalloc(d->nusers * sizeof(*d->uids));
+	for (i = 0; i < d->nusers; i++)
+		d->uids[i] = strtoul(keys[i], NULL, 10);
+	free(keys);
+
+	d->obj_buf = read_file(dir, abac_engine_objects());
+	d->paths = line_keys(d->obj_buf, &d->nobjs);
+	if (!d->nusers || !d->nobjs)
+		die("dataset has no users or objects");
+}
+
+static void dataset_free(struct dataset *d)
+{
+	free(d->user_buf);
+	free(d->obj_buf);
+	free(d->uids);
+	free(d->paths);
+}
+
+static struct request *make_requests(const struct dataset *d, size_t n, uint64_t seed)
+{
+	struct request *reqs = xmalloc(n * sizeof(*reqs));
+	uint64_t r;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		r = splitmix64(&seed);
+		reqs[i].uid = d->uids[(r >> 32) % d->nusers];
+		reqs[i].path = d->paths[(uint32_t)r % d->nobjs];
+		reqs[i].op = (splitmix64(&seed) & 1) ? ABAC_ENGINE_MODIFY : ABAC_ENGINE_READ;
+	}
+	return reqs;
+}
+
+static void bench(const char *config_dir, size_t nreqs, unsigned int rounds, uint64_t seed)
+{
+	struct dataset d;
+	struct request *reqs;
+	char dir[4096];
+	uint64_t start, load_ns, best_ns = UINT64_MAX;
+	size_t i, allowed = 0;
+	unsigned int round;
+	int ret;
+
+	snprintf(dir, sizeof(dir), "%s/%s", config_dir, abac_engine_data());
+	start = now_ns();
+	ret = abac_engine_load(dir);
+	load_ns = now_ns() - start;
+	if (ret) {
+		fprintf(stderr, "%s: failed to load %s: %s\n", abac_engine_name(), dir, strerror(-ret));
+		exit(1);
+	}
+
+	dataset_load(&d, dir);
+	reqs = make_requests(&d, nreqs, seed);
+	/* The first pass warms the caches and counts the decisions */
+	for (i = 0; i < nreqs; i++)
+		allowed += abac_engine_decide(reqs[i].uid, reqs[i].path, reqs[i].op);
+	for (round = 0; round < rounds; round++) {
+		start = now_ns();
+		for (i = 0; i < nreqs; i++)
+			abac_engine_decide(reqs[i].uid, reqs[i].path, reqs[i].op);
+		start = now_ns() - start;
+		if (start < best_ns)
+			best_ns = start;
+	}
+
+	printf("%-10s %-24s load %9.2f ms  %8zu users  %9zu objects  %8.1f ns/decision  %5.1f%% allowed  %8.2f MiB\n",
+	       abac_engine_name(), config_dir, load_ns / 1e6, d.nusers, d.nobjs,
+	       (double)best_ns / nreqs, 100.0 * allowed / nreqs, abac_engine_mem_bytes() / 1048576.0);
+	if (show_shape)
+		abac_engine_show_shape(stdout);
+
+	abac_engine_unload();
+	free(reqs);
+	dataset_free(&d);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Invalid usage\n%s [-e engine,...] [-n requests] [-r rounds] [-s seed] [-S] [-v] <data/config>...\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	size_t nreqs = 1000000;
+	unsigned int rounds = 5;
+	uint64_t seed = 1;
+	char *engines = NULL, *engine;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "e:n:r:s:Sv")) != -1) {
+		switch (opt) {
+		case 'e':
+			engines = optarg;
+			break;
+		case 'n':
+			nreqs = strtoull(optarg, NULL, 10);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'S':
+			show_shape = 1;
+			break;
+		case 'v':
+			abac_engine_set_verbose(1);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind == argc || !nreqs || !rounds)
+		usage(argv[0]);
+	if (!engines)
+		engines = all_engines;
+	while ((engine = strsep(&engines, ",")) != NULL) {
+		if (abac_engine_select(engine)) {
+			fprintf(stderr, "Unknown engine %s\n", engine);
+			exit(1);
+		}
+		for (opt = optind; opt < argc; opt++)
+			bench(argv[opt], nreqs, rounds, seed);
+	}
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Glue between abac_engine.h and the engine sources of security/abac
+ *
+ * Loading mirrors the securityfs write handlers in abacfs.c: each file is read into
+ * a buffer that is kept until the next unload, since the parsers may keep pointers
+ * into it. Deciding goes through engine_decide() like the self benchmark.
+ */
+#include <stdio.h>
+#include <linux/kernel.h>
+
+#include "abacfs.h"
+#include "abac_engine.h"
+
+/* Globals of abacfs.c used by the engine sources */
+avp *env_attr = NULL;
+int recording = 0;
+char perf_buf[64];
+u64 prev_access_time = 0;
+
+static const struct {
+	const char *name;
+	const char *data;
+} engine_datasets[] = {
+	{ "rules", "rules/original" },
+	{ "rules_enc", "rules/encoded" },
+	{ "trees", "trees/original" },
+	{ "trees_enc", "trees/encoded" },
+	{ "adaptive", "rules/original" },
+	{ "adaptive_enc", "rules/encoded" },
+	{ "mdd", "rules/original" },
+	{ "mdd_enc", "rules/encoded" },
+	{ "index", "rules/original" },
+	{ "index_enc", "rules/encoded" },
+};
+
+enum abac_file {
+	USER_ATTR,
+	ENV_ATTR,
+	OBJ,
+	POLICY,
+	NR_FILES,
+};
+
+static char *file_buf[NR_FILES];
+
+int abac_engine_select(const char *name)
+{
+	const struct abac_engine *e = find_engine(name);
+
+	if (!e)
+		return -EINVAL;
+	abac_engine_unload();
+	set_engine(e);
+	return 0;
+}
+
+const char *abac_engine_name(void)
+{
+	return get_engine()->name;
+}
+
+const char *abac_engine_data(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(engine_datasets); i++) {
+		if (strcmp(engine_datasets[i].name, abac_engine_name()) == 0)
+			return engine_datasets[i].data;
+	}
+	return NULL;
+}
+
+const char *abac_engine_objects(void)
+{
+	return get_engine()->obj_file;
+}
+
+static int read_file(const char *dir, const char *name, char **buf)
+{
+	char fname[PATH_MAX];
+	FILE *f;
+	long len;
+	int ret = 0;
+
+	snprintf(fname, sizeof(fname), "%s/%s", dir, name);
+	f = fopen(fname, "r");
+	if (!f)
+		return -errno;
+	if (fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+		ret = -errno;
+		goto out;
+	}
+	*buf = kmalloc(len + 1, GFP_KERNEL);
+	if (!*buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	if (fread(*buf, 1, len, f) != (size_t)len) {
+		kfree(*buf);
+		*buf = NULL;
+		ret = -EIO;
+		goto out;
+	}
+	(*buf)[len] = '\0';
+out:
+	fclose(f);
+	return ret;
+}
+
+int abac_engine_load(const char *dir)
+{
+	const struct abac_engine *e = get_engine();
+	int ret;
+
+	abac_engine_unload();
+	ret = read_file(dir, "user_attr", &file_buf[USER_ATTR]);
+	if (ret)
+		return ret;
+	parse_user_attr(file_buf[USER_ATTR]);
+
+	ret = read_file(dir, "env_attr", &file_buf[ENV_ATTR]);
+	if (ret)
+		return ret;
+	env_attr = parse_env_attr(file_buf[ENV_ATTR]);
+
+	ret = read_file(dir, e->obj_file, &file_buf[OBJ]);
+	if (ret)
+		return ret;
+	e->load_objects(file_buf[OBJ]);
+
+	if (e->load_policy) {
+		ret = read_file(dir, "policy", &file_buf[POLICY]);
+		if (ret)
+			return ret;
+		e->load_policy(file_buf[POLICY]);
+	}
+	return 0;
+}
+
+int abac_engine_decide(unsigned int uid, const char *path, enum abac_engine_op op)
+{
+	return engine_decide(uid, (char *)path, op == ABAC_ENGINE_MODIFY ? ABAC_MODIFY : ABAC_READ);
+}
+
+unsigned long long abac_engine_mem_bytes(void)
+{
+	struct abac_mem_stats s = {};
+	unsigned long long bytes = 0;
+	int i;
+
+	user_mem_stats(&s);
+	avp_list_mem_stats(env_attr, &s);
+	get_engine()->mem_stats(&s);
+	for (i = 0; i < NR_FILES; i++)
+		mem_account(&s, ABAC_MEM_BUFFERS, file_buf[i]);
+	for (i = 0; i < ABAC_MEM_TYPES; i++)
+		bytes += s.bytes[i];
+	return bytes;
+}
+
+void abac_engine_show_shape(FILE *f)
+{
+	struct seq_file m = { f };
+
+	show_user_shape(&m);
+	get_engine()->show_shape(&m);
+}
+
+void abac_engine_unload(void)
+{
+	const struct abac_engine *e = get_engine();
+	int i;
+
+	if (file_buf[USER_ATTR])
+		clear_user_attrs();
+	if (file_buf[ENV_ATTR]) {
+		clear_avp_list(env_attr);
+		env_attr = NULL;
+	}
+	if (file_buf[OBJ])
+		e->clear_objects();
+	if (file_buf[POLICY])
+		e->clear_policy();
+	for (i = 0; i < NR_FILES; i++) {
+		kfree(file_buf[i]);
+		file_buf[i] = NULL;
+	}
+}
+
+void abac_engine_set_verbose(int verbose)
+{
+	abac_shim_verbose = verbose;
+}
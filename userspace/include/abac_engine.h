@@ -0,0 +1,49 @@
+#ifndef _LIBABAC_ENGINE_H
+#define _LIBABAC_ENGINE_H
+
+#include <stdio.h>
+
+/*
+ * Userspace front end of the ABAC engines
+ *
+ * libabac.a links the kernel sources of security/abac behind this interface, so a
+ * program linked against it decides requests exactly like the LSM built from the
+ * same sources. Like in the kernel, one engine is active at a time and selecting
+ * another one drops the loaded dataset.
+ */
+
+enum abac_engine_op {
+	ABAC_ENGINE_READ,
+	ABAC_ENGINE_MODIFY,
+};
+
+/* Select the engine called @name, returns 0 or -EINVAL if there is none */
+int abac_engine_select(const char *name);
+/* Name of the selected engine, e.g. "trees_enc" */
+const char *abac_engine_name(void);
+/* Dataset of the engine relative to perf_eval/data/<config>, e.g. "trees/encoded" */
+const char *abac_engine_data(void);
+/* File of the dataset that lists the protected objects, one path per line */
+const char *abac_engine_objects(void);
+
+/*
+ * Load a dataset directory, parsing its files in the order perf_eval/perf.py writes
+ * them to securityfs. Returns 0 on success or a negative errno if a file could not
+ * be read.
+ */
+int abac_engine_load(const char *dir);
+/* Returns 1 if @uid may access @path with @op, 0 otherwise */
+int abac_engine_decide(unsigned int uid, const char *path, enum abac_engine_op op);
+/*
+ * Heap bytes held by the loaded dataset, counted like the securityfs stats file.
+ * Objects are compiled on first access, so this grows while requests are decided.
+ */
+unsigned long long abac_engine_mem_bytes(void);
+/* Write the shape report of the securityfs shape file to @f */
+void abac_engine_show_shape(FILE *f);
+/* Drop the loaded dataset */
+void abac_engine_unload(void);
+/* Print the kernel log messages of the parsers to stderr */
+void abac_engine_set_verbose(int verbose);
+
+#endif /* _LIBABAC_ENGINE_H */
@@ -0,0 +1,32 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "kernel_shim.h"
+
+int abac_shim_verbose;
+seqlock_t rename_lock;
+
+void seq_printf(struct seq_file *m, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vfprintf(m->f, fmt, args);
+	va_end(args);
+}
+
+/* Kernel messages are single lines that often lack the trailing newline */
+int abac_shim_printk(const char *fmt, ...)
+{
+	va_list args;
+	size_t len = strlen(fmt);
+	int ret;
+
+	va_start(args, fmt);
+	ret = vfprintf(stderr, fmt, args);
+	va_end(args);
+	if (len && fmt[len - 1] != '\n')
+		fputc('\n', stderr);
+	return ret;
+}
@@ -0,0 +1,398 @@
+/*
+ * Userspace stand-ins for the kernel interfaces used by the ABAC engines
+ *
+ * Only what the engine sources and user.c, env.c and shape.c need is provided.
+ * Allocation maps to libc, locks to pthreads and atomics to the compiler builtins.
+ * SRCU readers do not block updates, so policies must not be reloaded while
+ * decisions are running, and delayed work never runs. printk() only prints when verbose output was requested with
+ * abac_engine_set_verbose(), the parsers log every entry they load.
+ */
+#ifndef _ABAC_KERNEL_SHIM_H
+#define _ABAC_KERNEL_SHIM_H
+
+#include <errno.h>
+#include <limits.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int32_t s32;
+typedef long long s64;
+typedef unsigned int gfp_t;
+
+#define GFP_KERNEL	0
+#define __percpu
+#define __user
+
+#define KERN_ERR	""
+#define KERN_WARNING	""
+#define KERN_INFO	""
+#define KERN_DEBUG	""
+
+extern int abac_shim_verbose;
+int abac_shim_printk(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+#define printk(fmt, ...) (abac_shim_verbose ? abac_shim_printk(fmt, ##__VA_ARGS__) : 0)
+#define printk_ratelimited printk
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min_t(type, a, b) min((type)(a), (type)(b))
+#define ALIGN(x, a) (((x) + (a) - 1) / (a) * (a))
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+#define SMP_CACHE_BYTES 64
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#define HZ 100
+#define offsetofend(type, member) (offsetof(type, member) + sizeof(((type *)0)->member))
+#ifndef __always_inline
+#define __always_inline inline __attribute__((always_inline))
+#endif
+
+/* slab */
+static inline void *kmalloc(size_t size, gfp_t flags) { return malloc(size); }
+static inline void *kzalloc(size_t size, gfp_t flags) { return calloc(1, size); }
+static inline void *kcalloc(size_t n, size_t size, gfp_t flags) { return calloc(n, size); }
+static inline void *kmalloc_array(size_t n, size_t size, gfp_t flags) { return malloc(n * size); }
+static inline void kfree(const void *p) { free((void *)p); }
+char *strchrnul(const char *s, int c);
+static inline char *kstrdup(const char *s, gfp_t flags) { return s ? strdup(s) : NULL; }
+static inline size_t ksize(const void *p) { return malloc_usable_size((void *)p); }
+static inline void *kvmalloc_array(size_t n, size_t size, gfp_t flags) { return calloc(n, size); }
+static inline void *kvcalloc(size_t n, size_t size, gfp_t flags) { return calloc(n, size); }
+static inline void kvfree(const void *p) { free((void *)p); }
+
+/* kstrto*() accept a single trailing newline and fail on overflow */
+static inline int shim_strtoll(const char *s, unsigned int base, long long *res)
+{
+	char *end;
+
+	errno = 0;
+	*res = strtoll(s, &end, base);
+	if (end == s || errno)
+		return errno == ERANGE ? -ERANGE : -EINVAL;
+	if (*end == '\n')
+		end++;
+	return *end ? -EINVAL : 0;
+}
+
+static inline int shim_strtoull(const char *s, unsigned int base, unsigned long long *res)
+{
+	char *end;
+
+	if (*s == '-')
+		return -EINVAL;
+	errno = 0;
+	*res = strtoull(s, &end, base);
+	if (end == s || errno)
+		return errno == ERANGE ? -ERANGE : -EINVAL;
+	if (*end == '\n')
+		end++;
+	return *end ? -EINVAL : 0;
+}
+
+static inline int kstrtoint(const char *s, unsigned int base, int *res)
+{
+	long long v;
+	int ret = shim_strtoll(s, base, &v);
+
+	if (ret)
+		return ret;
+	if (v < INT_MIN || v > INT_MAX)
+		return -ERANGE;
+	*res = v;
+	return 0;
+}
+
+static inline int kstrtouint(const char *s, unsigned int base, unsigned int *res)
+{
+	unsigned long long v;
+	int ret = shim_strtoull(s, base, &v);
+
+	if (ret)
+		return ret;
+	if (v > UINT_MAX)
+		return -ERANGE;
+	*res = v;
+	return 0;
+}
+
+static inline int kstrtoull(const char *s, unsigned int base, unsigned long long *res)
+{
+	return shim_strtoull(s, base, res);
+}
+
+/* hlist and hashtable, same layout and bucket selection as the kernel */
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+
+struct hlist_head {
+	struct hlist_node *first;
+};
+
+#define HLIST_HEAD(name) struct hlist_head name = { .first = NULL }
+#define INIT_HLIST_HEAD(h) ((h)->first = NULL)
+
+static inline void hlist_add_head(struct hlist_node *n, struct hlist_head *h)
+{
+	struct hlist_node *first = h->first;
+
+	n->next = first;
+	if (first)
+		first->pprev = &n->next;
+	h->first = n;
+	n->pprev = &h->first;
+}
+
+static inline void hlist_del_init(struct hlist_node *n)
+{
+	if (!n->pprev)
+		return;
+	*n->pprev = n->next;
+	if (n->next)
+		n->next->pprev = n->pprev;
+	n->next = NULL;
+	n->pprev = NULL;
+}
+
+#define hlist_entry_safe(ptr, type, member) \
+	({ typeof(ptr) ____ptr = (ptr); ____ptr ? container_of(____ptr, type, member) : NULL; })
+
+#define hlist_for_each_entry(pos, head, member) \
+	for (pos = hlist_entry_safe((head)->first, typeof(*(pos)), member); pos; \
+	     pos = hlist_entry_safe((pos)->member.next, typeof(*(pos)), member))
+
+#define hlist_for_each_entry_safe(pos, n, head, member) \
+	for (pos = hlist_entry_safe((head)->first, typeof(*pos), member); \
+	     pos && ({ n = pos->member.next; 1; }); \
+	     pos = hlist_entry_safe(n, typeof(*pos), member))
+
+#define GOLDEN_RATIO_32 0x61C88647
+#define GOLDEN_RATIO_64 0x61C8864680B583EBull
+
+static inline u32 hash_32(u32 val, unsigned int bits)
+{
+	return (val * GOLDEN_RATIO_32) >> (32 - bits);
+}
+
+static inline u32 hash_64(u64 val, unsigned int bits)
+{
+	return (u32)((val * GOLDEN_RATIO_64) >> (64 - bits));
+}
+
+#define ilog2(n) (63 - __builtin_clzll((unsigned long long)(n)))
+
+#define DEFINE_HASHTABLE(name, bits) struct hlist_head name[1 << (bits)] = { }
+#define DECLARE_HASHTABLE(name, bits) struct hlist_head name[1 << (bits)]
+#define HASH_SIZE(name) (ARRAY_SIZE(name))
+#define HASH_BITS(name) ilog2(HASH_SIZE(name))
+#define hash_min(val, bits) (sizeof(val) <= 4 ? hash_32(val, bits) : hash_64(val, bits))
+
+static inline void __hash_init(struct hlist_head *ht, unsigned int sz)
+{
+	unsigned int i;
+
+	for (i = 0; i < sz; i++)
+		ht[i].first = NULL;
+}
+
+#define hash_init(ht) __hash_init(ht, HASH_SIZE(ht))
+#define hash_add(ht, node, key) hlist_add_head(node, &ht[hash_min(key, HASH_BITS(ht))])
+#define hash_del(node) hlist_del_init(node)
+
+#define hash_for_each(name, bkt, obj, member) \
+	for ((bkt) = 0, obj = NULL; obj == NULL && (bkt) < HASH_SIZE(name); (bkt)++) \
+		hlist_for_each_entry(obj, &name[bkt], member)
+
+#define hash_for_each_safe(name, bkt, tmp, obj, member) \
+	for ((bkt) = 0, obj = NULL; obj == NULL && (bkt) < HASH_SIZE(name); (bkt)++) \
+		hlist_for_each_entry_safe(obj, tmp, &name[bkt], member)
+
+#define hash_for_each_possible(name, obj, member, key) \
+	hlist_for_each_entry(obj, &name[hash_min(key, HASH_BITS(name))], member)
+
+/* jhash, Bob Jenkins' lookup3 as in include/linux/jhash.h */
+#define JHASH_INITVAL 0xdeadbeef
+
+static inline u32 rol32(u32 word, unsigned int shift)
+{
+	return (word << (shift & 31)) | (word >> ((-shift) & 31));
+}
+
+#define __jhash_mix(a, b, c) { \
+	a -= c; a ^= rol32(c, 4); c += b; \
+	b -= a; b ^= rol32(a, 6); a += c; \
+	c -= b; c ^= rol32(b, 8); b += a; \
+	a -= c; a ^= rol32(c, 16); c += b; \
+	b -= a; b ^= rol32(a, 19); a += c; \
+	c -= b; c ^= rol32(b, 4); b += a; \
+}
+
+#define __jhash_final(a, b, c) { \
+	c ^= b; c -= rol32(b, 14); \
+	a ^= c; a -= rol32(c, 11); \
+	b ^= a; b -= rol32(a, 25); \
+	c ^= b; c -= rol32(b, 16); \
+	a ^= c; a -= rol32(c, 4); \
+	b ^= a; b -= rol32(a, 14); \
+	c ^= b; c -= rol32(b, 24); \
+}
+
+static inline u32 jhash(const void *key, u32 length, u32 initval)
+{
+	const u8 *k = key;
+	u32 a, b, c, w[3];
+
+	a = b = c = JHASH_INITVAL + length + initval;
+	while (length > 12) {
+		memcpy(w, k, sizeof(w));
+		a += w[0];
+		b += w[1];
+		c += w[2];
+		__jhash_mix(a, b, c);
+		length -= 12;
+		k += 12;
+	}
+	switch (length) {
+	case 12: c += (u32)k[11] << 24; /* fall through */
+	case 11: c += (u32)k[10] << 16; /* fall through */
+	case 10: c += (u32)k[9] << 8;   /* fall through */
+	case 9:  c += k[8];             /* fall through */
+	case 8:  b += (u32)k[7] << 24;  /* fall through */
+	case 7:  b += (u32)k[6] << 16;  /* fall through */
+	case 6:  b += (u32)k[5] << 8;   /* fall through */
+	case 5:  b += k[4];             /* fall through */
+	case 4:  a += (u32)k[3] << 24;  /* fall through */
+	case 3:  a += (u32)k[2] << 16;  /* fall through */
+	case 2:  a += (u32)k[1] << 8;   /* fall through */
+	case 1:  a += k[0];
+		__jhash_final(a, b, c);
+		break;
+	case 0:
+		break;
+	}
+	return c;
+}
+
+static inline u32 jhash_3words(u32 a, u32 b, u32 c, u32 initval)
+{
+	a += JHASH_INITVAL + initval;
+	b += JHASH_INITVAL + initval;
+	c += JHASH_INITVAL + initval;
+	__jhash_final(a, b, c);
+	return c;
+}
+
+static inline u32 jhash_2words(u32 a, u32 b, u32 initval)
+{
+	return jhash_3words(a, b, 0, initval + (2 << 2));
+}
+
+static inline u32 jhash_1word(u32 a, u32 initval)
+{
+	return jhash_3words(a, 0, 0, initval + (1 << 2));
+}
+
+/* error pointers */
+#define MAX_ERRNO 4095
+#define ERR_PTR(err) ((void *)(long)(err))
+#define PTR_ERR(p) ((long)(p))
+#define IS_ERR(p) ((unsigned long)(p) >= (unsigned long)-MAX_ERRNO)
+
+/* bitops */
+static inline int fls64(u64 x) { return x ? 64 - __builtin_clzll(x) : 0; }
+static inline unsigned long __ffs(unsigned long x) { return __builtin_ctzl(x); }
+
+/* seq_file output goes to a stdio stream */
+struct seq_file {
+	FILE *f;
+};
+void seq_printf(struct seq_file *m, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/* atomics and ordering */
+#define READ_ONCE(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define WRITE_ONCE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define smp_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define smp_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define cmpxchg(p, o, n) \
+	({ typeof(*(p)) __old = (o); \
+	   __atomic_compare_exchange_n((p), &__old, (n), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+	   __old; })
+#define xchg(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+
+/* locking */
+struct mutex {
+	pthread_mutex_t m;
+};
+#define DEFINE_MUTEX(name) struct mutex name = { PTHREAD_MUTEX_INITIALIZER }
+#define mutex_lock(x) pthread_mutex_lock(&(x)->m)
+#define mutex_unlock(x) pthread_mutex_unlock(&(x)->m)
+
+/* RCU readers and rename_lock, dentries are never renamed under a lookup */
+#define rcu_read_lock() do { } while (0)
+#define rcu_read_unlock() do { } while (0)
+
+typedef struct {
+	unsigned int seq;
+} seqlock_t;
+static inline unsigned int read_seqbegin(const seqlock_t *s) { return s->seq; }
+static inline int read_seqretry(const seqlock_t *s, unsigned int seq) { return s->seq != seq; }
+
+/* dentries, only the name and the parent are used */
+struct qstr {
+	u32 hash;
+	u32 len;
+	const unsigned char *name;
+};
+struct dentry {
+	struct dentry *d_parent;
+	struct qstr d_name;
+};
+#define IS_ROOT(d) ((d) == (d)->d_parent)
+extern seqlock_t rename_lock;
+
+struct srcu_struct {
+	int unused;
+};
+#define DEFINE_STATIC_SRCU(name) static struct srcu_struct name
+static inline int srcu_read_lock(struct srcu_struct *s) { return 0; }
+static inline void srcu_read_unlock(struct srcu_struct *s, int idx) { }
+static inline void synchronize_srcu(struct srcu_struct *s) { }
+
+/* workqueues, the periodic passes of the engines are left to the kernel */
+struct work_struct {
+	int unused;
+};
+struct delayed_work {
+	struct work_struct work;
+	void (*func)(struct work_struct *);
+};
+#define DECLARE_DELAYED_WORK(name, fn) struct delayed_work name = { .func = (fn) }
+static inline int schedule_delayed_work(struct delayed_work *w, unsigned long delay) { return 1; }
+static inline int cancel_delayed_work_sync(struct delayed_work *w) { return 0; }
+
+/* per-cpu data is a single copy shared by all threads */
+#define for_each_possible_cpu(cpu) for ((cpu) = 0; (cpu) < 1; (cpu)++)
+#define num_possible_cpus() 1
+#define nr_cpu_ids 1
+#define get_cpu() 0
+#define put_cpu() do { } while (0)
+#define per_cpu_ptr(ptr, cpu) ((void)(cpu), (ptr))
+#define this_cpu_ptr(ptr) (ptr)
+#define this_cpu_inc(x) __atomic_fetch_add(&(x), 1, __ATOMIC_RELAXED)
+#define this_cpu_add(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define alloc_percpu(type) ((type *)calloc(1, sizeof(type)))
+#define __alloc_percpu(size, align) calloc(1, (size))
+#define free_percpu(p) free(p)
+
+#endif /* _ABAC_KERNEL_SHIM_H */